@@ -0,0 +1,151 @@
+"""
+Benchmarks for the paths through which data enters and leaves dynd arrays
+from Python. These don't plot anything, and are meant to be run through
+benchsuite.py, which writes their results as JSON.
+"""
+
+import numpy as np
+
+from dynd import nd, ndt
+
+from benchrun import Benchmark, median
+from benchtime import Timer
+
+size = [10, 1000, 100000]
+
+def make_values(dtype, size):
+  if dtype == 'bool':
+    return [i % 3 == 0 for i in range(size)]
+  elif dtype == 'int64':
+    return list(range(size))
+  elif dtype == 'float64':
+    return [i * 0.5 for i in range(size)]
+  elif dtype == 'string':
+    return ['value %d' % i for i in range(size)]
+
+  raise ValueError('no values for dtype %r' % dtype)
+
+def make_records(size):
+  return [{'id': i, 'score': i * 0.5, 'name': 'record %d' % i} for i in range(size)]
+
+class ListToArrayBenchmark(Benchmark):
+  """nd.array from a flat Python list"""
+  parameters = ('dtype', 'size')
+  dtype = ['bool', 'int64', 'float64', 'string']
+  size = size
+
+  @median
+  def run(self, dtype, size):
+    values = make_values(dtype, size)
+
+    with Timer() as timer:
+      nd.array(values)
+
+    return timer.elapsed_time()
+
+class RecordsToStructBenchmark(Benchmark):
+  """nd.array from a list of dicts into a struct type"""
+  parameters = ('size',)
+  size = size
+
+  @median
+  def run(self, size):
+    values = make_records(size)
+    tp = ndt.type('{} * {{id: int64, score: float64, name: string}}'.format(size))
+
+    with Timer() as timer:
+      nd.array(values, type = tp)
+
+    return timer.elapsed_time()
+
+class AsPyBenchmark(Benchmark):
+  """nd.as_py of a flat array"""
+  parameters = ('dtype', 'size')
+  dtype = ['bool', 'int64', 'float64', 'string']
+  size = size
+
+  @median
+  def run(self, dtype, size):
+    a = nd.array(make_values(dtype, size))
+
+    with Timer() as timer:
+      nd.as_py(a)
+
+    return timer.elapsed_time()
+
+class NumPyInteropBenchmark(Benchmark):
+  """NumPy to dynd as a view (nd.view, nd.asarray) or a copy (nd.array)"""
+  parameters = ('mode', 'size')
+  mode = ['view', 'asarray', 'array']
+  size = size + [10000000]
+
+  @median
+  def run(self, mode, size):
+    a = np.arange(size, dtype = np.float64)
+
+    with Timer() as timer:
+      if mode == 'view':
+        nd.view(a)
+      elif mode == 'asarray':
+        nd.asarray(a)
+      else:
+        nd.array(a)
+
+    return timer.elapsed_time()
+
+class PEP3118Benchmark(Benchmark):
+  """Exporting a dynd array through the buffer protocol"""
+  parameters = ('dtype', 'size')
+  dtype = ['int64', 'float64']
+  size = size
+
+  @median
+  def run(self, dtype, size):
+    a = nd.array(make_values(dtype, size))
+
+    with Timer() as timer:
+      np.asarray(memoryview(a))
+
+    return timer.elapsed_time()
+
+class CallableDispatchBenchmark(Benchmark):
+  """Average time of one call to nd.add on Python floats, dynd scalars or 1000 element arrays"""
+  parameters = ('args',)
+  args = ['python', 'scalar', 'array']
+
+  ncalls = 1000
+
+  @median
+  def run(self, args):
+    if args == 'python':
+      a, b = 1.5, 2.5
+    elif args == 'scalar':
+      a, b = nd.array(1.5), nd.array(2.5)
+    else:
+      a = nd.array(make_values('float64', 1000))
+      b = nd.array(make_values('float64', 1000))
+
+    with Timer() as timer:
+      for i in range(self.ncalls):
+        nd.add(a, b)
+
+    return timer.elapsed_time() / self.ncalls
+
+class ThreadScalingBenchmark(Benchmark):
+  """a.sum(nthreads=n) over 10 million float64 values"""
+  parameters = ('nthreads',)
+  nthreads = [1, 2, 4, 8]
+
+  def __init__(self):
+    Benchmark.__init__(self)
+    self.a = nd.array(np.random.uniform(size = 10000000))
+
+  @median
+  def run(self, nthreads):
+    with Timer() as timer:
+      self.a.sum(nthreads = nthreads)
+
+    return timer.elapsed_time()
+
+benchmarks = [ListToArrayBenchmark, RecordsToStructBenchmark, AsPyBenchmark, NumPyInteropBenchmark,
+              PEP3118Benchmark, CallableDispatchBenchmark, ThreadScalingBenchmark]
@@ -0,0 +1,372 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// Microbenchmarks for the pydynd kernels. This embeds CPython, builds
+// each kernel directly with a kernel_builder, and times its single and
+// strided entry points over contiguous and strided buffers, so the kernel
+// cost isn't hidden behind the overhead of calling in from Python.
+//
+// The apply_pyobject_kernel benchmark wraps its arguments as dynd arrays,
+// so dynd has to be importable, e.g. by running from an in-place build
+// with PYTHONPATH pointing at the source tree.
+//
+//     pydynd_benchmark_kernels [-n SIZE] [-r REPEAT] [FILTER]
+//
+
+#include <Python.h>
+#include <datetime.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dynd/functional.hpp>
+#include <dynd/kernels/kernel_builder.hpp>
+#include <dynd/kernels/tuple_assignment_kernels.hpp>
+#include <dynd/type.hpp>
+
+#include "assign.hpp"
+#include "callables/assign_from_pyobject_callable.hpp"
+#include "callables/assign_to_pyobject_callable.hpp"
+#include "copy_from_numpy_arrfunc.hpp"
+#include "init.hpp"
+#include "kernels/apply_pyobject_kernel.hpp"
+
+using namespace std;
+
+namespace {
+
+struct options {
+  intptr_t size = 100000;
+  int repeat = 7;
+  string filter;
+};
+
+/**
+ * A buffer of `count` elements of `element_size` bytes, laid out `spacing`
+ * elements apart, so a spacing of 1 is contiguous and 2 touches every
+ * other element.
+ */
+struct buffer {
+  vector<char> storage;
+  intptr_t stride;
+
+  buffer(intptr_t count, size_t element_size, intptr_t spacing)
+      : storage(count * element_size * spacing), stride(element_size * spacing)
+  {
+  }
+
+  char *at(intptr_t i) { return storage.data() + i * stride; }
+};
+
+/**
+ * Returns the best time per element in nanoseconds over `repeat` runs
+ * of `func`, which processes `count` elements.
+ */
+double time_per_element(const options &opts, intptr_t count, const function<void()> &func)
+{
+  double best = numeric_limits<double>::max();
+  for (int i = 0; i < opts.repeat; ++i) {
+    auto start = chrono::steady_clock::now();
+    func();
+    auto stop = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, nano>(stop - start).count() / count);
+  }
+
+  return best;
+}
+
+void report(const string &kernel, const string &mode, const string &layout, intptr_t count, double ns)
+{
+  cout.setf(ios::fixed);
+  cout.precision(2);
+  cout << left;
+  cout.width(48);
+  cout << kernel;
+  cout.width(10);
+  cout << mode;
+  cout.width(12);
+  cout << layout;
+  cout << right;
+  cout.width(10);
+  cout << count;
+  cout.width(12);
+  cout << ns << endl;
+}
+
+/**
+ * Times the single entry point called once per element and the strided
+ * entry point called once over all elements, for the kernel produced by
+ * `build`. `init_src` fills the source element for an index, or releases
+ * it for an index of -1, and `clear_dst` releases what the kernel left in
+ * a destination element.
+ */
+void time_kernel(const options &opts, const string &kernel, size_t dst_size, size_t src_size,
+                 const function<void(dynd::nd::kernel_builder &, dynd::kernel_request_t)> &build,
+                 const function<void(char *, intptr_t)> &init_src, const function<void(char *)> &clear_dst)
+{
+  if (kernel.find(opts.filter) == string::npos) {
+    return;
+  }
+
+  static const char *layouts[2] = {"contiguous", "strided"};
+  for (int spacing = 1; spacing <= 2; ++spacing) {
+    intptr_t count = opts.size;
+    buffer dst(count, dst_size, spacing);
+    buffer src(count, src_size, spacing);
+    for (intptr_t i = 0; i < count; ++i) {
+      init_src(src.at(i), i);
+    }
+    auto clear = [&]() {
+      for (intptr_t i = 0; i < count; ++i) {
+        clear_dst(dst.at(i));
+      }
+    };
+
+    {
+      dynd::nd::kernel_builder kb;
+      build(kb, dynd::kernel_request_single);
+      dynd::nd::kernel_prefix *ck = kb.get();
+      double ns = time_per_element(opts, count, [&]() {
+        for (intptr_t i = 0; i < count; ++i) {
+          char *src_i = src.at(i);
+          ck->single(dst.at(i), &src_i);
+        }
+      });
+      clear();
+      report(kernel, "single", layouts[spacing - 1], count, ns);
+    }
+
+    {
+      dynd::nd::kernel_builder kb;
+      build(kb, dynd::kernel_request_strided);
+      dynd::nd::kernel_prefix *ck = kb.get();
+      char *src_data = src.at(0);
+      double ns = time_per_element(opts, count,
+                                   [&]() { ck->strided(dst.at(0), dst.stride, &src_data, &src.stride, count); });
+      clear();
+      report(kernel, "strided", layouts[spacing - 1], count, ns);
+    }
+
+    for (intptr_t i = 0; i < count; ++i) {
+      init_src(src.at(i), -1);
+    }
+  }
+}
+
+template <typename T>
+void clear_value(char *DYND_UNUSED(dst))
+{
+}
+
+void clear_pyobject(char *dst)
+{
+  Py_XDECREF(*reinterpret_cast<PyObject **>(dst));
+  *reinterpret_cast<PyObject **>(dst) = NULL;
+}
+
+// Sets `src` to a Python object for index `i`, or releases it when `i` is -1
+template <typename T>
+void init_pyobject(char *src, intptr_t i);
+
+template <>
+void init_pyobject<int64_t>(char *src, intptr_t i)
+{
+  clear_pyobject(src);
+  if (i >= 0) {
+    *reinterpret_cast<PyObject **>(src) = PyLong_FromLongLong(i);
+  }
+}
+
+template <>
+void init_pyobject<double>(char *src, intptr_t i)
+{
+  clear_pyobject(src);
+  if (i >= 0) {
+    *reinterpret_cast<PyObject **>(src) = PyFloat_FromDouble(i * 0.5);
+  }
+}
+
+template <>
+void init_pyobject<dynd::string>(char *src, intptr_t i)
+{
+  clear_pyobject(src);
+  if (i >= 0) {
+    stringstream ss;
+    ss << "value " << i;
+    *reinterpret_cast<PyObject **>(src) = PyUnicode_FromString(ss.str().c_str());
+  }
+}
+
+template <typename T>
+void init_value(char *src, intptr_t i)
+{
+  if (i >= 0) {
+    *reinterpret_cast<T *>(src) = static_cast<T>(i);
+  }
+}
+
+template <>
+void init_value<dynd::string>(char *src, intptr_t i)
+{
+  if (i >= 0) {
+    stringstream ss;
+    ss << "value " << i;
+    new (src) dynd::string(ss.str());
+  }
+  else {
+    reinterpret_cast<dynd::string *>(src)->~string();
+  }
+}
+
+template <typename T>
+void benchmark_assign_from_pyobject(const options &opts, const string &name)
+{
+  time_kernel(opts, "assign_from_pyobject_kernel<" + name + ">", sizeof(T), sizeof(PyObject *),
+              [&](dynd::nd::kernel_builder &kb, dynd::kernel_request_t kernreq) {
+                kb.emplace_back<assign_from_pyobject_kernel<T>>(kernreq);
+              },
+              init_pyobject<T>, clear_value<T>);
+}
+
+template <>
+void benchmark_assign_from_pyobject<dynd::string>(const options &opts, const string &name)
+{
+  dynd::ndt::type dst_tp = dynd::ndt::make_type<dynd::ndt::string_type>();
+  time_kernel(opts, "assign_from_pyobject_kernel<" + name + ">", sizeof(dynd::string), sizeof(PyObject *),
+              [&](dynd::nd::kernel_builder &kb, dynd::kernel_request_t kernreq) {
+                kb.emplace_back<assign_from_pyobject_kernel<dynd::string>>(kernreq, dst_tp, nullptr);
+              },
+              init_pyobject<dynd::string>, [](char *dst) { *reinterpret_cast<dynd::string *>(dst) = dynd::string(); });
+}
+
+template <typename KernelType, typename T>
+void benchmark_assign_to_pyobject(const options &opts, const string &name)
+{
+  time_kernel(opts, name, sizeof(PyObject *), sizeof(T),
+              [&](dynd::nd::kernel_builder &kb, dynd::kernel_request_t kernreq) {
+                kb.emplace_back<KernelType>(kernreq);
+              },
+              init_value<T>, clear_pyobject);
+}
+
+void benchmark_apply_pyobject(const options &opts, PyObject *func)
+{
+  dynd::ndt::type proto = dynd::ndt::make_type<dynd::ndt::callable_type>(dynd::ndt::make_type<double>(),
+                                                                         {dynd::ndt::make_type<double>()});
+  time_kernel(opts, "apply_pyobject_kernel<(float64) -> float64>", sizeof(double), sizeof(double),
+              [&](dynd::nd::kernel_builder &kb, dynd::kernel_request_t kernreq) {
+                intptr_t ckb_offset = kb.size();
+                kb.emplace_back<apply_pyobject_kernel>(kernreq);
+                apply_pyobject_kernel *self = kb.get_at<apply_pyobject_kernel>(ckb_offset);
+                self->m_proto = proto;
+                self->m_pyfunc = func;
+                Py_INCREF(self->m_pyfunc);
+                self->m_dst_arrmeta = NULL;
+                self->m_src_arrmeta.resize(1, NULL);
+                kb.emplace_back<assign_from_pyobject_kernel<double>>(dynd::kernel_request_single);
+              },
+              init_value<double>, clear_value<double>);
+}
+
+#if DYND_NUMPY_INTEROP
+void benchmark_copy_from_numpy(const options &opts)
+{
+  const string kernel = "copy_from_numpy<float64>";
+  if (kernel.find(opts.filter) == string::npos) {
+    return;
+  }
+
+  static const char *layouts[2] = {"contiguous", "strided"};
+  for (int spacing = 1; spacing <= 2; ++spacing) {
+    intptr_t count = opts.size;
+    npy_intp dim = count * spacing;
+    pydynd::pyobject_ownref base(PyArray_SimpleNew(1, &dim, NPY_FLOAT64));
+    pydynd::pyobject_ownref step(PySlice_New(NULL, NULL, pydynd::pyobject_ownref(PyLong_FromLong(spacing)).get()));
+    pydynd::pyobject_ownref src(PyObject_GetItem(base.get(), step.get()));
+    dynd::nd::array dst = dynd::nd::empty(dynd::ndt::make_fixed_dim(count, dynd::ndt::make_type<double>()));
+
+    double ns = time_per_element(opts, count, [&]() {
+      pydynd::nd::array_copy_from_numpy(dst.get_type(), dst.get()->metadata(), dst.data(),
+                                        reinterpret_cast<PyArrayObject *>(src.get()),
+                                        &dynd::eval::default_eval_context);
+    });
+    report(kernel, "call", layouts[spacing - 1], count, ns);
+  }
+}
+#endif
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      opts.size = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      opts.repeat = atoi(argv[++i]);
+    }
+    else if (argv[i][0] == '-') {
+      cerr << "usage: " << argv[0] << " [-n SIZE] [-r REPEAT] [FILTER]" << endl;
+      return 2;
+    }
+    else {
+      opts.filter = argv[i];
+    }
+  }
+
+  Py_Initialize();
+  int status = 0;
+  try {
+    pydynd::numpy_interop_init();
+
+    pydynd::pyobject_ownref globals(PyDict_New());
+    PyDict_SetItemString(globals.get(), "__builtins__", PyEval_GetBuiltins());
+    pydynd::pyobject_ownref identity(PyRun_String("lambda x: x", Py_eval_input, globals.get(), globals.get()));
+
+    cout << left;
+    cout.width(48);
+    cout << "kernel";
+    cout.width(10);
+    cout << "mode";
+    cout.width(12);
+    cout << "layout";
+    cout << right;
+    cout.width(10);
+    cout << "count";
+    cout.width(12);
+    cout << "ns/element" << endl;
+
+    benchmark_assign_from_pyobject<int64_t>(opts, "int64");
+    benchmark_assign_from_pyobject<double>(opts, "float64");
+    benchmark_assign_from_pyobject<dynd::string>(opts, "string");
+    benchmark_assign_to_pyobject<assign_to_pyobject_kernel<int64_t>, int64_t>(opts, "assign_to_pyobject_kernel<int64>");
+    benchmark_assign_to_pyobject<assign_to_pyobject_kernel<double>, double>(opts, "assign_to_pyobject_kernel<float64>");
+    benchmark_assign_to_pyobject<string_utf8_assign_kernel, dynd::string>(opts, "string_utf8_assign_kernel");
+#if DYND_NUMPY_INTEROP
+    benchmark_copy_from_numpy(opts);
+#endif
+    benchmark_apply_pyobject(opts, identity.get());
+  }
+  catch (const exception &e) {
+    if (PyErr_Occurred()) {
+      PyErr_Print();
+    }
+    cerr << "error: " << e.what() << endl;
+    status = 1;
+  }
+  Py_Finalize();
+
+  return status;
+}
@@ -153,6 +153,26 @@ class Benchmark:
             print("  ", "   ".join(row))
         print()
 
+    def json_result(self):
+        """Run benchmark for all versions and parameters and return the
+        results as a JSON serializable dict, without printing or plotting.
+        A parameter combination which raises is recorded with its error
+        instead of a time."""
+        results = []
+        for params in self.pcombos:
+            args = dict(zip(self.pnames, params))
+            try:
+                result = {'seconds': self.run(**args)}
+            except Exception as e:
+                result = {'seconds': None, 'error': '%s: %s' % (type(e).__name__, e)}
+            result['params'] = args
+            results.append(result)
+
+        return {'name': self.__class__.__name__,
+                'doc': (self.__doc__ or '').strip(),
+                'parameters': list(self.pnames),
+                'results': results}
+
     def plot_result(self, loglog = False):
         import matplotlib
         import matplotlib.pyplot
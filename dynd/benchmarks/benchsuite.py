@@ -0,0 +1,144 @@
+"""
+Runs benchmarks without any plotting and writes their results as JSON, or
+compares two such result files to find regressions.
+
+    python benchsuite.py run [-o results.json] [-k NAME]
+    python benchsuite.py compare baseline.json results.json [--threshold 0.1]
+
+The compare command exits with status 1 when any benchmark got slower than
+the baseline by more than the threshold, or raised an error in the current
+results, so it can gate a review.
+"""
+
+from __future__ import print_function
+
+import argparse
+import datetime
+import json
+import platform
+import sys
+
+def collect_metadata():
+  import numpy
+  import dynd
+
+  return {'date': datetime.datetime.utcnow().isoformat() + 'Z',
+          'python': platform.python_version(),
+          'platform': platform.platform(),
+          'machine': platform.machine(),
+          'numpy': numpy.__version__,
+          'dynd-python': getattr(dynd, '__version__', None),
+          'libdynd': getattr(dynd, '__libdynd_version__', None)}
+
+def run(args):
+  from benchmark_conversion import benchmarks
+
+  results = []
+  for cls in benchmarks:
+    if args.k and not any(k in cls.__name__ for k in args.k):
+      continue
+    print('running', cls.__name__, file = sys.stderr)
+    results.append(cls().json_result())
+
+  data = {'metadata': collect_metadata(), 'benchmarks': results}
+  if args.output == '-':
+    json.dump(data, sys.stdout, indent = 2, sort_keys = True)
+    print()
+  else:
+    with open(args.output, 'w') as f:
+      json.dump(data, f, indent = 2, sort_keys = True)
+
+  return 0
+
+def flatten(data):
+  times = {}
+  errors = {}
+  for benchmark in data['benchmarks']:
+    for result in benchmark['results']:
+      key = (benchmark['name'], tuple(sorted(result['params'].items())))
+      if result.get('error') is not None:
+        errors[key] = result['error']
+      else:
+        times[key] = result['seconds']
+
+  return times, errors
+
+def format_key(key):
+  name, params = key
+  return '{}({})'.format(name, ', '.join('{}={}'.format(k, v) for k, v in params))
+
+def format_seconds(key, times, errors):
+  if key in errors:
+    return 'error'
+  if key not in times:
+    return '-'
+  return '{:.3e}'.format(times[key])
+
+def compare(args):
+  with open(args.baseline) as f:
+    baseline, baseline_errors = flatten(json.load(f))
+  with open(args.current) as f:
+    current, current_errors = flatten(json.load(f))
+
+  regressions = 0
+  print('{:<60} {:>12} {:>12} {:>8}'.format('benchmark', 'baseline', 'current', 'ratio'))
+  print('-' * 95)
+  keys = set(baseline) | set(baseline_errors) | set(current) | set(current_errors)
+  for key in sorted(keys, key = format_key):
+    if key not in baseline or key not in current:
+      if key in current_errors:
+        status = 'error'
+      elif key not in current:
+        status = 'missing'
+      else:
+        status = 'fixed' if key in baseline_errors else 'new'
+      print('{:<60} {:>12} {:>12} {:>8}'.format(format_key(key), format_seconds(key, baseline, baseline_errors),
+                                                format_seconds(key, current, current_errors), status))
+      continue
+
+    old = baseline[key]
+    new = current[key]
+    ratio = new / old if old > 0 else float('inf')
+    mark = ''
+    if ratio > 1 + args.threshold and new - old > args.min_seconds:
+      mark = '  REGRESSION'
+      regressions += 1
+    elif ratio < 1 / (1 + args.threshold):
+      mark = '  improved'
+    print('{:<60} {:>12.3e} {:>12.3e} {:>8.2f}{}'.format(format_key(key), old, new, ratio, mark))
+
+  print()
+  for key in sorted(current_errors, key = format_key):
+    print('{} raised {}'.format(format_key(key), current_errors[key]))
+  if current_errors:
+    print()
+  print('{} regression(s) beyond {:.0%}, {} error(s)'.format(regressions, args.threshold, len(current_errors)))
+  return 1 if regressions or current_errors else 0
+
+def main(argv = None):
+  parser = argparse.ArgumentParser(description = 'Headless dynd benchmarks')
+  subparsers = parser.add_subparsers(dest = 'command')
+
+  run_parser = subparsers.add_parser('run', help = 'run the benchmarks and write JSON')
+  run_parser.add_argument('-o', '--output', default = '-', help = 'output file, or - for stdout')
+  run_parser.add_argument('-k', action = 'append', help = 'only run benchmarks whose name contains this')
+
+  compare_parser = subparsers.add_parser('compare', help = 'compare results against a baseline')
+  compare_parser.add_argument('baseline')
+  compare_parser.add_argument('current')
+  compare_parser.add_argument('--threshold', type = float, default = 0.1,
+                              help = 'relative slowdown reported as a regression')
+  compare_parser.add_argument('--min-seconds', type = float, default = 1e-6,
+                              help = 'absolute slowdown below which timings are treated as noise')
+
+  args = parser.parse_args(argv)
+  if args.command == 'run':
+    return run(args)
+  elif args.command == 'compare':
+    return compare(args)
+
+  parser.print_help()
+  return 2
+
+if __name__ == '__main__':
+  sys.exit(main())
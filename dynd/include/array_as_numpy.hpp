@@ -22,6 +22,19 @@ namespace pydynd {
  */
 PYDYND_API PyObject *array_as_numpy(PyObject *a_obj, bool allow_copy);
 
+/**
+ * Converts an nd::array of fixed dimensions of strings into a NumPy array
+ * of fixed width or variable width strings, without creating a Python
+ * object per string.
+ *
+ * \param a_obj  A WArray containing the nd::array to convert.
+ * \param kind  'U' for UCS4 strings as wide as the string with the most
+ *              code points, 'S' for the UTF-8 bytes, as wide as the
+ *              longest encoding, or 'T' for the StringDType of NumPy 2,
+ *              which NumPy casts from the 'U' array.
+ */
+PYDYND_API PyObject *array_strings_as_numpy(PyObject *a_obj, char kind);
+
 } // namespace pydynd
 
 #endif // _DYND__NDARRAY_AS_NUMPY_HPP_
@@ -0,0 +1,45 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the dictionary encoding of the strings of Python
+// objects into categorical types as they are converted to an nd::array.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Converts a Python object into an nd::array of type `tp`, like assigning
+ * it to `nd::empty(tp)`, except that every string of `tp` outside of an
+ * option becomes a categorical type of the distinct strings at that place,
+ * e.g. a field of a struct, and the array holds their integer codes. No
+ * string is allocated per value, each one is interned in a table of the
+ * categories by its Python hash, and its code is written to the array in
+ * the same walk through `obj`.
+ *
+ * The categories are sorted, so the codes compare like the strings. A
+ * string of `tp` stays a string if it has more than `max_categories`
+ * distinct values, or any value which isn't a Python string. If `obj`
+ * doesn't have the shape of `tp`, e.g. a value to broadcast, nothing is
+ * encoded.
+ *
+ * \param obj  The Python object, nested lists, tuples and dicts like
+ *             nd.array takes.
+ * \param tp  The type of the result before the encoding, as deduced from
+ *            `obj` or given.
+ * \param max_categories  The largest number of categories of a string.
+ *
+ * \returns  The array, or a null array if no string was encoded.
+ */
+PYDYND_API dynd::nd::array array_from_py_categorical(PyObject *obj, const dynd::ndt::type &tp,
+                                                     intptr_t max_categories);
+
+} // namespace pydynd
@@ -0,0 +1,47 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines how the exporters walk the fixed and var dimensions
+// of an array in its arrmeta and data.
+//
+
+#pragma once
+
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+namespace pydynd {
+
+/**
+ * Finds the size and the elements of a fixed or var dimension, moving
+ * `data` to its first element. Returns false, changing nothing, if `tp`
+ * is neither.
+ */
+inline bool dim_elements(const dynd::ndt::type &tp, const char *arrmeta, const char *&data, intptr_t &size,
+                         intptr_t &stride, const char *&el_arrmeta)
+{
+  switch (tp.get_id()) {
+  case dynd::fixed_dim_id: {
+    const dynd::fixed_dim_type_arrmeta *md = reinterpret_cast<const dynd::fixed_dim_type_arrmeta *>(arrmeta);
+    size = md->dim_size;
+    stride = md->stride;
+    el_arrmeta = arrmeta + sizeof(dynd::fixed_dim_type_arrmeta);
+    return true;
+  }
+  case dynd::var_dim_id: {
+    const dynd::ndt::var_dim_type::metadata_type *md =
+        reinterpret_cast<const dynd::ndt::var_dim_type::metadata_type *>(arrmeta);
+    const dynd::ndt::var_dim_type::data_type *vdd = reinterpret_cast<const dynd::ndt::var_dim_type::data_type *>(data);
+    size = vdd->size;
+    stride = md->stride;
+    data = vdd->begin + md->offset;
+    el_arrmeta = arrmeta + sizeof(dynd::ndt::var_dim_type::metadata_type);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+} // namespace pydynd
@@ -0,0 +1,102 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the exchange of strided arrays with other libraries
+// through DLPack capsules, as for `__dlpack__` and `from_dlpack`.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <cstdint>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+// The structs of DLPack 1.0, as specified in dlpack.h
+#ifndef DLPACK_DLPACK_H_
+#define DLPACK_DLPACK_H_
+
+#define DLPACK_MAJOR_VERSION 1
+#define DLPACK_MINOR_VERSION 0
+
+#define DLPACK_FLAG_BITMASK_READ_ONLY (1UL << 0UL)
+#define DLPACK_FLAG_BITMASK_IS_COPIED (1UL << 1UL)
+
+extern "C" {
+
+typedef struct {
+  uint32_t major;
+  uint32_t minor;
+} DLPackVersion;
+
+typedef enum { kDLCPU = 1 } DLDeviceType;
+
+typedef struct {
+  DLDeviceType device_type;
+  int32_t device_id;
+} DLDevice;
+
+typedef enum { kDLInt = 0, kDLUInt = 1, kDLFloat = 2, kDLComplex = 5, kDLBool = 6 } DLDataTypeCode;
+
+typedef struct {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+} DLDataType;
+
+typedef struct {
+  void *data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t *shape;
+  int64_t *strides;
+  uint64_t byte_offset;
+} DLTensor;
+
+typedef struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void *manager_ctx;
+  void (*deleter)(struct DLManagedTensor *self);
+} DLManagedTensor;
+
+typedef struct DLManagedTensorVersioned {
+  DLPackVersion version;
+  void *manager_ctx;
+  void (*deleter)(struct DLManagedTensorVersioned *self);
+  uint64_t flags;
+  DLTensor dl_tensor;
+} DLManagedTensorVersioned;
+
+} // extern "C"
+
+#endif // DLPACK_DLPACK_H_
+
+namespace pydynd {
+
+/**
+ * Exports `a` as a DLPack tensor in a "dltensor" capsule, or in a
+ * "dltensor_versioned" capsule with `versioned`, as for `__dlpack__`.
+ * The tensor views the data of `a`, whose fixed dimension strides are
+ * given in elements, and keeps it alive until the consumer deletes it.
+ *
+ * \param a  An array of fixed dimensions of a builtin numeric type,
+ *           whose strides are multiples of its element size.
+ * \param versioned  Whether to export a DLPack 1.0 tensor, which may be
+ *                   read-only. Read-only arrays can't be exported without.
+ * \param copy  Whether to export a copy of `a` instead.
+ */
+PYDYND_API PyObject *array_to_dlpack(const dynd::nd::array &a, bool versioned, bool copy);
+
+/**
+ * Views the CPU tensor of a "dltensor" or "dltensor_versioned" capsule as
+ * an array, as for `from_dlpack`. The capsule is marked as used, and the
+ * tensor is deleted when the last view of it goes away.
+ */
+PYDYND_API dynd::nd::array array_from_dlpack(PyObject *capsule);
+
+} // namespace pydynd
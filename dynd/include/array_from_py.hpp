@@ -31,6 +31,17 @@ namespace pydynd {
  */
 PYDYND_API dynd::nd::array array_from_py(PyObject *obj, uint32_t access_flags, bool always_copy);
 
+/**
+ * Converts a Python bool, int, float or complex into a writable scalar
+ * nd::array of the type `xtype_for_prefix` deduces for it, writing the
+ * value directly instead of going through the pyobject assignment kernels.
+ * Any other object, including subclasses of those types, gives a null
+ * nd::array.
+ *
+ * \param obj  The PyObject to convert to an nd::array.
+ */
+PYDYND_API dynd::nd::array array_from_pyscalar(PyObject *obj);
+
 void init_array_from_py();
 
 } // namespace pydynd
@@ -27,6 +27,7 @@
 #include "array_as_pep3118.hpp"
 #include "array_conversions.hpp"
 #include "array_from_py.hpp"
+#include "json_lines.hpp"
 #include "type_functions.hpp"
 #include "types/pyobject_type.hpp"
 #include "utility_functions.hpp"
@@ -417,12 +418,14 @@ inline const char *array_access_flags_string(const dynd::nd::array &n)
 
 inline dynd::nd::array dynd_parse_json_type(const dynd::ndt::type &tp, const dynd::nd::array &json, PyObject *ectx_obj)
 {
-  return dynd::parse_json(tp, json, &dynd::eval::default_eval_context);
+  dynd::eval::eval_context ectx = eval_context_from_pyobject(ectx_obj);
+  return dynd::parse_json(tp, json, &ectx);
 }
 
 inline void dynd_parse_json_array(dynd::nd::array &out, const dynd::nd::array &json, PyObject *ectx_obj)
 {
-  dynd::parse_json(out, json, &dynd::eval::default_eval_context);
+  dynd::eval::eval_context ectx = eval_context_from_pyobject(ectx_obj);
+  dynd::parse_json(out, json, &ectx);
 }
 
 } // namespace pydynd
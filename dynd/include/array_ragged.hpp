@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the conversion of a var dimension to and from the
+// flat layout of its values and offsets, which other libraries use for
+// ragged arrays, and to a dense padded array.
+//
+
+#pragma once
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Splits an array of type "N * var * T" into the values of its var
+ * dimension, of type "M * T" where M is the total number of values, and
+ * the N + 1 int64 offsets of the elements into them.
+ *
+ * The values are a view when the elements follow each other in memory,
+ * and are compacted into a new array otherwise.
+ *
+ * \param a  An array of a fixed dimension of a var dimension of builtin
+ *           types or fixed dimensions of them.
+ * \param out_values  Is set to the values.
+ * \param out_offsets  Is set to the offsets.
+ */
+PYDYND_API void array_to_ragged(const dynd::nd::array &a, dynd::nd::array &out_values,
+                                dynd::nd::array &out_offsets);
+
+/**
+ * Views `values` as an array of type "N * var * T", whose elements are the
+ * ranges between consecutive `offsets` into its outermost dimension. Only
+ * the begin and size of each element is stored, the values aren't copied.
+ *
+ * \param values  An array of type "M * T", where T is a builtin type or
+ *                fixed dimensions of one.
+ * \param offsets  A one dimensional array of N + 1 nondecreasing integer
+ *                 offsets, between 0 and M.
+ */
+PYDYND_API dynd::nd::array array_from_ragged(const dynd::nd::array &values, const dynd::nd::array &offsets);
+
+/**
+ * Copies an array of type "N * var * T" into a dense array of type
+ * "N * maxlen * T", whose rows are padded with `fill` after or, with
+ * `align_right`, before the values of the elements.
+ *
+ * \param a  An array of a fixed dimension of a var dimension of builtin
+ *           types or fixed dimensions of them.
+ * \param fill  The value of the padding, assigned to every value of T.
+ * \param maxlen  The length of the rows, or -1 for the length of the longest
+ *                element, which is found in a pass over the elements before
+ *                they are copied. Longer elements are truncated.
+ * \param align_right  Whether to put the values at the end of the rows.
+ * \param truncate_start  Whether to drop the first values of elements
+ *                        longer than `maxlen`, instead of the last ones.
+ * \param out_mask  If not NULL, is set to an "N * maxlen * bool" array which
+ *                  is true where the result holds a value of `a`.
+ */
+PYDYND_API dynd::nd::array array_to_padded(const dynd::nd::array &a, const dynd::nd::array &fill, intptr_t maxlen,
+                                           bool align_right, bool truncate_start, dynd::nd::array *out_mask);
+
+} // namespace pydynd
@@ -0,0 +1,128 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the exchange of arrays with Arrow based libraries
+// through the Arrow C Data Interface, and its Python capsules.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <cstdint>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+// The structs of the Arrow C Data Interface, as specified by Arrow
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+  const char *format;
+  const char *name;
+  const char *metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema **children;
+  struct ArrowSchema *dictionary;
+  void (*release)(struct ArrowSchema *);
+  void *private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void **buffers;
+  struct ArrowArray **children;
+  struct ArrowArray *dictionary;
+  void (*release)(struct ArrowArray *);
+  void *private_data;
+};
+
+} // extern "C"
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace pydynd {
+
+/**
+ * Returns the dynd type of the values described by an Arrow schema.
+ * Booleans, integers and float32/float64 map to the same dynd types,
+ * strings and large strings to string, lists and large lists to var
+ * dimensions, fixed size lists to fixed dimensions and structs to
+ * structs. Nullable scalars are options.
+ */
+PYDYND_API dynd::ndt::type type_from_arrow(const ArrowSchema *schema);
+
+/**
+ * Exports `tp` as an Arrow schema, the inverse of `type_from_arrow`.
+ * Options are nullable, strings are large strings and var dimensions
+ * are large lists.
+ *
+ * \param tp  The type of the values.
+ * \param schema  The uninitialized schema, which the caller must release.
+ */
+PYDYND_API void type_to_arrow(const dynd::ndt::type &tp, ArrowSchema *schema);
+
+/**
+ * Imports an Arrow array as a one dimensional dynd array, taking over
+ * `array`, which is marked released.
+ *
+ * Arrays of numbers without nulls, and lists and fixed size lists of
+ * them, are viewed without copying, keeping the Arrow array alive until
+ * the view goes away. Other arrays are copied. Values whose validity
+ * bit is clear are unavailable in an option type, so a scalar column has
+ * an option type exactly when it holds nulls.
+ *
+ * \param schema  The schema of `array`, which is only read.
+ * \param array  The array to take over.
+ */
+PYDYND_API dynd::nd::array array_from_arrow(const ArrowSchema *schema, ArrowArray *array);
+
+/**
+ * Exports the elements of the outermost dimension of `a` as an Arrow
+ * array of type `type_to_arrow(element type)`. A contiguous dimension of
+ * numbers is exported without copying, keeping `a` alive until the Arrow
+ * array is released, and other data is copied into Arrow's layout.
+ *
+ * \param a  The array, with a fixed or var outermost dimension.
+ * \param array  The uninitialized array, which the caller must release.
+ */
+PYDYND_API void array_to_arrow(const dynd::nd::array &a, ArrowArray *array);
+
+/**
+ * Returns an "arrow_schema" capsule of the element type of `a`, as for
+ * `__arrow_c_schema__`.
+ */
+PYDYND_API PyObject *array_arrow_schema_capsule(const dynd::nd::array &a);
+
+/**
+ * Returns the tuple of "arrow_schema" and "arrow_array" capsules of `a`,
+ * as for `__arrow_c_array__`.
+ *
+ * \param a  The array, with a fixed or var outermost dimension.
+ * \param requested_schema  None, or an "arrow_schema" capsule of the
+ *                          type the elements are converted to first.
+ */
+PYDYND_API PyObject *array_arrow_capsules(const dynd::nd::array &a, PyObject *requested_schema);
+
+/**
+ * Imports the array in an "arrow_array" capsule, with the schema in an
+ * "arrow_schema" capsule, as `array_from_arrow` does. The array capsule
+ * is consumed, and can't be imported again.
+ */
+PYDYND_API dynd::nd::array array_from_arrow_capsules(PyObject *schema_capsule, PyObject *array_capsule);
+
+} // namespace pydynd
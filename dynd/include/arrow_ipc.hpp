@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the reading of Arrow IPC files, also known as
+// Feather v2 files, by viewing their columns in the memory mapped file.
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+// The schema and the record batches of a file, defined in arrow_ipc.cpp
+struct arrow_ipc_layout;
+
+/**
+ * Reads the columns of an uncompressed Arrow IPC file. The file is memory
+ * mapped, and the flatbuffers of its footer, schema and record batch
+ * metadata are parsed in place when it is opened.
+ *
+ * Each column of a record batch is imported like an Arrow C Data Interface
+ * array, as by `array_from_arrow`, over the buffers in the mapping. So
+ * numbers without nulls, and lists and fixed size lists of them, are
+ * views of the file that keep it mapped, while booleans, strings, structs
+ * and columns with nulls are copied out of it.
+ */
+class PYDYND_API arrow_ipc_reader {
+  // The bytes of the mapped file
+  dynd::nd::array m_bytes;
+  std::shared_ptr<const arrow_ipc_layout> m_layout;
+
+public:
+  /**
+   * Maps and parses the file at `path`, in the filesystem encoding.
+   */
+  explicit arrow_ipc_reader(const std::string &path);
+
+  intptr_t get_batch_count() const;
+
+  intptr_t get_column_count() const;
+
+  const std::string &get_column_name(intptr_t i) const;
+
+  /**
+   * The type of the values of column `i` according to the schema, where
+   * the nullable scalars are options.
+   */
+  dynd::ndt::type get_column_type(intptr_t i) const;
+
+  /**
+   * Reads column `i` of record batch `batch` as a one dimensional array.
+   * With `batch` equal to -1, the column of all the record batches is read,
+   * which is a view when the file holds a single record batch and is
+   * otherwise copied into one array.
+   */
+  dynd::nd::array read_column(intptr_t i, intptr_t batch) const;
+};
+
+} // namespace pydynd
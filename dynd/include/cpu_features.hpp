@@ -0,0 +1,95 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the helpers shared by the SIMD kernels, which pick
+// their instruction set when they are first called.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PYDYND_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define PYDYND_X86 0
+#endif
+
+// Marks a function which uses AVX2 intrinsics, so it compiles without
+// -mavx2 and is only called after checking cpu_has_avx2()
+#if defined(_MSC_VER) || !defined(__GNUC__)
+#define PYDYND_TARGET_AVX2
+#else
+#define PYDYND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace pydynd {
+
+/**
+ * Returns the index of the lowest set bit of `x`, which must not be 0.
+ */
+inline int count_trailing_zeros(uint32_t x)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return static_cast<int>(index);
+#elif defined(__GNUC__)
+  return __builtin_ctz(x);
+#else
+  int n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline int count_trailing_zeros(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return static_cast<int>(index);
+#elif defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+#if PYDYND_X86
+
+/**
+ * Returns true if the CPU, and the OS, support AVX2.
+ */
+inline bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // The OS must save the AVX registers on context switches
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+} // namespace pydynd
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the parsing of CSV and TSV text straight into struct
+// arrays, and the discovery of their row type.
+//
+
+#pragma once
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * The format of delimited text. Fields are separated by `delimiter`, and a
+ * field enclosed in `quote` characters may hold delimiters, newlines and
+ * doubled quote characters, which stand for one.
+ */
+struct csv_dialect {
+  char delimiter;
+  char quote;
+  // Whether the first row holds the column names
+  bool header;
+};
+
+/**
+ * Discovers the row type of the CSV text in [begin, end) from its first
+ * `sample_rows` rows. Each column is the first of int64, float64, bool
+ * and string which holds all of its sampled values, and an option if any
+ * of them is empty. The fields are named after the header, or "f0", "f1",
+ * and so on without one.
+ */
+PYDYND_API dynd::ndt::type discover_csv(const char *begin, const char *end, const csv_dialect &dialect,
+                                        intptr_t sample_rows);
+
+/**
+ * Parses the CSV text in [begin, end) into an array of type "N * tp",
+ * where N is the number of rows which aren't blank.
+ *
+ * The text is split into chunks at the row boundaries, found with the
+ * quotes accounted for, and the chunks are parsed on up to `nthreads`
+ * threads straight into the result. This doesn't touch Python, so it may
+ * be called without the GIL.
+ *
+ * \param tp  The row type, a struct whose fields are booleans, numbers or
+ *            strings, or options of them. Empty fields are unavailable in
+ *            options, and empty strings in strings.
+ * \param dialect  The format of the text. With a header, the columns are
+ *                 matched to the fields by name, and columns without a
+ *                 field are skipped. Otherwise they are matched in order.
+ * \param nthreads  The number of threads to parse on.
+ */
+PYDYND_API dynd::nd::array parse_csv(const dynd::ndt::type &tp, const char *begin, const char *end,
+                                     const csv_dialect &dialect, intptr_t nthreads);
+
+} // namespace pydynd
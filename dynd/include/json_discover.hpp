@@ -0,0 +1,75 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the discovery of a dynd type for JSON values, which
+// scans the text and merges the shapes of the values it sees without
+// building them.
+//
+
+#pragma once
+
+#include <memory>
+
+#include <dynd/type.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Discovers the type of a stream of JSON values, fed to it a chunk of
+ * newline delimited rows at a time, by merging the shapes of the rows:
+ *
+ *  - Integers are int64, and become float64 once a row has a number with
+ *    a fraction or an exponent, or one that doesn't fit in an int64.
+ *  - Lists are var dimensions of the merged type of all their elements.
+ *  - Objects are structs with the fields of all the objects, in the order
+ *    they were first seen.
+ *  - Scalars which are null in some rows, or fields which are missing from
+ *    some objects, are options.
+ *
+ * Values of incompatible kinds at the same place, e.g. a string and a
+ * number, raise a type_error, like lists and objects which are null or
+ * missing in some rows, since dynd only has options of scalars.
+ */
+class PYDYND_API json_type_discoverer {
+public:
+  // The merged shape of the values seen at one place in the values
+  struct shape;
+
+private:
+  std::unique_ptr<shape> m_root;
+  intptr_t m_nrows;
+
+public:
+  json_type_discoverer();
+  ~json_type_discoverer();
+
+  /**
+   * Merges the JSON values on the lines in [begin, end), skipping blank
+   * lines. This doesn't touch Python, so it may be called without the GIL.
+   */
+  void add_lines(const char *begin, const char *end);
+
+  /**
+   * Merges the single JSON value in [begin, end). If it is a list and
+   * `max_elements` isn't negative, only its first `max_elements` elements
+   * are scanned, and the rest of the text is neither scanned nor checked.
+   * This doesn't touch Python, so it may be called without the GIL.
+   */
+  void add_value(const char *begin, const char *end, intptr_t max_elements = -1);
+
+  /**
+   * The number of values merged so far.
+   */
+  intptr_t get_count() const { return m_nrows; }
+
+  /**
+   * The type of the values merged so far. Raises an error if there were
+   * none.
+   */
+  dynd::ndt::type get() const;
+};
+
+} // namespace pydynd
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the formatting of dynd arrays as JSON, straight
+// from their data and arrmeta into a UTF-8 buffer.
+//
+
+#pragma once
+
+#include <string>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Appends the JSON text of `a` to `out`. Dimensions are lists, structs
+ * are objects, tuples are lists, unavailable options are null, and so
+ * are the floating point values JSON has no numbers for (NaN and the
+ * infinities). Floating point values are written with the fewest digits
+ * that read back as the same value, like Python's repr, in any locale.
+ *
+ * This doesn't touch Python, so it may be called without the GIL.
+ *
+ * \param a  The array. Its type may consist of fixed and var dimensions,
+ *           structs, tuples, options, strings, booleans, integers up to 64
+ *           bits and float32/float64.
+ * \param out  The buffer the UTF-8 text is appended to.
+ */
+PYDYND_API void format_json(const dynd::nd::array &a, std::string &out);
+
+/**
+ * Appends the JSON text of the elements [begin, end) of the outermost
+ * dimension of `a` to `out`, each followed by `separator`, so that a
+ * large array can be written a chunk of rows at a time.
+ *
+ * \param a  The array, with a fixed or var outermost dimension.
+ * \param begin  The first element.
+ * \param end  One past the last element, at most the size of the dimension.
+ * \param separator  The text written after each element, e.g. ",".
+ * \param out  The buffer the UTF-8 text is appended to.
+ */
+PYDYND_API void format_json_rows(const dynd::nd::array &a, intptr_t begin, intptr_t end,
+                                 const std::string &separator, std::string &out);
+
+} // namespace pydynd
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the structural index of a JSON text, which records
+// where its structural characters are so that a parser can jump from one
+// to the next instead of examining every byte.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Appends to `out` the offsets from `begin` of the structural characters
+ * in [begin, end): the quotes delimiting strings, and the characters
+ * '{', '}', '[', ']', ':' and ',' outside of strings. Escaped quotes
+ * inside strings are not structural.
+ *
+ * The text is classified 64 bytes at a time, with AVX2 or SSE2 when the
+ * CPU supports them, and with a portable scalar loop otherwise.
+ *
+ * \param begin  The start of the text, which must start outside a string.
+ * \param end  The end of the text, at most 4 GB after `begin`.
+ * \param out  The vector the offsets are appended to, in increasing order.
+ */
+PYDYND_API void json_structural_index(const char *begin, const char *end, std::vector<uint32_t> &out);
+
+/**
+ * The name of the implementation `json_structural_index` uses on this CPU,
+ * one of "avx2", "sse2" or "scalar".
+ */
+PYDYND_API const char *json_structural_index_backend();
+
+/**
+ * Overrides the implementation used by `json_structural_index`, mainly for
+ * testing. An empty `name` restores the one selected for the CPU. Raises
+ * an error if the named implementation isn't available.
+ */
+PYDYND_API void set_json_structural_index_backend(const std::string &name);
+
+} // namespace pydynd
@@ -0,0 +1,68 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the parsing of newline delimited JSON in chunks of
+// rows, and the conversion of Python evaluation context arguments.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+#include <dynd/eval/eval_context.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Converts the `ectx` argument of functions like nd.parse_json. None is
+ * the default evaluation context, and a dict overrides its fields, e.g.
+ * {'errmode': 'overflow'}.
+ */
+PYDYND_API dynd::eval::eval_context eval_context_from_pyobject(PyObject *ectx_obj);
+
+/**
+ * Parses the JSON values on the lines in [begin, end) into an array of
+ * type "N * tp", where N is the number of lines which aren't blank.
+ *
+ * When `tp` is a struct of booleans, numbers and strings, the rows are
+ * parsed directly into the result through the structural index of
+ * json_index.hpp, split into blocks of rows parsed on up to `nthreads`
+ * threads. Any row that doesn't fit, e.g. one with a nested value for a
+ * field, sends the whole chunk through dynd's JSON parser instead, which
+ * also reports the errors.
+ *
+ * This doesn't touch Python, so it may be called without the GIL unless
+ * `tp` holds Python objects.
+ */
+PYDYND_API dynd::nd::array parse_json_lines(const dynd::ndt::type &tp, const char *begin, const char *end,
+                                            const dynd::eval::eval_context *ectx, intptr_t nthreads);
+
+/**
+ * Collects chunks of rows into one array of type "N * tp", growing its
+ * storage geometrically so that appending a chunk copies each row only
+ * an amortized constant number of times.
+ */
+class PYDYND_API json_lines_builder {
+  dynd::ndt::type m_tp;
+  dynd::nd::array m_buffer;
+  intptr_t m_size;
+
+public:
+  json_lines_builder(const dynd::ndt::type &tp);
+
+  /**
+   * Appends the rows of `chunk`, an array of type "N * tp".
+   */
+  void append(const dynd::nd::array &chunk);
+
+  /**
+   * The rows appended so far, as a view of the storage.
+   */
+  dynd::nd::array get() const;
+};
+
+} // namespace pydynd
@@ -0,0 +1,144 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the decoding of JSON string escapes shared by the
+// JSON parsers and the type discovery, which run outside of dynd's parser.
+//
+
+#pragma once
+
+#include <string>
+
+namespace pydynd {
+namespace detail {
+
+inline int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+inline bool parse_hex4(const char *begin, const char *end, unsigned &out)
+{
+  if (end - begin < 4) {
+    return false;
+  }
+  out = 0;
+  for (int i = 0; i < 4; ++i) {
+    int d = hex_digit(begin[i]);
+    if (d < 0) {
+      return false;
+    }
+    out = (out << 4) | d;
+  }
+
+  return true;
+}
+
+inline void append_utf8(unsigned cp, std::string &out)
+{
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  }
+  else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+} // namespace pydynd::detail
+
+/**
+ * Decodes the escape sequences of the JSON string contents [begin, end),
+ * i.e. the text between its quotes, into `out`, with \uXXXX escapes
+ * (including surrogate pairs) encoded as UTF-8. Returns false if an escape
+ * sequence is invalid.
+ */
+inline bool json_unescape(const char *begin, const char *end, std::string &out)
+{
+  out.clear();
+  while (begin != end) {
+    char c = *begin++;
+    if (c != '\\') {
+      out += c;
+      continue;
+    }
+    if (begin == end) {
+      return false;
+    }
+    switch (*begin++) {
+    case '"':
+      out += '"';
+      break;
+    case '\\':
+      out += '\\';
+      break;
+    case '/':
+      out += '/';
+      break;
+    case 'b':
+      out += '\b';
+      break;
+    case 'f':
+      out += '\f';
+      break;
+    case 'n':
+      out += '\n';
+      break;
+    case 'r':
+      out += '\r';
+      break;
+    case 't':
+      out += '\t';
+      break;
+    case 'u': {
+      unsigned cp;
+      if (!detail::parse_hex4(begin, end, cp)) {
+        return false;
+      }
+      begin += 4;
+      if (cp >= 0xD800 && cp < 0xDC00) {
+        // A surrogate pair
+        unsigned low;
+        if (end - begin < 6 || begin[0] != '\\' || begin[1] != 'u' || !detail::parse_hex4(begin + 2, end, low) ||
+            low < 0xDC00 || low >= 0xE000) {
+          return false;
+        }
+        begin += 6;
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+      }
+      else if (cp >= 0xDC00 && cp < 0xE000) {
+        return false;
+      }
+      detail::append_utf8(cp, out);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace pydynd
@@ -0,0 +1,166 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines callables prepared for fixed argument types, the
+// per-callable cache of them used by nd.callable.__call__, and the
+// vectorcall entry point into it.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dynd/callable.hpp>
+
+#include "visibility.hpp"
+
+#if PY_VERSION_HEX >= 0x03080000
+#define PYDYND_HAVE_VECTORCALL 1
+#else
+#define PYDYND_HAVE_VECTORCALL 0
+// Older Pythons never call through this, but the callable wrapper still
+// declares a slot of this type.
+typedef PyObject *(*vectorcallfunc)(PyObject *callable, PyObject *const *args, size_t nargsf, PyObject *kwnames);
+#define PyVectorcall_NARGS(n) ((Py_ssize_t)(n))
+#endif
+
+namespace dynd {
+namespace nd {
+  class kernel_builder;
+} // namespace dynd::nd
+} // namespace dynd
+
+namespace pydynd {
+
+/**
+ * Whether the arrmeta of `tp` is plain data that can be copied and
+ * compared bytewise, i.e. whether it is a builtin type or fixed
+ * dimensions of one. Only such types can be prepared.
+ */
+PYDYND_API bool has_pod_arrmeta(dynd::ndt::type tp);
+
+/**
+ * A callable resolved and instantiated once for fixed argument types and
+ * arrmeta, and a fixed result arrmeta. Running it again only needs the data
+ * pointers of the arguments and the result.
+ *
+ * The arrmeta is copied, so the kernel never refers to the arrmeta of an
+ * array that no longer exists.
+ */
+class PYDYND_API prepared_call {
+  std::vector<dynd::ndt::type> m_src_tp;
+  std::vector<std::string> m_src_arrmeta;
+  dynd::ndt::type m_dst_tp;
+  std::string m_dst_arrmeta;
+  dynd::nd::call_graph m_cg;
+  std::unique_ptr<dynd::nd::kernel_builder> m_kb;
+
+public:
+  /**
+   * Prepares `f` for arguments of the types `src_tp`.
+   *
+   * \param f  The callable to prepare.
+   * \param src_tp  The types of the positional arguments.
+   * \param src  Arrays providing the arrmeta (i.e. the strides) of the
+   *             arguments, or null arrays for the default arrmeta of the
+   *             corresponding type.
+   * \param dst  The array the result will be written to, or a null array
+   *             to write to new arrays with the default arrmeta.
+   */
+  prepared_call(const dynd::nd::callable &f, const std::vector<dynd::ndt::type> &src_tp,
+                const std::vector<dynd::nd::array> &src, const dynd::nd::array &dst);
+
+  ~prepared_call();
+
+  size_t get_narg() const { return m_src_tp.size(); }
+
+  const dynd::ndt::type &get_dst_type() const { return m_dst_tp; }
+
+  const dynd::ndt::type &get_src_type(size_t i) const { return m_src_tp[i]; }
+
+  /**
+   * Whether `args` have the types and arrmeta this was prepared for.
+   */
+  bool matches(size_t narg, const dynd::nd::array *args) const;
+
+  /**
+   * Whether `dst` has the type and arrmeta this was prepared for.
+   */
+  bool matches_dst(const dynd::nd::array &dst) const;
+
+  /**
+   * Runs the kernel on raw data pointers, without checking anything.
+   * This doesn't touch Python, so it may be called without the GIL
+   * unless the callable itself calls into Python.
+   */
+  void single(char *dst, char *const *src) const;
+
+  /**
+   * Runs the kernel on `args`, writing to a new array.
+   */
+  dynd::nd::array operator()(size_t narg, const dynd::nd::array *args) const;
+
+  /**
+   * Runs the kernel on `args`, writing to `dst`.
+   */
+  void operator()(const dynd::nd::array &dst, size_t narg, const dynd::nd::array *args) const;
+};
+
+/**
+ * Remembers the callable prepared for the last few argument signatures it
+ * was called with, so that calling it again with arrays of the same types
+ * and arrmeta skips the resolution of the call graph and the kernel
+ * instantiation, and only allocates the result and runs the kernel.
+ *
+ * Only calls without keyword arguments, whose arguments and result have
+ * plain data arrmeta, are cached. A call with new argument types is
+ * resolved and instantiated once, into the entry it then runs through, and
+ * the argument types the callable can't be prepared for are remembered so
+ * their later calls go straight to the callable.
+ *
+ * This must only be used with the GIL held.
+ */
+class PYDYND_API kernel_cache {
+  struct entry;
+
+  std::vector<std::shared_ptr<entry>> m_entries;
+  std::vector<std::vector<dynd::ndt::type>> m_uncached;
+
+  std::shared_ptr<entry> find(size_t narg, const dynd::nd::array *args) const;
+  std::shared_ptr<entry> insert(const dynd::nd::callable &f, size_t narg, const dynd::nd::array *args);
+
+public:
+  // The number of argument signatures remembered per callable.
+  static const size_t max_size = 8;
+
+  kernel_cache();
+  ~kernel_cache();
+
+  /**
+   * Calls `f` with the positional arguments `args`, through a cached kernel
+   * when there is one matching them.
+   */
+  dynd::nd::array call(const dynd::nd::callable &f, size_t narg, const dynd::nd::array *args);
+
+  size_t size() const { return m_entries.size(); }
+
+  void clear()
+  {
+    m_entries.clear();
+    m_uncached.clear();
+  }
+};
+
+/**
+ * Makes instances of `tp` callable through the vectorcall protocol, with the
+ * function stored `offset` bytes into each instance. This does nothing on
+ * Pythons older than 3.8.
+ */
+PYDYND_API void enable_vectorcall(PyTypeObject *tp, Py_ssize_t offset);
+
+} // namespace pydynd
@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include <cstring>
+
 #include <dynd/types/fixed_bytes_type.hpp>
 
+#include "utf8.hpp"
+
 using namespace dynd;
 
 template <typename Arg0Type, typename Enable = void>
@@ -22,7 +26,7 @@ struct assign_to_pyobject_kernel<bool> : nd::base_strided_kernel<assign_to_pyobj
   }
 };
 
-PyObject *pyint_from_int(int8_t v)
+inline PyObject *pyint_from_int(int8_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -31,7 +35,7 @@ PyObject *pyint_from_int(int8_t v)
 #endif
 }
 
-PyObject *pyint_from_int(uint8_t v)
+inline PyObject *pyint_from_int(uint8_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -40,7 +44,7 @@ PyObject *pyint_from_int(uint8_t v)
 #endif
 }
 
-PyObject *pyint_from_int(int16_t v)
+inline PyObject *pyint_from_int(int16_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -49,7 +53,7 @@ PyObject *pyint_from_int(int16_t v)
 #endif
 }
 
-PyObject *pyint_from_int(uint16_t v)
+inline PyObject *pyint_from_int(uint16_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -58,7 +62,7 @@ PyObject *pyint_from_int(uint16_t v)
 #endif
 }
 
-PyObject *pyint_from_int(int32_t v)
+inline PyObject *pyint_from_int(int32_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -67,10 +71,10 @@ PyObject *pyint_from_int(int32_t v)
 #endif
 }
 
-PyObject *pyint_from_int(uint32_t v) { return PyLong_FromUnsignedLong(v); }
+inline PyObject *pyint_from_int(uint32_t v) { return PyLong_FromUnsignedLong(v); }
 
 #if SIZEOF_LONG == 8
-PyObject *pyint_from_int(int64_t v)
+inline PyObject *pyint_from_int(int64_t v)
 {
 #if PY_VERSION_HEX >= 0x03000000
   return PyLong_FromLong(v);
@@ -79,14 +83,14 @@ PyObject *pyint_from_int(int64_t v)
 #endif
 }
 
-PyObject *pyint_from_int(uint64_t v) { return PyLong_FromUnsignedLong(v); }
+inline PyObject *pyint_from_int(uint64_t v) { return PyLong_FromUnsignedLong(v); }
 #else
-PyObject *pyint_from_int(int64_t v) { return PyLong_FromLongLong(v); }
+inline PyObject *pyint_from_int(int64_t v) { return PyLong_FromLongLong(v); }
 
-PyObject *pyint_from_int(uint64_t v) { return PyLong_FromUnsignedLongLong(v); }
+inline PyObject *pyint_from_int(uint64_t v) { return PyLong_FromUnsignedLongLong(v); }
 #endif
 
-PyObject *pyint_from_int(const dynd::uint128 &val)
+inline PyObject *pyint_from_int(const dynd::uint128 &val)
 {
   if (val.m_hi == 0ULL) {
     return PyLong_FromUnsignedLongLong(val.m_lo);
@@ -99,7 +103,7 @@ PyObject *pyint_from_int(const dynd::uint128 &val)
   return PyNumber_Or(hi_shifted.get(), lo.get());
 }
 
-PyObject *pyint_from_int(const dynd::int128 &val)
+inline PyObject *pyint_from_int(const dynd::int128 &val)
 {
   if (val.is_negative()) {
     if (val.m_hi == 0xffffffffffffffffULL && (val.m_hi & 0x8000000000000000ULL) != 0) {
@@ -261,7 +265,7 @@ struct string_utf8_assign_kernel : dynd::nd::base_strided_kernel<string_utf8_ass
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
     const dynd::string *sd = reinterpret_cast<const dynd::string *>(src[0]);
-    *dst_obj = PyUnicode_DecodeUTF8(sd->begin(), sd->end() - sd->begin(), NULL);
+    *dst_obj = pydynd::pyunicode_from_utf8(sd->begin(), sd->end());
   }
 };
 
@@ -272,7 +276,8 @@ struct string_utf16_assign_kernel : dynd::nd::base_strided_kernel<string_utf16_a
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
     const dynd::string *sd = reinterpret_cast<const dynd::string *>(src[0]);
-    *dst_obj = PyUnicode_DecodeUTF16(sd->begin(), sd->end() - sd->begin(), NULL, NULL);
+    *dst_obj = pydynd::pyunicode_from_utf16(reinterpret_cast<const uint16_t *>(sd->begin()),
+                                            reinterpret_cast<const uint16_t *>(sd->end()));
   }
 };
 
@@ -283,7 +288,8 @@ struct string_utf32_assign_kernel : dynd::nd::base_strided_kernel<string_utf32_a
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
     const dynd::string *sd = reinterpret_cast<const dynd::string *>(src[0]);
-    *dst_obj = PyUnicode_DecodeUTF32(sd->begin(), sd->end() - sd->begin(), NULL, NULL);
+    *dst_obj = pydynd::pyunicode_from_utf32(reinterpret_cast<const uint32_t *>(sd->begin()),
+                                            reinterpret_cast<const uint32_t *>(sd->end()));
   }
 };
 
@@ -312,8 +318,8 @@ struct fixed_string_utf8_assign_kernel : dynd::nd::base_strided_kernel<fixed_str
     PyObject **dst_obj = reinterpret_cast<PyObject **>(dst);
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
-    intptr_t size = std::find(src[0], src[0] + data_size, 0) - src[0];
-    *dst_obj = PyUnicode_DecodeUTF8(src[0], size, NULL);
+    const char *nul = reinterpret_cast<const char *>(memchr(src[0], 0, data_size));
+    *dst_obj = pydynd::pyunicode_from_utf8(src[0], nul != NULL ? nul : src[0] + data_size);
   }
 };
 
@@ -328,8 +334,8 @@ struct fixed_string_utf16_assign_kernel : dynd::nd::base_strided_kernel<fixed_st
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
     const uint16_t *char16_src = reinterpret_cast<const uint16_t *>(src[0]);
-    intptr_t size = std::find(char16_src, char16_src + (data_size >> 1), 0) - char16_src;
-    *dst_obj = PyUnicode_DecodeUTF16(src[0], size * 2, NULL, NULL);
+    intptr_t size = pydynd::utf16_nul_length(char16_src, char16_src + (data_size >> 1));
+    *dst_obj = pydynd::pyunicode_from_utf16(char16_src, char16_src + size);
   }
 };
 
@@ -344,8 +350,8 @@ struct fixed_string_utf32_assign_kernel : dynd::nd::base_strided_kernel<fixed_st
     Py_XDECREF(*dst_obj);
     *dst_obj = NULL;
     const uint32_t *char32_src = reinterpret_cast<const uint32_t *>(src[0]);
-    intptr_t size = std::find(char32_src, char32_src + (data_size >> 2), 0) - char32_src;
-    *dst_obj = PyUnicode_DecodeUTF32(src[0], size * 4, NULL, NULL);
+    intptr_t size = pydynd::utf32_nul_length(char32_src, char32_src + (data_size >> 2));
+    *dst_obj = pydynd::pyunicode_from_utf32(char32_src, char32_src + size);
   }
 };
 
@@ -0,0 +1,97 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines nd.memmap, which views a memory mapped file as a
+// dynd array, the madvise hints for such arrays, and nd.save/nd.load for
+// a file format holding arrays of any type, whose data section is also
+// what arrays are pickled as.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <string>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Maps the file at `path` into memory, and views its bytes from `offset`
+ * on as an array of type `tp`. The mapping is released when the last array
+ * referencing its memory block goes away.
+ *
+ * \param path  The path of the file, in the filesystem encoding.
+ * \param tp  The type of the array. A leading symbolic dimension (e.g.
+ *            "Fixed * float64") takes the size that fills the rest of the
+ *            file, the type must otherwise be concrete. The data must be
+ *            plain data, i.e. no strings, var dimensions or objects.
+ * \param mode  "r" for a readonly mapping, "r+" for a writable mapping
+ *              whose changes are written to the file, or "c" for a
+ *              writable copy-on-write mapping that leaves the file as is.
+ * \param offset  The byte offset in the file at which the array data starts.
+ * \param advice  A hint passed to `array_madvise`, or an empty string.
+ */
+PYDYND_API dynd::nd::array array_memmap(const std::string &path, const dynd::ndt::type &tp, const std::string &mode,
+                                        intptr_t offset, const std::string &advice);
+
+/**
+ * Tells the operating system how the data of `a` is going to be accessed,
+ * so it can read ahead or drop pages accordingly. This is a hint, and
+ * does nothing on platforms which lack posix_madvise.
+ *
+ * \param a  An array with fixed dimensions, usually from `array_memmap`.
+ * \param advice  One of "normal", "sequential", "random", "willneed" or
+ *                "dontneed".
+ */
+PYDYND_API void array_madvise(const dynd::nd::array &a, const std::string &advice);
+
+/**
+ * Writes `a` to the file at `path`, in a self describing format holding
+ * its datashape and its data. The data is stored in the layout of a new
+ * array of the same type, followed by the elements of its var dimensions
+ * and the bytes of its strings, which the data refers to by their offset.
+ *
+ * \param path  The path of the file, in the filesystem encoding.
+ * \param a  The array to save. Its type may consist of fixed and var
+ *           dimensions, structs, tuples, options, strings, bytes and plain
+ *           data.
+ */
+PYDYND_API void array_save(const std::string &path, const dynd::nd::array &a);
+
+/**
+ * Reads an array written by `array_save` from the file at `path`.
+ *
+ * With `mmap` true and a type without strings or bytes, the result views
+ * the mapped file instead of reading it. The offsets of its var dimensions
+ * are then replaced by pointers in a private mapping, so only the pages
+ * holding them are touched. Otherwise, the result is a new array copied
+ * from the file.
+ *
+ * \param path  The path of the file, in the filesystem encoding.
+ * \param mmap  Whether to view the data in the mapped file when possible.
+ */
+PYDYND_API dynd::nd::array array_load(const std::string &path, bool mmap);
+
+/**
+ * Packs the data of `a` into a one dimensional uint8 array, in the layout
+ * of the data section of `array_save`. When `a` is plain data in C order,
+ * this is a view of its data, otherwise the data is copied once.
+ */
+PYDYND_API dynd::nd::array array_pack(const dynd::nd::array &a);
+
+/**
+ * Rebuilds an array of type `tp` from the data packed by `array_pack`,
+ * held by an object exporting the buffer protocol. Plain data in a
+ * writable buffer is viewed there, and the result keeps the buffer alive.
+ * This includes the elements of var dimensions, whose offsets are copied
+ * into pointers outside the buffer, so it is never modified. Arrays with
+ * strings, and any array in a read-only buffer, are copied from it.
+ */
+PYDYND_API dynd::nd::array array_unpack(const dynd::ndt::type &tp, PyObject *obj);
+
+} // namespace pydynd
@@ -0,0 +1,58 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the simple thread pool loop shared by the
+// multi-threaded reductions and parsers.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace pydynd {
+
+/**
+ * Calls `func(i)` for every `i` in [0, count), distributing the indices
+ * round robin over `nthreads` threads. An exception raised on a worker
+ * thread is rethrown on the calling thread once all workers are joined.
+ */
+template <typename FuncType>
+void parallel_for(intptr_t count, intptr_t nthreads, const FuncType &func)
+{
+  if (nthreads <= 1 || count <= 1) {
+    for (intptr_t i = 0; i < count; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  nthreads = std::min(nthreads, count);
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(nthreads);
+  for (intptr_t t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&func, &errors, count, nthreads, t]() {
+      try {
+        for (intptr_t i = t; i < count; i += nthreads) {
+          func(i);
+        }
+      }
+      catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  for (const std::exception_ptr &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace pydynd
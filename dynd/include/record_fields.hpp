@@ -0,0 +1,288 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the plan for parsing text rows straight into the
+// fields of a struct array, shared by the JSON lines and CSV readers.
+//
+
+#pragma once
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+
+namespace pydynd {
+
+enum field_kind {
+  bool_field,
+  int8_field,
+  int16_field,
+  int32_field,
+  int64_field,
+  uint8_field,
+  uint16_field,
+  uint32_field,
+  uint64_field,
+  float32_field,
+  float64_field,
+  string_field
+};
+
+/**
+ * How one field of a struct row is parsed, and where it is stored.
+ */
+struct field_plan {
+  std::string name;
+  field_kind kind;
+  bool option;
+  uintptr_t offset;
+};
+
+/**
+ * Parses the decimal integer in [begin, end), with an optional minus sign,
+ * into `dst`. Returns false if it isn't one, or if it doesn't fit in `T`.
+ */
+template <typename T>
+inline bool parse_signed(const char *begin, const char *end, char *dst)
+{
+  bool negative = (begin != end && *begin == '-');
+  if (negative) {
+    ++begin;
+  }
+  if (begin == end || (*begin == '0' && end - begin > 1)) {
+    return false;
+  }
+
+  // Accumulate the negated value, whose range includes the minimum
+  long long value = 0;
+  const long long min_value = std::numeric_limits<T>::min();
+  for (; begin != end; ++begin) {
+    if (*begin < '0' || *begin > '9') {
+      return false;
+    }
+    int digit = *begin - '0';
+    if (value < (min_value + digit) / 10) {
+      return false;
+    }
+    value = value * 10 - digit;
+  }
+  if (!negative) {
+    if (value < -static_cast<long long>(std::numeric_limits<T>::max())) {
+      return false;
+    }
+    value = -value;
+  }
+
+  T result = static_cast<T>(value);
+  memcpy(dst, &result, sizeof(T));
+  return true;
+}
+
+/**
+ * Parses the decimal integer in [begin, end) into `dst`. Returns false if
+ * it isn't one, or if it doesn't fit in `T`.
+ */
+template <typename T>
+inline bool parse_unsigned(const char *begin, const char *end, char *dst)
+{
+  if (begin == end || (*begin == '0' && end - begin > 1)) {
+    return false;
+  }
+
+  unsigned long long value = 0;
+  const unsigned long long max_value = std::numeric_limits<T>::max();
+  for (; begin != end; ++begin) {
+    if (*begin < '0' || *begin > '9') {
+      return false;
+    }
+    unsigned digit = *begin - '0';
+    if (value > (max_value - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+
+  T result = static_cast<T>(value);
+  memcpy(dst, &result, sizeof(T));
+  return true;
+}
+
+/**
+ * Stores the unavailable value of an option field.
+ */
+template <typename T>
+inline void store_na(char *dst)
+{
+  T na = dynd::ndt::traits<T>::na();
+  memcpy(dst, &na, sizeof(T));
+}
+
+inline bool store_na(const field_plan &f, char *dst)
+{
+  switch (f.kind) {
+  case bool_field:
+    store_na<dynd::bool1>(dst);
+    return true;
+  case int8_field:
+    store_na<int8_t>(dst);
+    return true;
+  case int16_field:
+    store_na<int16_t>(dst);
+    return true;
+  case int32_field:
+    store_na<int32_t>(dst);
+    return true;
+  case int64_field:
+    store_na<int64_t>(dst);
+    return true;
+  case uint8_field:
+    store_na<uint8_t>(dst);
+    return true;
+  case uint16_field:
+    store_na<uint16_t>(dst);
+    return true;
+  case uint32_field:
+    store_na<uint32_t>(dst);
+    return true;
+  case uint64_field:
+    store_na<uint64_t>(dst);
+    return true;
+  case float32_field:
+    store_na<float>(dst);
+    return true;
+  case float64_field:
+    store_na<double>(dst);
+    return true;
+  case string_field:
+    // The strings of a new array are already unavailable
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Returns whether the value of an option field is unavailable.
+ */
+template <typename T>
+inline bool is_na(const char *data)
+{
+  T na = dynd::ndt::traits<T>::na();
+  return memcmp(data, &na, sizeof(T)) == 0;
+}
+
+inline bool is_na(field_kind kind, const char *data)
+{
+  switch (kind) {
+  case bool_field:
+    return is_na<dynd::bool1>(data);
+  case int8_field:
+    return is_na<int8_t>(data);
+  case int16_field:
+    return is_na<int16_t>(data);
+  case int32_field:
+    return is_na<int32_t>(data);
+  case int64_field:
+    return is_na<int64_t>(data);
+  case uint8_field:
+    return is_na<uint8_t>(data);
+  case uint16_field:
+    return is_na<uint16_t>(data);
+  case uint32_field:
+    return is_na<uint32_t>(data);
+  case uint64_field:
+    return is_na<uint64_t>(data);
+  case float32_field:
+    return is_na<float>(data);
+  case float64_field:
+    return is_na<double>(data);
+  case string_field:
+    return reinterpret_cast<const dynd::string *>(data)->begin() == NULL;
+  default:
+    return false;
+  }
+}
+
+inline bool field_kind_of(dynd::type_id_t id, field_kind &kind)
+{
+  switch (id) {
+  case dynd::bool_id:
+    kind = bool_field;
+    return true;
+  case dynd::int8_id:
+    kind = int8_field;
+    return true;
+  case dynd::int16_id:
+    kind = int16_field;
+    return true;
+  case dynd::int32_id:
+    kind = int32_field;
+    return true;
+  case dynd::int64_id:
+    kind = int64_field;
+    return true;
+  case dynd::uint8_id:
+    kind = uint8_field;
+    return true;
+  case dynd::uint16_id:
+    kind = uint16_field;
+    return true;
+  case dynd::uint32_id:
+    kind = uint32_field;
+    return true;
+  case dynd::uint64_id:
+    kind = uint64_field;
+    return true;
+  case dynd::float32_id:
+    kind = float32_field;
+    return true;
+  case dynd::float64_id:
+    kind = float64_field;
+    return true;
+  case dynd::string_id:
+    kind = string_field;
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Plans the fields of a parser for rows of type `tp`, with the arrmeta
+ * `arrmeta`. Returns false unless `tp` is a struct whose fields are all
+ * booleans, numbers or strings, or options of them.
+ */
+inline bool make_record_plan(const dynd::ndt::type &tp, const char *arrmeta, std::vector<field_plan> &fields)
+{
+  if (tp.get_id() != dynd::struct_id) {
+    return false;
+  }
+
+  const dynd::ndt::struct_type *st = tp.extended<dynd::ndt::struct_type>();
+  const uintptr_t *data_offsets = st->get_data_offsets(arrmeta);
+  for (intptr_t i = 0; i < st->get_field_count(); ++i) {
+    dynd::ndt::type field_tp = st->get_field_type(i);
+    field_plan f;
+    const dynd::string &name = st->get_field_name(i);
+    f.name.assign(name.begin(), name.end());
+    f.option = (field_tp.get_id() == dynd::option_id);
+    if (f.option) {
+      field_tp = field_tp.extended<dynd::ndt::option_type>()->get_value_type();
+    }
+    if (!field_kind_of(field_tp.get_id(), f.kind)) {
+      return false;
+    }
+    f.offset = data_offsets[i];
+    fields.push_back(f);
+  }
+
+  return true;
+}
+
+} // namespace pydynd
@@ -0,0 +1,68 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the blocked, pairwise and multi-threaded
+// reduction drivers used by nd.functional.reduction and nd.array.sum.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <vector>
+
+#include <dynd/array.hpp>
+#include <dynd/callable.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Converts the Python `axes` argument of a reduction into a sorted vector
+ * of nonnegative axis indices. `None` selects every axis, and a single
+ * integer, a tuple or a list of integers are accepted.
+ *
+ * \param axes  The Python axes argument.
+ * \param ndim  The number of dimensions of the array being reduced.
+ */
+PYDYND_API std::vector<intptr_t> reduction_axes_from_pyobject(PyObject *axes, intptr_t ndim);
+
+/**
+ * Reduces `a` over `axes` by splitting the largest reduced dimension into
+ * blocks of `block_size` indices, reducing every block with `reduce`
+ * (possibly on several worker threads), and combining the partial results
+ * with `combine` along a fixed pairwise tree.
+ *
+ * The shape of the tree only depends on the shape of `a` and on
+ * `block_size`, so the result is bitwise identical for any `nthreads`.
+ *
+ * This must be called without the GIL held when `nthreads` is greater
+ * than one, and neither callable may call back into Python in that case.
+ *
+ * \param reduce  A reduction callable accepting an `axes` keyword.
+ * \param combine  A binary elementwise callable merging two partial results.
+ * \param a  The array to reduce.
+ * \param axes  The normalized axes, as from `reduction_axes_from_pyobject`.
+ * \param block_size  The number of indices of the split dimension per block.
+ * \param nthreads  The number of worker threads to use.
+ */
+PYDYND_API dynd::nd::array tree_reduction(const dynd::nd::callable &reduce, const dynd::nd::callable &combine,
+                                          const dynd::nd::array &a, const std::vector<intptr_t> &axes,
+                                          intptr_t block_size, intptr_t nthreads);
+
+/**
+ * Sums `a` over `axes` using pairwise summation. Fixed dimensional arrays of
+ * float32, float64 and complex values are summed directly from their strided
+ * data along a pairwise tree, giving O(log n) error growth instead of the
+ * O(n) of a left fold. The upper levels of that tree are evaluated
+ * concurrently on `nthreads` threads, which doesn't change the result.
+ *
+ * Other arrays go through `tree_reduction` with the provided callables.
+ */
+PYDYND_API dynd::nd::array pairwise_sum(const dynd::nd::callable &reduce, const dynd::nd::callable &combine,
+                                        const dynd::nd::array &a, const std::vector<intptr_t> &axes,
+                                        intptr_t block_size, intptr_t nthreads);
+
+} // namespace pydynd
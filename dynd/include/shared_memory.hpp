@@ -0,0 +1,51 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines arrays allocated in POSIX shared memory, which other
+// processes can attach to by name without copying them.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <string>
+
+#include <dynd/array.hpp>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Allocates an uninitialized array of type `tp` in a new shared memory
+ * segment. The segment holds a count of the arrays attached to it in all
+ * processes, and is unlinked when the last of them goes away. The arrays a
+ * forked child inherits aren't counted, since the child didn't attach
+ * them, so they only stay valid in it while the parent's are alive, unless
+ * the child attaches to the segment itself.
+ *
+ * \param tp  A concrete type of plain data, i.e. without var dimensions,
+ *            strings or objects, whose pointers would only be valid in
+ *            the process which allocated them.
+ */
+PYDYND_API dynd::nd::array array_empty_shared(const dynd::ndt::type &tp);
+
+/**
+ * Returns the name of the shared memory segment `a` was allocated in, by
+ * which `array_attach_shared` finds it. `a` must be the array returned by
+ * `array_empty_shared` or `array_attach_shared`, not a view into it.
+ */
+PYDYND_API std::string array_shared_name(const dynd::nd::array &a);
+
+/**
+ * Views the array in the shared memory segment called `name`, which is
+ * counted as another attachment to it.
+ *
+ * \param name  The name from `array_shared_name`, in any process.
+ * \param readonly  Whether to map the segment readonly.
+ */
+PYDYND_API dynd::nd::array array_attach_shared(const std::string &name, bool readonly);
+
+} // namespace pydynd
@@ -0,0 +1,73 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines the validation and transcoding of the UTF-8, UTF-16
+// and UTF-32 text of dynd strings, for the conversions that write code
+// points directly and for making Python strings from them. The
+// implementations use SSE2 or AVX2 when the CPU has them.
+//
+
+#pragma once
+
+#include <Python.h>
+
+#include <cstdint>
+#include <string>
+
+#include "visibility.hpp"
+
+namespace pydynd {
+
+/**
+ * Returns the number of code points of the UTF-8 text [begin, end), or -1
+ * if it isn't valid UTF-8, i.e. if it has a truncated or overlong sequence,
+ * a surrogate or a code point beyond U+10FFFF.
+ */
+PYDYND_API intptr_t utf8_length(const char *begin, const char *end);
+
+/**
+ * Decodes the valid UTF-8 text [begin, end) into UTF-32 at `out`, and
+ * returns the end of the code points written.
+ */
+PYDYND_API uint32_t *utf8_to_utf32(const char *begin, const char *end, uint32_t *out);
+
+/**
+ * Decodes the valid UTF-8 text [begin, end) into UTF-16 at `out`, with
+ * surrogate pairs for the code points beyond U+FFFF, and returns the end of
+ * the code units written.
+ */
+PYDYND_API uint16_t *utf8_to_utf16(const char *begin, const char *end, uint16_t *out);
+
+/**
+ * Returns the number of code units of [begin, end) before the first NUL,
+ * which ends the text of a fixed_string.
+ */
+PYDYND_API intptr_t utf16_nul_length(const uint16_t *begin, const uint16_t *end);
+PYDYND_API intptr_t utf32_nul_length(const uint32_t *begin, const uint32_t *end);
+
+/**
+ * Makes a Python string from the UTF-8, UTF-16 or UTF-32 text [begin, end),
+ * in native byte order. The text is checked and copied into the narrowest
+ * representation of the string in one pass each, and invalid text raises
+ * the UnicodeDecodeError of Python's own codec. Returns a new reference, or
+ * NULL with the Python error set.
+ */
+PYDYND_API PyObject *pyunicode_from_utf8(const char *begin, const char *end);
+PYDYND_API PyObject *pyunicode_from_utf16(const uint16_t *begin, const uint16_t *end);
+PYDYND_API PyObject *pyunicode_from_utf32(const uint32_t *begin, const uint32_t *end);
+
+/**
+ * The name of the implementation the functions above use on this CPU, one
+ * of "avx2", "sse2" or "scalar".
+ */
+PYDYND_API const char *utf8_backend();
+
+/**
+ * Overrides the implementation used by the functions above, mainly for
+ * testing. An empty `name` restores the one selected for the CPU. Raises an
+ * error if the named implementation isn't available.
+ */
+PYDYND_API void set_utf8_backend(const std::string &name);
+
+} // namespace pydynd
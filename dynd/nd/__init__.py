@@ -9,8 +9,12 @@ from dynd.config import *
 
 from .array import array, asarray, type_of, dshape_of, as_py, view, \
     ones, zeros, empty, is_c_contiguous, is_f_contiguous, old_range, \
-    parse_json, squeeze, dtype_of, old_linspace, fields, ndim_of
-from .callable import callable
+    parse_json, squeeze, dtype_of, old_linspace, fields, ndim_of, memmap, \
+    madvise, save, load, to_shared, shared_handle, attach_shared, \
+    parse_json_lines, read_json_lines, to_json, read_csv, from_arrow, \
+    from_arrow_capsule, read_arrow, from_dlpack, ragged_to_numpy, \
+    ragged_from_numpy, to_padded
+from .callable import callable, prepared
 
 inf = float('inf')
 nan = float('nan')
@@ -1,4 +1,5 @@
 from cpython.object cimport PyObject
+from libc.stdint cimport intptr_t
 
 from ..cpp.array cimport array as _array
 from ..cpp.callable cimport callable as _callable
@@ -7,6 +8,8 @@ from ..cpp.type cimport type as _type
 cdef api class array(object)[object dynd_nd_array_pywrapper,
                              type dynd_nd_array_pywrapper_type]:
     cdef _array v
+    # The NumPy view of the data, False if it can't be viewed, or None
+    cdef object _numpy
 
 cdef _array as_cpp_array(object obj) except *
 cpdef array asarray(object obj)
@@ -17,3 +20,5 @@ cdef api array dynd_nd_array_from_cpp(_array)
 
 cdef _callable _functional_apply(_type t, object o) except *
 cdef void _registry_assign_init() except *
+cdef array _functional_tree_reduction(_callable reduce, _callable combine, object a, object axes,
+                                      intptr_t block_size, intptr_t nthreads)
@@ -5,13 +5,23 @@ _builtin_type = type
 from cpython.object cimport (Py_LT, Py_LE, Py_EQ, Py_NE, Py_GE, Py_GT,
                              PyObject_TypeCheck, PyTypeObject)
 from cpython.buffer cimport PyObject_CheckBuffer
+from cpython.bytes cimport PyBytes_FromStringAndSize
+from libc.stdint cimport intptr_t, uint32_t
 from libcpp.string cimport string
 from libcpp.map cimport map
 from libcpp cimport bool as cpp_bool
 from libcpp.complex cimport complex as cpp_complex
 from cython.operator import dereference
 from libcpp.vector cimport vector
+import io
 import numpy as _np
+import os
+import sys
+
+try:
+    from pickle import PickleBuffer as _PickleBuffer
+except ImportError:
+    _PickleBuffer = None
 
 from ..cpp.array cimport (groupby as dynd_groupby, empty as cpp_empty,
                           dtyped_zeros, dtyped_ones, dtyped_empty, array_and)
@@ -22,6 +32,7 @@ from ..cpp.registry cimport registered
 from ..cpp.types.datashape_formatter cimport format_datashape as dynd_format_datashape
 from ..cpp.types.type_id cimport *
 from ..cpp.view cimport view as _view
+from ..cpp.eval.eval_context cimport eval_context
 from ..pyobject_type cimport pyobject_id
 
 from ..config cimport translate_exception
@@ -48,6 +59,7 @@ cdef extern from 'array_functions.hpp' namespace 'pydynd':
     bint array_is_f_contiguous(_array&) except +translate_exception
 
     object array_as_numpy(object, bint) except +translate_exception
+    object array_strings_as_numpy(object, char) except +translate_exception
 
     const char *array_access_flags_string(_array&) except +translate_exception
 
@@ -61,17 +73,98 @@ cdef extern from 'array_functions.hpp' namespace 'pydynd':
     int array_getbuffer_pep3118(object ndo, Py_buffer *buffer, int flags) except -1
     int array_releasebuffer_pep3118(object ndo, Py_buffer *buffer) except -1
 
+cdef extern from 'array_categorical.hpp' namespace 'pydynd':
+    _array array_from_py_categorical(object, _type&, intptr_t) except +translate_exception
+
 cdef extern from "array_from_py.hpp" namespace "pydynd":
     void init_array_from_py() except *
+    _array array_from_pyscalar(object) except +translate_exception
 
 cdef extern from 'numpy_interop.hpp' namespace 'pydynd':
     # Have Cython use an integer to represent the bool argument.
     # It will convert implicitly to bool at the C++ level.
-    _array array_from_numpy_array_cast(PyObject*, unsigned int, bint)
+    _array array_from_numpy_array_cast(PyObject*, unsigned int, bint) except +translate_exception
 
 cdef extern from 'init.hpp' namespace 'pydynd':
     void numpy_interop_init() except *
 
+cdef extern from 'reduction.hpp' namespace 'pydynd':
+    vector[intptr_t] reduction_axes_from_pyobject(object, intptr_t) except +translate_exception
+    _array tree_reduction(_callable&, _callable&, _array&, vector[intptr_t]&, intptr_t,
+                          intptr_t) nogil except +translate_exception
+    _array pairwise_sum(_callable&, _callable&, _array&, vector[intptr_t]&, intptr_t,
+                        intptr_t) nogil except +translate_exception
+
+cdef extern from 'memmap.hpp' namespace 'pydynd':
+    _array array_memmap(string, _type, string, intptr_t, string) except +translate_exception
+    void array_madvise(_array&, string) except +translate_exception
+    void array_save(string, _array&) except +translate_exception
+    _array array_load(string, bint) except +translate_exception
+    _array array_pack(_array&) except +translate_exception
+    _array array_unpack(_type&, object) except +translate_exception
+
+cdef extern from 'json_lines.hpp' namespace 'pydynd':
+    eval_context eval_context_from_pyobject(object) except +translate_exception
+    _array parse_json_lines_cpp 'pydynd::parse_json_lines'(_type&, const char *, const char *,
+                                                           const eval_context *,
+                                                           intptr_t) nogil except +translate_exception
+
+    cdef cppclass json_lines_builder:
+        json_lines_builder(_type&)
+        void append(_array&) except +translate_exception
+        _array get() except +translate_exception
+
+cdef extern from 'json_index.hpp' namespace 'pydynd':
+    void json_structural_index(const char *, const char *, vector[uint32_t]&) nogil except +translate_exception
+    const char *json_structural_index_backend()
+    void set_json_structural_index_backend(string) except +translate_exception
+
+cdef extern from 'utf8.hpp' namespace 'pydynd':
+    intptr_t utf8_length(const char *, const char *) nogil
+    const char *utf8_backend()
+    void set_utf8_backend(string) except +translate_exception
+
+cdef extern from 'json_formatter.hpp' namespace 'pydynd':
+    void format_json(_array&, string&) nogil except +translate_exception
+    void format_json_rows(_array&, intptr_t, intptr_t, string&, string&) nogil except +translate_exception
+
+cdef extern from 'csv_reader.hpp' namespace 'pydynd':
+    cdef struct csv_dialect:
+        char delimiter
+        char quote
+        cpp_bool header
+
+    _type discover_csv(const char *, const char *, const csv_dialect&, intptr_t) nogil except +translate_exception
+    _array parse_csv(_type&, const char *, const char *, const csv_dialect&,
+                     intptr_t) nogil except +translate_exception
+
+cdef extern from 'arrow_c_data.hpp' namespace 'pydynd':
+    object array_arrow_schema_capsule(_array&) except +translate_exception
+    object array_arrow_capsules(_array&, object) except +translate_exception
+    _array array_from_arrow_capsules(object, object) except +translate_exception
+
+cdef extern from 'array_dlpack.hpp' namespace 'pydynd':
+    object array_to_dlpack(_array&, bint, bint) except +translate_exception
+    _array array_from_dlpack(object) except +translate_exception
+
+cdef extern from 'array_ragged.hpp' namespace 'pydynd':
+    void array_to_ragged(_array&, _array&, _array&) except +translate_exception
+    _array array_from_ragged(_array&, _array&) except +translate_exception
+    _array array_to_padded(_array&, _array&, intptr_t, bint, bint, _array*) except +translate_exception
+
+cdef extern from 'arrow_ipc.hpp' namespace 'pydynd':
+    cdef cppclass arrow_ipc_reader:
+        arrow_ipc_reader(string) except +translate_exception
+        intptr_t get_batch_count()
+        intptr_t get_column_count()
+        const string& get_column_name(intptr_t)
+        _array read_column(intptr_t, intptr_t) except +translate_exception
+
+cdef extern from 'shared_memory.hpp' namespace 'pydynd':
+    _array array_empty_shared(_type&) except +translate_exception
+    string array_shared_name(_array&) except +translate_exception
+    _array array_attach_shared(string, bint) except +translate_exception
+
 # Work around Cython misparsing various types when
 # they are used as template parameters.
 ctypedef long long longlong
@@ -87,7 +180,8 @@ init_array_from_py()
 
 cdef class array(object):
     """
-    nd.array(obj=None, dtype=None, type=None, access=None)
+    nd.array(obj=None, dtype=None, type=None, access=None, categorical=None,
+             max_categories=65536)
 
     Create a dynd array out of the provided object.
 
@@ -96,10 +190,12 @@ cdef class array(object):
     NumPy's _array, but has its dimensional structure encoded
     in the dynd type, along with the element type.
 
-    When given a NumPy array, the resulting dynd array is a view
-    into the NumPy array data. When given lists of Python object,
-    an attempt is made to deduce an appropriate dynd type for
-    the array, and a conversion is made if possible, or an
+    When given a NumPy array, a dynd array or another object supporting
+    the buffer protocol, the resulting dynd array is a view into its data,
+    unless a `type` requiring a conversion is provided, in which case the
+    data is converted directly into a new array. When given lists of
+    Python objects, an attempt is made to deduce an appropriate dynd
+    type for the array, and a conversion is made if possible, or an
     exception is raised.
 
     Parameters
@@ -128,6 +224,17 @@ cdef class array(object):
         The default is immutable, or to inherit the access control
         of the object being viewed if it is an object supporting
         the buffer protocol.
+    categorical: 'auto', optional
+        If 'auto', each string of the type converted from Python objects
+        is dictionary encoded into a categorical type of its distinct
+        values, sorted, with the array holding their integer codes. A
+        string with more than `max_categories` distinct values, or with
+        any value that isn't a Python string, stays a string. Options of
+        strings are never encoded. Data which is viewed, such as a NumPy
+        array, is unaffected.
+    max_categories: int, optional
+        The largest number of categories of a string when `categorical`
+        is 'auto'. The default is 65536.
 
     Examples
     --------
@@ -145,14 +252,28 @@ cdef class array(object):
              type="2 * date")
     """
 
-    def __init__(self, value = None, type = None):
+    def __init__(self, value = None, type = None, categorical = None,
+                 intptr_t max_categories = 65536):
+
+        if categorical is not None and categorical != 'auto':
+            raise ValueError("categorical must be None or 'auto', not %r" % (categorical,))
 
         if value is None and type is None:
             return
 
         cdef _type dst_tp
+        # Array data from dynd, NumPy or the buffer protocol is viewed
+        # rather than copied element by element through Python objects.
+        cdef _array src = _view_array_data(value)
         if type is None:
+            if not src.is_null():
+                self.v = src
+                return
             dst_tp = cpp_type_for(value)
+            if categorical is not None:
+                self.v = array_from_py_categorical(value, dst_tp, max_categories)
+                if not self.v.is_null():
+                    return
             self.v = cpp_empty(dst_tp)
             self.v.assign(pyobject_array(value))
         else:
@@ -160,6 +281,18 @@ cdef class array(object):
             if (not isinstance(type, ndt_type)):
                 type = ndt_type(type)
             dst_tp = dynd_ndt_type_to_cpp(type)
+            if not src.is_null():
+                if src.get_type() == dst_tp:
+                    self.v = src
+                else:
+                    # A single typed conversion from the viewed data
+                    self.v = cpp_empty(dst_tp)
+                    self.v.assign(src)
+                return
+            if categorical is not None:
+                self.v = array_from_py_categorical(value, dst_tp, max_categories)
+                if not self.v.is_null():
+                    return
             self.v = cpp_empty(dst_tp)
             self.v.assign(pyobject_array(value))
 
@@ -198,9 +331,9 @@ cdef class array(object):
             result.v = self.v.get_dtype()
             return result
 
-    def to(self, tp = None):
+    def to(self, tp = None, strings = None):
         """
-        nd.to(tp)
+        nd.to(tp, strings=None)
 
         Evaluates the dynd array, and converts it into a NumPy object.
 
@@ -212,6 +345,12 @@ cdef class array(object):
             If true, allows a copy to be made when the array types
             can't be directly viewed as a NumPy array, but with a
             data-preserving copy they can be.
+        strings : 'U', 'S' or 'T', optional
+            Converts an array of strings into NumPy strings of this kind
+            instead of an object array, without creating a Python string
+            per element: 'U' and 'S' are as wide as the longest string in
+            code points or in UTF-8 bytes, and 'T' is the StringDType of
+            NumPy 2.
 
         Examples
         --------
@@ -224,8 +363,18 @@ cdef class array(object):
         >>> nd.as_numpy(a)
         array([[1, 2, 3],
             [4, 5, 6]])
+        >>> nd.array(['a', 'bcd']).to(np.ndarray, strings='U')
+        array(['a', 'bcd'],
+              dtype='<U3')
         """
 
+        if strings is not None:
+            if tp is not _np.ndarray:
+                raise ValueError('strings can only be converted to numpy.ndarray')
+            if strings not in ('U', 'S', 'T'):
+                raise ValueError("strings must be 'U', 'S' or 'T', not %r" % (strings,))
+            return array_strings_as_numpy(self, ord(strings))
+
         try:
             import numpy as np
 
@@ -458,6 +607,85 @@ cdef class array(object):
         elif op == Py_GT:
             return dynd_nd_array_from_cpp(asarray(a0).v > asarray(a1).v)
 
+    property __array_interface__:
+        """
+        NumPy array interface, describing the data of the array as its
+        NumPy view does. Arrays which NumPy can't view raise
+        AttributeError, so that NumPy falls back to a copy.
+        """
+        def __get__(self):
+            view = _numpy_view(self)
+            if view is None:
+                raise AttributeError('dynd type %s has no NumPy array interface' % type_of(self))
+            return view.__array_interface__
+
+    def __array__(self, dtype=None, copy=None):
+        """
+        a.__array__(dtype=None, copy=None)
+        NumPy array protocol. Returns a view of the data when NumPy can
+        view it, which is made once and cached on the array, and a copy
+        otherwise, or when `copy` is True or `dtype` requires one. With
+        `copy` False, needing a copy raises ValueError.
+        """
+        view = _numpy_view(self)
+        if view is None:
+            if copy is False:
+                raise ValueError('cannot view dynd type %s as NumPy without a copy' % type_of(self))
+            result = _np.asarray(array_as_numpy(self, True))
+        elif copy:
+            return view.astype(view.dtype if dtype is None else dtype)
+        else:
+            # A new ndarray object, so that changes to its shape or flags
+            # don't reach the cached view
+            result = view.view()
+        if dtype is not None and result.dtype != _np.dtype(dtype):
+            if copy is False:
+                raise ValueError('cannot convert dynd type %s to NumPy %s without a copy' %
+                                 (type_of(self), _np.dtype(dtype)))
+            result = result.astype(dtype)
+        return result
+
+    def __array_ufunc__(self, ufunc, method, *inputs, **kwargs):
+        """
+        NumPy ufunc protocol. Calls of ufuncs with a dynd callable of the
+        same name in the registry are computed by it, on the data of the
+        dynd arrays and views of the NumPy arrays, writing to `out` when
+        it is given. Other ufuncs, ufunc methods like reduce and other
+        keyword arguments are computed by NumPy on NumPy views.
+        """
+        out = kwargs.get('out', ())
+        for x in inputs + out:
+            if _defers_ufunc(x):
+                return NotImplemented
+
+        f = None
+        if method == '__call__' and len(out) <= 1 and all(kw == 'out' for kw in kwargs):
+            f = _ufunc_callable(ufunc, inputs)
+        if f is None:
+            return _numpy_ufunc(ufunc, method, inputs, kwargs)
+
+        args = [dynd_nd_array_from_cpp(as_cpp_array(x)) for x in inputs]
+        if not out:
+            return f(*args)
+        _call_into(f, args, dynd_nd_array_from_cpp(as_cpp_array(out[0])))
+        return out[0]
+
+    def __array_function__(self, func, types, args, kwargs):
+        """
+        NumPy function protocol. The NumPy functions dynd implements are
+        computed by dynd when their first argument is a dynd array, and
+        the others by NumPy on NumPy views of the dynd arrays.
+        """
+        for t in types:
+            if not issubclass(t, (array, _np.ndarray)):
+                return NotImplemented
+
+        impl = _array_functions.get(func)
+        if (impl is not None and args and isinstance(args[0], array) and
+                len(args) - 1 <= len(impl[1]) and all(kw in impl[1] for kw in kwargs)):
+            return impl[0](*args, **kwargs)
+        return func(*_numpy_args(args), **_numpy_args(kwargs))
+
     def __getbuffer__(array self, Py_buffer* buffer, int flags):
         # Docstring triggered Cython bug (fixed in master), so it's commented out
         #"""PEP 3118 buffer protocol"""
@@ -468,6 +696,18 @@ cdef class array(object):
         #"""PEP 3118 buffer protocol"""
         array_releasebuffer_pep3118(self, buffer)
 
+    def __reduce_ex__(self, protocol):
+        # The data is packed as by nd.save. With protocol 5, it is handed to
+        # pickle as a buffer, which may be sent out-of-band, and arrays of
+        # plain data are unpickled as views of the received buffer when it
+        # is writable. Other payloads, such as bytes, are copied from.
+        data = dynd_nd_array_from_cpp(array_pack(self.v))
+        if protocol >= 5 and _PickleBuffer is not None:
+            data = _PickleBuffer(data)
+        else:
+            data = memoryview(data).tobytes()
+        return _array_unpack, (str(type_of(self)), data)
+
     def cast(array self, tp):
         """
         a.cast(type)
@@ -509,13 +749,99 @@ cdef class array(object):
         """
         return dynd_nd_array_from_cpp(dynd_nd_array_to_cpp(self).eval())
 
-    def sum(self, axis = None):
-      from .. import nd
+    def sum(self, axis = None, intptr_t block_size = 4096, intptr_t nthreads = 1):
+        """
+        a.sum(axis=None, block_size=4096, nthreads=1)
+        Sums the elements of the dynd array using pairwise summation,
+        which keeps the rounding error growing with the logarithm of the
+        number of elements instead of linearly.
+        Parameters
+        ----------
+        axis : int, tuple or list of ints, optional
+            The axes to sum over. By default, all the axes are summed.
+        block_size : int, optional
+            For types without a direct pairwise loop, the number of
+            indices of the largest summed dimension handed to each
+            call of nd.sum before the partial sums are combined.
+        nthreads : int, optional
+            The number of threads to sum on. The result is identical
+            for any number of threads.
+        """
+        from .. import nd
+
+        cdef vector[intptr_t] axes = reduction_axes_from_pyobject(axis, self.v.get_ndim())
+        cdef _callable reduce = dynd_nd_callable_to_cpp(nd.sum)
+        cdef _callable combine = dynd_nd_callable_to_cpp(nd.add)
+        cdef _array res
+        if nthreads > 1:
+            with nogil:
+                res = pairwise_sum(reduce, combine, self.v, axes, block_size, nthreads)
+        else:
+            res = pairwise_sum(reduce, combine, self.v, axes, block_size, 1)
+
+        return dynd_nd_array_from_cpp(res)
+
+    def to_json_lines(self, stream=None, intptr_t chunk_rows=65536):
+        """
+        a.to_json_lines(stream=None, chunk_rows=65536)
+        Formats the elements of the outermost dimension as newline
+        delimited JSON, one element per line, like nd.to_json does for
+        the whole array.
+        Parameters
+        ----------
+        stream : file, optional
+            A file opened in text or binary mode to write to, a chunk of
+            rows at a time. If it is None, the text is returned as a str.
+        chunk_rows : int, optional
+            The number of rows formatted at a time for a stream.
+        Examples
+        --------
+        >>> from dynd import nd
+        >>> print(nd.array([{'x': 1}, {'x': 2}], type='2 * {x: int32}').to_json_lines())
+        {"x":1}
+        {"x":2}
+        <BLANKLINE>
+        """
+        if self.v.get_ndim() == 0:
+            raise TypeError('cannot format a scalar as JSON lines, it has no rows')
+        return _to_json(self.v, stream, True, chunk_rows)
+
+    def __dlpack__(self, *, stream=None, max_version=None, dl_device=None, copy=None):
+        """
+        DLPack protocol. Returns a capsule of a DLPack tensor viewing the
+        array, which must have fixed dimensions of a builtin numeric type.
+        A DLPack 1.0 tensor is returned if `max_version` allows it, and
+        read-only arrays can only be exported as one, or copied.
+        """
+        if stream is not None:
+            raise ValueError('dynd arrays are on the CPU, which has no streams')
+        if dl_device is not None and tuple(dl_device) != self.__dlpack_device__():
+            raise BufferError('dynd arrays can only be exported to the CPU')
+        versioned = max_version is not None and max_version[0] >= 1
+        return array_to_dlpack(self.v, versioned, bool(copy))
+
+    def __dlpack_device__(self):
+        """
+        DLPack protocol. dynd arrays are on the CPU, which is device 0
+        of kDLCPU (1).
+        """
+        return (1, 0)
 
-      if (axis is None):
-        return nd.sum(self)
+    def __arrow_c_schema__(self):
+        """
+        Arrow PyCapsule interface. Returns an "arrow_schema" capsule
+        of the element type of the outermost dimension.
+        """
+        return array_arrow_schema_capsule(self.v)
 
-      return nd.sum(self, axes = [axis])
+    def __arrow_c_array__(self, requested_schema=None):
+        """
+        Arrow PyCapsule interface. Returns a tuple of "arrow_schema" and
+        "arrow_array" capsules of the elements of the outermost dimension,
+        converted to `requested_schema` first if it is a different type.
+        Contiguous numbers are exported without copying.
+        """
+        return array_arrow_capsules(self.v, requested_schema)
 
     def ucast(array self, dtype, ssize_t replace_ndim=0):
         """
@@ -597,6 +923,130 @@ cdef _type _type_from_pyarr_wrapper(PyObject *a) nogil:
 
 _register_nd_array_type_deduction(<PyTypeObject*>array, &_type_from_pyarr_wrapper)
 
+cdef object _numpy_view(array a):
+    """
+    Returns the cached NumPy view of the data of `a`, or None if NumPy
+    can't view it. The base of the view is another wrapper of the same
+    array, so that caching it doesn't make a reference cycle.
+    """
+    if a._numpy is None:
+        try:
+            a._numpy = array_as_numpy(dynd_nd_array_from_cpp(a.v), False)
+        except TypeError:
+            a._numpy = False
+    return a._numpy if a._numpy is not False else None
+
+# NumPy ufuncs whose dynd callable has another name. NumPy's remainder
+# rounds toward negative infinity, unlike nd.mod, so it stays in NumPy.
+_ufunc_callable_names = {'negative': 'minus', 'positive': 'plus', 'invert': 'bitwise_not',
+                         'power': 'pow', 'true_divide': 'divide'}
+
+cdef bint _defers_ufunc(object x):
+    # Whether `x` overrides ufuncs itself, so that its __array_ufunc__ has
+    # to be tried instead
+    return (hasattr(type(x), '__array_ufunc__') and
+            not isinstance(x, (array, _np.ndarray, _np.generic)))
+
+cdef object _numpy_kind(object x):
+    if isinstance(x, array):
+        try:
+            return dtype_of(x).as_numpy().kind
+        except TypeError:
+            return 'O'
+    return _np.result_type(x).kind
+
+cdef object _ufunc_callable(object ufunc, tuple inputs):
+    """
+    Returns the dynd callable computing a call of `ufunc` on `inputs`, or
+    None if NumPy has to compute it.
+    """
+    from .. import nd
+
+    if ufunc.nout != 1:
+        return None
+    name = ufunc.__name__
+    if name in ('divide', 'true_divide'):
+        # NumPy divides integers in floating point, while dynd doesn't
+        for x in inputs:
+            if _numpy_kind(x) not in ('f', 'c'):
+                return None
+    f = getattr(nd, _ufunc_callable_names.get(name, name), None)
+    return f if isinstance(f, callable) else None
+
+cdef object _call_into(object f, list args, array dst):
+    """
+    Writes the result of `f` on `args` to `dst`, directly when the result
+    has the type of `dst`, and through a temporary otherwise.
+    """
+    try:
+        prepared = f.prepare(*args, out=dst)
+    except TypeError:
+        dst.v.assign(as_cpp_array(f(*args)))
+    else:
+        prepared(*args)
+
+cdef object _numpy_args(object args):
+    # Replaces the dynd arrays in the arguments of a NumPy function, which
+    # may be nested in lists and tuples like for concatenate, with their
+    # NumPy views or copies
+    if isinstance(args, array):
+        return args.__array__()
+    if isinstance(args, (list, tuple)):
+        return type(args)([_numpy_args(x) for x in args])
+    if isinstance(args, dict):
+        return {k: _numpy_args(x) for k, x in args.items()}
+    return args
+
+cdef object _numpy_ufunc(object ufunc, object method, tuple inputs, dict kwargs):
+    if 'out' in kwargs:
+        # Results have to be written to the dynd arrays themselves
+        kwargs['out'] = tuple([x.__array__(copy=False) if isinstance(x, array) else x
+                               for x in kwargs['out']])
+    return getattr(ufunc, method)(*_numpy_args(inputs), **kwargs)
+
+def _array_sum(a, axis=None):
+    return a.sum(axis)
+
+# The NumPy functions computed by dynd, with the parameters they take after
+# the array
+_array_functions = {_np.sum: (_array_sum, ('axis',)),
+                    _np.ndim: (lambda a: a.ndim, ()),
+                    _np.shape: (lambda a: a.shape, ())}
+
+cdef _array _view_array_data(object obj) except *:
+    """
+    Views the data of a dynd array, a NumPy array or another object
+    exporting the buffer protocol or the NumPy array interface as a dynd
+    array, without copying it.
+    Returns a null array for any other object, for bytes, string and
+    NumPy scalar objects, which are scalars to dynd, and for NumPy arrays
+    containing Python objects, which need to be converted one by one, or
+    of dtypes dynd can't view. Data in a non-native byte order or
+    unaligned is copied by NumPy first.
+    """
+    if isinstance(obj, array):
+        return (<array> obj).v
+    if not isinstance(obj, _np.ndarray):
+        if ((not PyObject_CheckBuffer(obj) and not hasattr(obj, '__array_interface__')) or
+                isinstance(obj, (bytes, bytearray, unicode, _np.generic))):
+            return _array()
+        try:
+            # NumPy reads any buffer format dynd can represent, and views
+            # the data described by an array interface
+            obj = _np.asarray(obj)
+        except (TypeError, ValueError):
+            return _array()
+    if obj.dtype.hasobject:
+        return _array()
+    if not obj.dtype.isnative or not obj.flags.aligned:
+        # dynd types are native and aligned, NumPy makes such a copy
+        obj = obj.astype(obj.dtype.newbyteorder('='))
+    try:
+        return array_from_numpy_array_cast(<PyObject*>obj, 0, 0)
+    except (TypeError, RuntimeError):
+        # A dtype dynd can't view, e.g. float16 or datetime64
+        return _array()
+
 cdef _array as_cpp_array(object obj) except *:
     """
     nd.as_cpp_array(obj)
@@ -605,17 +1055,26 @@ cdef _array as_cpp_array(object obj) except *:
     is already a DyND array, this is equivalent to calling
     dynd_nd_array_to_cpp(obj).
     """
-    # TODO: Remove lazy import since it's really only needed because of the weird
-    # boxing and unboxing used further down
-    from . import assign
     if _builtin_type(obj) is array:
         return dynd_nd_array_to_cpp(obj)
     elif _builtin_type(obj) is _np.ndarray:
         return array_from_numpy_array_cast(<PyObject*>obj, 0, 0)
-    # elif PyObject_CheckBuffer(obj):
-    #     TODO
+    # Python scalars are by far the most common arguments after arrays,
+    # and are written directly into a new scalar.
+    cdef _array out = array_from_pyscalar(obj)
+    if not out.is_null():
+        return out
+    if PyObject_CheckBuffer(obj) or hasattr(obj, '__array_interface__'):
+        out = _view_array_data(obj)
+        if not out.is_null():
+            return out
+    # The boxing and unboxing below relies on the pyobject assignment
+    # kernels, which are normally registered when dynd.nd.registry is
+    # imported.
+    if not _assign_initialized:
+        _registry_assign_init()
     cdef _type tp = cpp_type_for(obj)
-    cdef _array out = cpp_empty(tp)
+    out = cpp_empty(tp)
     out.assign(pyobject_array(obj))
     return out
 
@@ -919,6 +1378,10 @@ def empty(*args, **kwargs):
         are prepended to the following dtype.
     dtype : dynd type
         The dtype of the uninitialized array to create.
+    shared : bool, optional
+        If True, allocates the array in shared memory, which other
+        processes can attach to with nd.attach_shared. The type must
+        consist of fixed dimensions of plain data.
     Examples
     --------
     >>> from dynd import nd, ndt
@@ -931,6 +1394,8 @@ def empty(*args, **kwargs):
     """
     cdef size_t largs = len(args)
     cdef _array ret
+    if kwargs.get('shared', False):
+        return _empty_shared(args)
     if largs  == 1:
         # Only the full type is provided
         tp = args[0]
@@ -967,6 +1432,72 @@ def empty(*args, **kwargs):
         return dynd_nd_array_from_cpp(ret)
     raise TypeError('nd.empty() expected at least 1 positional argument, got 0')
 
+cdef object _empty_shared(tuple args):
+    if len(args) == 0:
+        raise TypeError('nd.empty() expected at least 1 positional argument, got 0')
+    tp = args[-1]
+    if _builtin_type(tp) in [int, long]:
+        raise ValueError('Data type must be explicitly specified. '
+                         'It cannot be provided as an integer.')
+    if len(args) > 1:
+        from ..ndt.type import make_fixed_dim
+        shape = args[0] if len(args) == 2 else args[:-1]
+        tp = make_fixed_dim(shape, tp)
+    return dynd_nd_array_from_cpp(array_empty_shared(as_cpp_type(tp)))
+
+def to_shared(a):
+    """
+    nd.to_shared(a)
+    Copies an array into a new array in shared memory, which other
+    processes can attach to with nd.attach_shared instead of copying
+    it. The shared memory is released once no array in any process is
+    attached to it anymore.
+    Parameters
+    ----------
+    a : dynd array
+        An array of fixed dimensions of plain data, such as numbers
+        and structs of them, but not strings or var dimensions.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> a = nd.to_shared(nd.array([1, 2, 3]))
+    >>> h = nd.shared_handle(a)
+    >>> nd.attach_shared(h)
+    nd.array([1, 2, 3],
+             type="3 * int32")
+    """
+    cdef array src = asarray(a)
+    cdef _array ret = array_empty_shared(src.v.get_type())
+    ret.assign(src.v)
+    return dynd_nd_array_from_cpp(ret)
+
+def shared_handle(array a):
+    """
+    nd.shared_handle(a)
+    Returns the name of the shared memory an array from
+    nd.empty(..., shared=True), nd.to_shared or nd.attach_shared is in.
+    Passing the name to nd.attach_shared, e.g. in a worker process,
+    views the same memory. The name is a short string, so it is cheap
+    to send between processes, but it doesn't keep the memory alive by
+    itself.
+    """
+    return array_shared_name(a.v)
+
+def attach_shared(handle, bint readonly=True):
+    """
+    nd.attach_shared(handle, readonly=True)
+    Views the array in shared memory named by a handle from
+    nd.shared_handle, without copying it. The memory stays alive until
+    every attached array, in every process, has gone away.
+    Parameters
+    ----------
+    handle : str
+        The name returned by nd.shared_handle.
+    readonly : bool, optional
+        Whether the returned array is readonly.
+    """
+    return dynd_nd_array_from_cpp(array_attach_shared(handle.encode('ascii'), readonly))
+
 def old_range(start=None, stop=None, step=None, dtype=None):
     """
     nd.old_range(stop, dtype=None)
@@ -1030,8 +1561,9 @@ def parse_json(tp, json, ectx=None):
         does not match this type, an error is raised during parsing.
     json : string or bytes
         String that contains the JSON to parse.
-    ectx : eval_context, optional
-        If provided an evaluation context to use when processing the JSON.
+    ectx : dict, optional
+        If provided, settings of the evaluation context to use when
+        processing the JSON, e.g. {'errmode': 'overflow'}.
     Examples
     --------
     >>> from dynd import nd, ndt
@@ -1052,6 +1584,606 @@ def parse_json(tp, json, ectx=None):
         result.v = dynd_parse_json_type(_py_type(tp).v, array(json).v, ectx)
         return result
 
+cdef _array _parse_json_chunk(_py_type tp, list lines, object ectx_obj, intptr_t nthreads) except *:
+    cdef bytes data = b'\n'.join(lines)
+    cdef const char *begin = data
+    cdef const char *end = begin + len(data)
+    cdef eval_context ectx = eval_context_from_pyobject(ectx_obj)
+    cdef _array res
+    with nogil:
+        res = parse_json_lines_cpp(tp.v, begin, end, &ectx, nthreads)
+    return res
+
+def _json_structural_index(data):
+    # The offsets of the structural characters in the bytes `data`, for
+    # testing the implementations of the index against each other
+    cdef bytes b = data
+    cdef const char *begin = b
+    cdef vector[uint32_t] out
+    json_structural_index(begin, begin + len(b), out)
+    return [out[i] for i in range(out.size())]
+
+def _json_index_backend(name=None):
+    # Selects the implementation of the structural index by name, or the
+    # one for the CPU with '', and returns the name of the one in use
+    if name is not None:
+        set_json_structural_index_backend(name.encode('ascii'))
+    return json_structural_index_backend()
+
+def _utf8_length(data):
+    # The number of code points of the UTF-8 bytes `data`, or -1 if they
+    # aren't valid UTF-8, for testing the implementations against each other
+    cdef bytes b = data
+    cdef const char *begin = b
+    return utf8_length(begin, begin + len(b))
+
+def _utf8_backend(name=None):
+    # Selects the implementation of the UTF-8 validation and transcoding by
+    # name, or the one for the CPU with '', and returns the name of the one
+    # in use
+    if name is not None:
+        set_utf8_backend(name.encode('ascii'))
+    return utf8_backend()
+
+def _json_line_chunks(source, intptr_t chunk_rows):
+    if chunk_rows <= 0:
+        raise ValueError('chunk_rows must be positive')
+    lines = []
+    for line in source:
+        if isinstance(line, unicode):
+            line = (<unicode>line).encode('utf-8')
+        lines.append(line)
+        if len(lines) == chunk_rows:
+            yield lines
+            lines = []
+    if lines:
+        yield lines
+
+def parse_json_lines(source, type, intptr_t chunk_rows=65536, ectx=None, intptr_t nthreads=1):
+    """
+    nd.parse_json_lines(source, type, chunk_rows=65536, ectx=None, nthreads=1)
+    Parses newline delimited JSON, with one value of the given type
+    per line, yielding an array of up to chunk_rows values at a time.
+    Only one chunk of the input is held in memory, and the GIL is
+    released while a chunk is parsed.
+    Rows of a struct type whose fields are booleans, numbers, strings
+    or optional booleans and numbers take a fast path, which finds
+    the structural characters of the chunk with SIMD instructions and
+    parses the rows straight into the result. Other types, and chunks
+    with any row the fast path doesn't handle, are parsed like
+    nd.parse_json.
+    Parameters
+    ----------
+    source : file or iterable
+        A file opened in text or binary mode, or any iterable of lines
+        as str or bytes. Blank lines are skipped.
+    type : dynd type
+        The type of the value on each line, usually a struct.
+    chunk_rows : int, optional
+        The number of lines parsed together.
+    ectx : dict, optional
+        Settings of the evaluation context, as for nd.parse_json.
+    nthreads : int, optional
+        The number of threads the fast path parses a chunk on.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> lines = ['{"x": 1, "y": "a"}', '{"x": 2, "y": "b"}', '{"x": 3, "y": "c"}']
+    >>> for chunk in nd.parse_json_lines(lines, '{x: int32, y: string}', chunk_rows=2):
+    ...     print(len(chunk))
+    2
+    1
+    """
+    tp = _py_type(type)
+    for lines in _json_line_chunks(source, chunk_rows):
+        yield dynd_nd_array_from_cpp(_parse_json_chunk(tp, lines, ectx, nthreads))
+
+def read_json_lines(source, type, intptr_t chunk_rows=65536, ectx=None, intptr_t nthreads=1):
+    """
+    nd.read_json_lines(source, type, chunk_rows=65536, ectx=None, nthreads=1)
+    Parses newline delimited JSON like nd.parse_json_lines, appending
+    the chunks to a single array of all the values. Its storage grows
+    geometrically, so the peak memory is about that of the result plus
+    one chunk.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> nd.read_json_lines(['[1, 2]', '[3]'], 'var * int32')
+    nd.array([[1, 2], [3]],
+             type="2 * var * int32")
+    """
+    cdef _py_type tp = _py_type(type)
+    cdef json_lines_builder *builder = new json_lines_builder(tp.v)
+    try:
+        for lines in _json_line_chunks(source, chunk_rows):
+            builder.append(_parse_json_chunk(tp, lines, ectx, nthreads))
+        return dynd_nd_array_from_cpp(builder.get())
+    finally:
+        del builder
+
+cdef _to_json(_array a, stream, bint lines, intptr_t chunk_rows):
+    cdef string out
+    cdef string separator = b'\n' if lines else b','
+    cdef intptr_t begin = 0, end, size = 0
+    if chunk_rows <= 0:
+        raise ValueError('chunk_rows must be positive')
+    if a.get_ndim() > 0:
+        size = a.get_dim_size()
+
+    if stream is None or (a.get_ndim() == 0 and not lines):
+        with nogil:
+            if lines:
+                format_json_rows(a, 0, size, separator, out)
+            else:
+                format_json(a, out)
+        result = PyBytes_FromStringAndSize(out.data(), out.size()).decode('utf-8')
+        if stream is None:
+            return result
+        stream.write(result if isinstance(stream, io.TextIOBase) else result.encode('utf-8'))
+        return
+
+    # Write the rows a chunk at a time, so only one chunk of the text is
+    # held in memory
+    text = isinstance(stream, io.TextIOBase)
+    if not lines:
+        stream.write(u'[' if text else b'[')
+    while begin < size:
+        end = min(begin + chunk_rows, size)
+        out.clear()
+        with nogil:
+            format_json_rows(a, begin, end, separator, out)
+        if not lines and end == size:
+            # Drop the separator after the last row
+            out.resize(out.size() - 1)
+        chunk = PyBytes_FromStringAndSize(out.data(), out.size())
+        stream.write(chunk.decode('utf-8') if text else chunk)
+        begin = end
+    if not lines:
+        stream.write(u']' if text else b']')
+
+def to_json(a, stream=None, intptr_t chunk_rows=65536):
+    """
+    nd.to_json(a, stream=None, chunk_rows=65536)
+    Formats an array as JSON, straight from its data into UTF-8 text,
+    without building Python objects. Dimensions are lists, structs are
+    objects and unavailable options are null, as are NaN and infinite
+    floats. Floats are written with the fewest digits that read back
+    as the same value. The GIL is released while formatting.
+    Parameters
+    ----------
+    a : dynd array
+        The array to format.
+    stream : file, optional
+        A file opened in text or binary mode to write to, a chunk of
+        rows of the outermost dimension at a time. If it is None, the
+        text is returned as a str.
+    chunk_rows : int, optional
+        The number of rows formatted at a time for a stream.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> nd.to_json(nd.array([[1.5, 2], [3, 0.1]]))
+    '[[1.5,2.0],[3.0,0.1]]'
+    """
+    return _to_json(asarray(a).v, stream, False, chunk_rows)
+
+def memmap(path, type, mode='r', intptr_t offset=0, advice=None):
+    """
+    nd.memmap(path, type, mode='r', offset=0, advice=None)
+    Maps a binary file into memory, and returns a dynd array viewing
+    its data, without reading it. The pages of the file are read by the
+    operating system as they are accessed, and the mapping is released
+    once no array refers to it anymore.
+    Parameters
+    ----------
+    path : str
+        The path of the file.
+    type : dynd type
+        The type of the data, which must consist of fixed dimensions of
+        plain data in C order. A leading symbolic dimension, as in
+        'Fixed * float64', gets the size filling the rest of the file.
+    mode : 'r', 'r+' or 'c', optional
+        Maps the file readonly ('r'), writable with changes written
+        back to the file ('r+'), or writable with changes kept private
+        to the mapping ('c').
+    offset : int, optional
+        The byte offset in the file at which the data starts.
+    advice : 'normal', 'sequential', 'random', 'willneed' or 'dontneed', optional
+        A hint on how the data is going to be accessed, as for nd.madvise.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> import numpy as np
+    >>> np.arange(4, dtype=np.float64).tofile('data.bin')
+    >>> nd.memmap('data.bin', 'Fixed * float64')
+    nd.array([0, 1, 2, 3],
+             type="4 * float64")
+    """
+    if isinstance(path, unicode):
+        path = path.encode(sys.getfilesystemencoding())
+    if advice is None:
+        advice = ''
+    return dynd_nd_array_from_cpp(array_memmap(path, _py_type(type).v, mode.encode('ascii'), offset,
+                                               advice.encode('ascii')))
+
+def madvise(array a, advice):
+    """
+    nd.madvise(a, advice)
+    Tells the operating system how the data of a memory mapped array,
+    as from nd.memmap, is going to be accessed, so that it can read
+    ahead or drop the pages accordingly. This is only a hint, and does
+    nothing on platforms without posix_madvise.
+    Parameters
+    ----------
+    a : dynd array
+        An array with fixed dimensions.
+    advice : 'normal', 'sequential', 'random', 'willneed' or 'dontneed'
+        Whether the data will be read in order, in random order, soon,
+        or not anymore.
+    """
+    array_madvise(a.v, advice.encode('ascii'))
+
+def read_csv(path, type=None, delimiter=None, quotechar='"', bint header=True, intptr_t sample_rows=1000,
+             intptr_t nthreads=1):
+    """
+    nd.read_csv(path, type=None, delimiter=None, quotechar='"', header=True, sample_rows=1000, nthreads=1)
+    Reads a CSV or TSV file into a one dimensional array of structs. The
+    file is memory mapped and parsed straight into the result on up to
+    `nthreads` threads, without building Python objects, and the GIL is
+    released while parsing.
+    Parameters
+    ----------
+    path : str
+        The path of the file.
+    type : dynd type, optional
+        The type of the rows, a struct whose fields are booleans, numbers
+        or strings, or options of them. With a header, the columns are
+        matched to the fields by name, and the other columns are skipped.
+        If it is None, the type is discovered from the first rows.
+    delimiter : str, optional
+        The character between fields. If it is None, it is a tab for
+        files ending in .tsv or .tab, and a comma otherwise.
+    quotechar : str, optional
+        The character quoting fields which hold delimiters or newlines.
+        Doubled inside a quoted field, it stands for one.
+    header : bool, optional
+        Whether the first row holds the column names.
+    sample_rows : int, optional
+        The number of rows the type is discovered from.
+    nthreads : int, optional
+        The number of threads to parse on.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> with open('data.csv', 'w') as f:
+    ...     _ = f.write('x,y\n1,a\n2,\n')
+    >>> nd.read_csv('data.csv')
+    nd.array([{'x': 1, 'y': 'a'}, {'x': 2, 'y': None}],
+             type="2 * {x: int64, y: ?string}")
+    """
+    cdef csv_dialect dialect
+    cdef array data
+    cdef const char *begin = NULL
+    cdef intptr_t size = 0
+    cdef _type tp
+    cdef _array res
+    if delimiter is None:
+        delimiter = '\t' if os.path.splitext(path)[1].lower() in ('.tsv', '.tab') else ','
+    if len(delimiter) != 1 or ord(delimiter) > 127 or len(quotechar) != 1 or ord(quotechar) > 127:
+        raise ValueError('delimiter and quotechar must be single ASCII characters')
+    if sample_rows <= 0:
+        raise ValueError('sample_rows must be positive')
+    dialect.delimiter = ord(delimiter)
+    dialect.quote = ord(quotechar)
+    dialect.header = header
+
+    if os.path.getsize(path) > 0:
+        # The text is parsed in place, and stays mapped while `data` lives
+        data = memmap(path, 'Fixed * uint8', advice='sequential')
+        begin = data.v.cdata()
+        size = data.v.get_dim_size()
+    if type is None:
+        with nogil:
+            tp = discover_csv(begin, begin + size, dialect, sample_rows)
+    else:
+        tp = _py_type(type).v
+    with nogil:
+        res = parse_csv(tp, begin, begin + size, dialect, nthreads)
+    return dynd_nd_array_from_cpp(res)
+
+def from_arrow(source, array_capsule=None):
+    """
+    nd.from_arrow(source, array_capsule=None)
+    Imports an Arrow array through the Arrow C Data Interface, without
+    depending on pyarrow. Arrays of numbers without nulls, and lists of
+    them, are viewed read-only without copying, and other arrays are
+    copied. Scalars with nulls become option types.
+    Parameters
+    ----------
+    source : object
+        An object implementing `__arrow_c_array__`, such as a pyarrow
+        array, or a (schema, array) tuple of capsules, or an
+        "arrow_schema" capsule.
+    array_capsule : capsule, optional
+        The "arrow_array" capsule, when `source` is a schema capsule.
+    Examples
+    --------
+    >>> import pyarrow as pa
+    >>> from dynd import nd
+    >>> nd.from_arrow(pa.array([1, None, 3]))
+    nd.array([1, None, 3],
+             type="3 * ?int64")
+    """
+    if array_capsule is None:
+        if hasattr(source, '__arrow_c_array__'):
+            source = source.__arrow_c_array__()
+        source, array_capsule = source
+    return from_arrow_capsule(source, array_capsule)
+
+def from_arrow_capsule(schema_capsule, array_capsule):
+    """
+    nd.from_arrow_capsule(schema_capsule, array_capsule)
+    Imports an Arrow array from its "arrow_schema" and "arrow_array"
+    capsules, like nd.from_arrow does for objects implementing
+    `__arrow_c_array__`. The array capsule is consumed, and the result
+    keeps the Arrow array alive while it views its data.
+    Examples
+    --------
+    >>> import pyarrow as pa
+    >>> from dynd import nd
+    >>> nd.from_arrow_capsule(*pa.array([1, 2, 3]).__arrow_c_array__())
+    nd.array([1, 2, 3],
+             type="3 * int64")
+    """
+    return dynd_nd_array_from_cpp(array_from_arrow_capsules(schema_capsule, array_capsule))
+
+def from_dlpack(x):
+    """
+    nd.from_dlpack(x)
+    Views a CPU tensor of another library, like PyTorch or JAX, as a
+    dynd array through DLPack, without copying. The tensor is kept alive
+    until the last view of it goes away.
+    Parameters
+    ----------
+    x : object
+        An object implementing `__dlpack__`, or a "dltensor" capsule
+        which wasn't used yet. Its elements must be of a builtin numeric
+        type.
+    Examples
+    --------
+    >>> import numpy as np
+    >>> from dynd import nd
+    >>> nd.from_dlpack(np.arange(3))
+    nd.array([0, 1, 2],
+             type="3 * int64")
+    """
+    if hasattr(x, '__dlpack__'):
+        if hasattr(x, '__dlpack_device__') and x.__dlpack_device__()[0] != 1:
+            raise BufferError('nd.from_dlpack can only view tensors on the CPU')
+        try:
+            x = x.__dlpack__(max_version=(1, 0))
+        except TypeError:
+            # Producers from before DLPack 1.0 take no max_version
+            x = x.__dlpack__()
+    return dynd_nd_array_from_cpp(array_from_dlpack(x))
+
+def ragged_to_numpy(a):
+    """
+    nd.ragged_to_numpy(a)
+    Splits a ragged array of type "N * var * T" into the NumPy arrays of
+    its values and of the offsets of its elements into them, which is the
+    layout of Arrow lists and of many other ragged array libraries.
+    The values are a view of the array when its elements follow each
+    other in memory, as for arrays made by nd.ragged_from_numpy, and are
+    compacted into a new array otherwise.
+    Parameters
+    ----------
+    a : dynd array
+        An array of type "N * var * T", where T is a builtin type or fixed
+        dimensions of one.
+    Returns
+    -------
+    (values, offsets) : tuple of numpy.ndarray
+        The values, with the elements of the var dimension concatenated
+        along their first dimension, and the N + 1 int64 offsets at which
+        the elements begin and end.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> values, offsets = nd.ragged_to_numpy(nd.array([[1.0, 2.0], [], [3.0]]))
+    >>> values
+    array([ 1.,  2.,  3.])
+    >>> offsets
+    array([0, 2, 2, 3])
+    """
+    cdef _array values, offsets
+    array_to_ragged(as_cpp_array(a), values, offsets)
+    return (array_as_numpy(dynd_nd_array_from_cpp(values), False),
+            array_as_numpy(dynd_nd_array_from_cpp(offsets), False))
+
+def ragged_from_numpy(values, offsets):
+    """
+    nd.ragged_from_numpy(values, offsets)
+    Constructs a ragged array of type "N * var * T" viewing `values`,
+    whose element i is values[offsets[i]:offsets[i + 1]]. Only the
+    bounds of the elements are stored, the values aren't copied.
+    Parameters
+    ----------
+    values : array_like
+        An array, like a NumPy array, whose first dimension holds the
+        values of all the elements one after the other.
+    offsets : array_like
+        A one dimensional array of N + 1 nondecreasing integer offsets
+        into the first dimension of `values`.
+    Examples
+    --------
+    >>> import numpy as np
+    >>> from dynd import nd
+    >>> nd.ragged_from_numpy(np.arange(3.0), [0, 2, 2, 3])
+    nd.array([[0, 1], [], [2]],
+             type="3 * var * float64")
+    """
+    return dynd_nd_array_from_cpp(array_from_ragged(as_cpp_array(values),
+                                                    as_cpp_array(offsets)))
+
+def to_padded(a, fill=0, maxlen=None, return_mask=True, align='left', truncate='end'):
+    """
+    nd.to_padded(a, fill=0, maxlen=None, return_mask=True, align='left', truncate='end')
+    Copies a ragged array of type "N * var * T" into a dense array of
+    type "N * maxlen * T", padding the rows after the values of shorter
+    elements with `fill`. The result and the mask can be viewed by NumPy
+    without copying.
+    Parameters
+    ----------
+    a : dynd array
+        An array of type "N * var * T", where T is a builtin type or fixed
+        dimensions of one.
+    fill : object, optional
+        The value of the padding.
+    maxlen : int, optional
+        The length of the rows. By default, it is the length of the
+        longest element. Longer elements are truncated.
+    return_mask : bool, optional
+        Whether to also return a boolean mask of the same shape, which is
+        True where the result holds a value of `a`.
+    align : 'left' or 'right', optional
+        Whether the values go at the start of the rows, with the padding
+        after them, or at their end.
+    truncate : 'end' or 'start', optional
+        Whether elements longer than `maxlen` lose their last or their
+        first values.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> padded, mask = nd.to_padded(nd.array([[1, 2], [3]]))
+    >>> padded
+    nd.array([[1, 2], [3, 0]],
+             type="2 * 2 * int32")
+    >>> mask
+    nd.array([[ True,  True], [ True, False]],
+             type="2 * 2 * bool")
+    """
+    if align not in ('left', 'right'):
+        raise ValueError("align must be 'left' or 'right', not %r" % (align,))
+    if truncate not in ('start', 'end'):
+        raise ValueError("truncate must be 'start' or 'end', not %r" % (truncate,))
+    if maxlen is not None and maxlen < 0:
+        raise ValueError('maxlen must be nonnegative, not %d' % maxlen)
+
+    cdef _array mask
+    padded = dynd_nd_array_from_cpp(array_to_padded(
+        as_cpp_array(a), as_cpp_array(fill), -1 if maxlen is None else maxlen,
+        align == 'right', truncate == 'start', &mask if return_mask else NULL))
+    if return_mask:
+        return padded, dynd_nd_array_from_cpp(mask)
+    return padded
+
+def read_arrow(path, columns=None, batch=None):
+    """
+    nd.read_arrow(path, columns=None, batch=None)
+    Reads the columns of an uncompressed Arrow IPC file, also known as
+    a Feather v2 file, without depending on pyarrow. The file is memory
+    mapped, and columns of numbers without nulls, and lists and fixed
+    size lists of them, are read-only views of it. Other columns, like
+    strings, structs and those with nulls, are copied out of it.
+    Parameters
+    ----------
+    path : str
+        The path of the file.
+    columns : list of str, optional
+        The names of the columns to read. By default, all of them.
+    batch : int, optional
+        The index of the record batch to read. By default, all the
+        record batches are read, and the columns of a file holding more
+        than one are copied into one array each.
+    Returns
+    -------
+    dict
+        The one dimensional array of each column, by name. Struct
+        columns become arrays of structs and list columns arrays of
+        var dimensions.
+    Examples
+    --------
+    >>> import pyarrow as pa, pyarrow.feather as feather
+    >>> from dynd import nd
+    >>> feather.write_feather(pa.table({'x': [1, 2]}), 'data.feather', compression='uncompressed')
+    >>> nd.read_arrow('data.feather')['x']
+    nd.array([1, 2],
+             type="2 * int64")
+    """
+    if isinstance(path, unicode):
+        path = path.encode(sys.getfilesystemencoding())
+    cdef arrow_ipc_reader *reader = new arrow_ipc_reader(path)
+    cdef string name
+    try:
+        names = []
+        for i in range(reader.get_column_count()):
+            name = reader.get_column_name(i)
+            names.append(PyBytes_FromStringAndSize(name.data(), name.size()).decode('utf-8'))
+        if columns is None:
+            columns = names
+        if batch is None:
+            batch = -1
+        elif batch < 0 or batch >= reader.get_batch_count():
+            raise IndexError('record batch %d is out of bounds for a file with %d' %
+                             (batch, reader.get_batch_count()))
+        result = {}
+        for column in columns:
+            if column not in names:
+                raise KeyError(column)
+            result[column] = dynd_nd_array_from_cpp(reader.read_column(names.index(column), batch))
+        return result
+    finally:
+        del reader
+
+def _array_unpack(tp, data):
+    return dynd_nd_array_from_cpp(array_unpack(_py_type(tp).v, data))
+
+def save(path, array a):
+    """
+    nd.save(path, a)
+    Writes a dynd array to a binary file, which nd.load reads back.
+    The file holds the datashape of the array, its data, and the
+    elements of its var dimensions and the bytes of its strings, so
+    that arrays of any type built from dimensions, structs, tuples,
+    options, strings and plain data can be saved.
+    Parameters
+    ----------
+    path : str
+        The path of the file, which is overwritten if it exists.
+    a : dynd array
+        The array to save.
+    Examples
+    --------
+    >>> from dynd import nd
+    >>> nd.save('data.dynd', nd.array([[1, 2], [3]], type='2 * var * int32'))
+    >>> nd.load('data.dynd')
+    nd.array([[1, 2], [3]],
+             type="2 * var * int32")
+    """
+    if isinstance(path, unicode):
+        path = path.encode(sys.getfilesystemencoding())
+    array_save(path, a.v)
+
+def load(path, bint mmap=True):
+    """
+    nd.load(path, mmap=True)
+    Reads a dynd array from a file written by nd.save.
+    Parameters
+    ----------
+    path : str
+        The path of the file.
+    mmap : bool, optional
+        If True, and the type of the array has no strings, the result is
+        a readonly array viewing the memory mapped file. Only the offsets
+        of its var dimensions are read when loading, and the data is read
+        as it is accessed. Otherwise, the whole file is read into a new
+        array.
+    """
+    if isinstance(path, unicode):
+        path = path.encode(sys.getfilesystemencoding())
+    return dynd_nd_array_from_cpp(array_load(path, mmap))
+
 import operator
 
 def _validate_squeeze_index(i, sz):
@@ -1127,7 +2259,7 @@ def fields(array struct_array, *fields_list):
     result.v = nd_fields(struct_array.v, fields_list)
     return result
 
-from .callable cimport wrap
+from .callable cimport wrap, dynd_nd_callable_to_cpp
 
 # These are functions exported by the numpy interop stuff that are needed in
 # other modules. These are only here until we put together a better way of
@@ -1142,5 +2274,23 @@ cdef _callable _functional_apply(_type t, object o) except *:
 cdef extern from 'assign.hpp':
     void assign_init() except +translate_exception
 
+cdef bint _assign_initialized = False
+
 cdef void _registry_assign_init() except *:
-    assign_init()
+    global _assign_initialized
+    if not _assign_initialized:
+        assign_init()
+        _assign_initialized = True
+
+cdef array _functional_tree_reduction(_callable reduce, _callable combine, object a, object axes,
+                                      intptr_t block_size, intptr_t nthreads):
+    cdef _array arr = as_cpp_array(a)
+    cdef vector[intptr_t] c_axes = reduction_axes_from_pyobject(axes, arr.get_ndim())
+    cdef _array res
+    if nthreads > 1:
+        with nogil:
+            res = tree_reduction(reduce, combine, arr, c_axes, block_size, nthreads)
+    else:
+        res = tree_reduction(reduce, combine, arr, c_axes, block_size, 1)
+
+    return dynd_nd_array_from_cpp(res)
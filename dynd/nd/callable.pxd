@@ -1,8 +1,50 @@
+from libcpp.vector cimport vector
+
+from ..config cimport translate_exception
+from ..cpp.array cimport array as _array
 from ..cpp.callable cimport callable as _callable
+from ..cpp.type cimport type as _type
+
+cdef extern from 'kernel_cache.hpp':
+    # Only ever assigned, so its exact signature doesn't matter to Cython.
+    ctypedef void *vectorcallfunc
+
+cdef extern from 'kernel_cache.hpp' namespace 'pydynd':
+    cdef cppclass prepared_call:
+        prepared_call(const _callable &, const vector[_type] &, const vector[_array] &,
+                      const _array &) except +translate_exception
+
+        size_t get_narg()
+        const _type &get_dst_type()
+        const _type &get_src_type(size_t)
+
+        bint matches(size_t, const _array *)
+        bint matches_dst(const _array &)
+
+        void single(char *, char **) nogil except +translate_exception
+        _array call 'operator()'(size_t, const _array *) except +translate_exception
+        void call 'operator()'(const _array &, size_t, const _array *) except +translate_exception
+
+    cdef cppclass kernel_cache:
+        _array call(const _callable &, size_t, _array *) except +translate_exception
+        size_t size()
+        void clear()
 
 cdef api class callable(object)[object dynd_nd_callable_pywrapper,
                                 type dynd_nd_callable_pywrapper_type]:
     cdef _callable v
+    cdef kernel_cache cache
+    cdef vectorcallfunc vectorcall
+
+    cdef object _call(self, tuple args, dict kwargs)
+
+cdef class prepared(object):
+    cdef prepared_call *p
+    cdef readonly callable func
+    cdef readonly object out
+    cdef _array _out
+
+    cdef int single(self, char *dst, char **src) nogil except -1
 
 cdef api _callable dynd_nd_callable_to_cpp(callable) nogil except *
 # Provide an API for returning as a pointer since Cython can't handle
@@ -1,3 +1,4 @@
+from cpython.object cimport PyObject, PyTypeObject
 from libc.string cimport const_char
 from libcpp.vector cimport vector
 from libcpp.pair cimport pair
@@ -9,7 +10,7 @@ from cython.operator cimport dereference
 
 from ..config cimport translate_exception
 from ..cpp.callable cimport const_charptr, stringstream
-from .array cimport as_cpp_array, dynd_nd_array_from_cpp
+from .array cimport array, as_cpp_array, dynd_nd_array_from_cpp, dynd_nd_array_to_cpp
 from ..cpp.type cimport type as _type
 
 cdef extern from *:
@@ -18,8 +19,31 @@ cdef extern from *:
     # removed by the compiler's optimizer.
     bint is_py_2 "(PY_MAJOR_VERSION == 2)"
 
+cdef extern from 'kernel_cache.hpp':
+    Py_ssize_t PyVectorcall_NARGS(size_t)
+
+cdef extern from 'kernel_cache.hpp' namespace 'pydynd':
+    void enable_vectorcall(PyTypeObject *, Py_ssize_t)
+
 ctypedef pair[const_charptr, _array] char_array_pair
 
+cdef object _vectorcall(object self, PyObject **args, size_t nargsf, PyObject *kwnames):
+    # The vectorcall entry point of nd.callable, which takes the positional
+    # arguments straight from the caller's stack instead of a tuple.
+    cdef Py_ssize_t i, nargs = PyVectorcall_NARGS(nargsf)
+    cdef callable f = <callable> self
+    if kwnames != NULL and len(<object> kwnames) != 0:
+        kwargs = {}
+        for i, s in enumerate(<object> kwnames):
+            kwargs[s] = <object> args[nargs + i]
+        return f._call(tuple([<object> args[i] for i in range(nargs)]), kwargs)
+
+    cdef vector[_array] cpp_args
+    cpp_args.reserve(nargs)
+    for i in range(nargs):
+        cpp_args.push_back(as_cpp_array(<object> args[i]))
+    return dynd_nd_array_from_cpp(f.cache.call(f.v, nargs, cpp_args.data()))
+
 cdef class callable(object):
     """
     nd.callable(func, proto)
@@ -70,14 +94,25 @@ cdef class callable(object):
             cdef vector[pair[_type, string]] kwds = dereference(self.v).get_kwd_types()
             return [(wrap(kwd.first), kwd.second) for kwd in kwds]
 
+    def __cinit__(self):
+        self.vectorcall = <vectorcallfunc> _vectorcall
+
     def __call__(callable self, *args, **kwargs):
+        return self._call(args, kwargs)
+
+    cdef object _call(self, tuple args, dict kwargs):
         cdef size_t nargs = len(args), nkwargs = len(kwargs)
         cdef vector[_array] cpp_args
         cpp_args.reserve(nargs)
-        cdef vector[char_array_pair] cpp_kwargs
-        cpp_kwargs.reserve(nkwargs)
         for ar in args:
             cpp_args.push_back(as_cpp_array(ar))
+        if nkwargs == 0:
+            # Calls without keywords can reuse the kernels instantiated for
+            # earlier calls with the same argument types and arrmeta.
+            return dynd_nd_array_from_cpp(self.cache.call(self.v, nargs, cpp_args.data()))
+
+        cdef vector[char_array_pair] cpp_kwargs
+        cpp_kwargs.reserve(nkwargs)
         if is_py_2:
             for s, ar in kwargs.iteritems():
                 cpp_kwargs.push_back(char_array_pair(
@@ -91,12 +126,97 @@ cdef class callable(object):
                    nargs, cpp_args.data(), nkwargs, cpp_kwargs.data()))
         return a
 
+    def prepare(callable self, *arg_types, out=None):
+        """
+        f.prepare(*arg_types, out=None)
+
+        Resolves this callable and instantiates its kernel once for
+        positional arguments of the given types, returning a handle
+        which runs that kernel directly. Calling the handle only checks
+        that the arguments have the prepared types and strides, and swaps
+        in their data pointers.
+
+        Parameters
+        ----------
+        *arg_types : ndt.type, str or nd.array
+            The types of the arguments. An nd.array stands for arguments
+            with its type and strides, which allows preparing for views.
+        out : nd.array, optional
+            An array which every call of the handle writes its result to,
+            and returns. Without it, every call returns a new array.
+
+        Examples
+        --------
+        >>> from dynd import nd
+        >>> add = nd.add.prepare('3 * float64', '3 * float64')
+        >>> add(nd.array([1.0, 2.0, 3.0]), nd.array([4.0, 5.0, 6.0]))
+        nd.array([5, 7, 9],
+                 type="3 * float64")
+        """
+        return prepared(self, arg_types, out)
+
     def __repr__(self):
         cdef stringstream ss
         ss << self.v
 
         return ss.str()
 
+cdef class prepared(object):
+    """
+    A callable resolved and instantiated for fixed argument types, as
+    returned by nd.callable.prepare.
+
+    Besides being callable from Python, it provides the nogil method
+    `single(dst, src)`, through which Cython code can run the kernel on
+    raw data pointers without any checks.
+    """
+
+    def __cinit__(self, callable func, tuple arg_types, out):
+        cdef vector[_type] tps
+        cdef vector[_array] protos
+        tps.reserve(len(arg_types))
+        protos.reserve(len(arg_types))
+        for tp in arg_types:
+            if isinstance(tp, array):
+                protos.push_back(dynd_nd_array_to_cpp(tp))
+                tps.push_back(protos.back().get_type())
+            else:
+                protos.push_back(_array())
+                tps.push_back(as_cpp_type(tp))
+
+        if out is not None:
+            self._out = dynd_nd_array_to_cpp(out)
+        self.p = new prepared_call(func.v, tps, protos, self._out)
+        self.func = func
+        self.out = out
+
+    def __dealloc__(self):
+        del self.p
+
+    property arg_types:
+        def __get__(self):
+            return [wrap(self.p.get_src_type(i)) for i in range(self.p.get_narg())]
+
+    property return_type:
+        def __get__(self):
+            return wrap(self.p.get_dst_type())
+
+    def __call__(prepared self, *args):
+        cdef size_t nargs = len(args)
+        cdef vector[_array] cpp_args
+        cpp_args.reserve(nargs)
+        for ar in args:
+            cpp_args.push_back(as_cpp_array(ar))
+        if self.out is None:
+            return dynd_nd_array_from_cpp(self.p.call(nargs, cpp_args.data()))
+
+        self.p.call(self._out, nargs, cpp_args.data())
+        return self.out
+
+    cdef int single(self, char *dst, char **src) nogil except -1:
+        self.p.single(dst, src)
+        return 0
+
 cdef _callable dynd_nd_callable_to_cpp(callable c) nogil except *:
     # Once this becomes a method of the type wrapper class, this check and
     # its corresponding exception handler declaration are no longer necessary
@@ -121,4 +241,11 @@ cdef callable wrap(const _callable &c):
     cl.v = c
     return cl
 
-from ..ndt.type cimport wrap
+cdef _enable_vectorcall():
+    cdef callable probe = callable.__new__(callable)
+    enable_vectorcall(<PyTypeObject *> callable,
+                      <char *> &probe.vectorcall - <char *> <PyObject *> probe)
+
+_enable_vectorcall()
+
+from ..ndt.type cimport wrap, as_cpp_type
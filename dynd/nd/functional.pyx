@@ -12,6 +12,7 @@ from ..cpp.type cimport make_type
 
 from ..config cimport translate_exception
 from .array cimport _functional_apply as _apply
+from .array cimport _functional_tree_reduction as _tree_reduction
 from .callable cimport callable, wrap, dynd_nd_callable_to_cpp
 from ..ndt.type cimport type, as_numba_type, from_numba_type, as_cpp_type
 
@@ -125,11 +126,50 @@ def elwise(func):
 
     return wrap(_elwise((<callable> func).v))
 
-def reduction(identity, child):
+cdef class tree_reduction(object):
+    """
+    A reduction which splits the largest reduced dimension into blocks of
+    `block_size` indices, reduces the blocks on up to `nthreads` threads,
+    and combines the partial results pairwise along a fixed tree. The
+    result only depends on `block_size`, never on `nthreads`.
+    """
+
+    cdef readonly callable reduce
+    cdef readonly callable combine
+    cdef readonly intptr_t block_size
+    cdef readonly intptr_t nthreads
+
+    def __init__(self, callable reduce, callable combine, intptr_t block_size = 4096, intptr_t nthreads = 1):
+        if block_size <= 0:
+            raise ValueError('block_size must be positive, got %d' % block_size)
+        self.reduce = reduce
+        self.combine = combine
+        self.block_size = block_size
+        self.nthreads = max(nthreads, 1)
+
+    def __call__(self, a, axes = None):
+        return _tree_reduction(self.reduce.v, self.combine.v, a, axes, self.block_size, self.nthreads)
+
+def reduction(identity, child, block_size = None, nthreads = None):
+    """
+    nd.functional.reduction(identity, child, block_size=None, nthreads=None)
+    Makes a reduction out of a binary child, folding every reduced
+    dimension from the left. When `block_size` or `nthreads` is given,
+    a `tree_reduction` is returned instead, which is more accurate for
+    floating point sums and can run on several threads. A child which
+    is a Python function needs the GIL, so it runs on one thread only.
+    """
     if not isinstance(child, callable):
+        if nthreads is not None and nthreads > 1:
+            raise ValueError('a reduction of a Python function can only run on one thread, not %d' % nthreads)
         child = apply(child)
 
-    return wrap(_reduction((<callable> identity).v, (<callable> child).v))
+    f = wrap(_reduction((<callable> identity).v, (<callable> child).v))
+    if block_size is None and nthreads is None:
+        return f
+
+    return tree_reduction(f, elwise(child), 4096 if block_size is None else block_size,
+                          1 if nthreads is None else nthreads)
 
 """
 def multidispatch(type tp, iterable = None):
@@ -1,5 +1,5 @@
 import unittest
-from dynd import nd
+from dynd import nd, ndt
 import sys
 
 @unittest.skip('Test disabled since translate_exception is not being applied properly')
@@ -41,5 +41,81 @@ class TestScalarConstructor(unittest.TestCase):
         self.assertRaises(ValueError, a.__pow__, a, a)
         self.assertRaises(RuntimeError, a.__rpow__, b)
 
+class TestSum(unittest.TestCase):
+    def test_pairwise_accuracy(self):
+        # A left fold loses every one of the small terms
+        a = nd.array([1.0] + [1e-16] * 10000)
+        self.assertAlmostEqual(nd.as_py(a.sum()), 1.0 + 1e-12, places=14)
+
+    def test_thread_determinism(self):
+        a = nd.array([((i * 7919) % 1000) / 7.0 for i in range(100000)])
+        expected = nd.as_py(a.sum())
+        for nthreads in [2, 3, 8]:
+            self.assertEqual(nd.as_py(a.sum(nthreads=nthreads)), expected)
+
+    def test_axes(self):
+        a = nd.array([[[1., 2.], [3., 4.]], [[5., 6.], [7., 8.]]])
+        self.assertEqual(nd.as_py(a.sum()), 36.)
+        self.assertEqual(nd.as_py(a.sum(axis=1)), [[4., 6.], [12., 14.]])
+        self.assertEqual(nd.as_py(a.sum(axis=(0, 2))), [14., 22.])
+        self.assertEqual(nd.as_py(a.sum(axis=[0, 2], nthreads=2)), [14., 22.])
+
+    def test_axes_int32(self):
+        # Integers have no pairwise loop and go through the blocked nd.sum
+        a = nd.array([[1, 2, 3], [4, 5, 6]], type='2 * 3 * int32')
+        self.assertEqual(nd.as_py(a.sum(axis=0, block_size=1, nthreads=2)), [5, 7, 9])
+        self.assertEqual(nd.as_py(a.sum(axis=1, nthreads=2)), [6, 15])
+
+    def test_blocked(self):
+        a = nd.array(list(range(10000)))
+        self.assertEqual(nd.as_py(a.sum(block_size=100, nthreads=4)), 49995000)
+
+class TestCallableCall(unittest.TestCase):
+    def test_repeated_calls(self):
+        # The second and later calls go through the cached kernel
+        for i in range(3):
+            a = nd.array([1.0, 2.0, 3.0])
+            b = nd.array([i, i, i], type='3 * float64')
+            self.assertEqual(nd.as_py(nd.add(a, b)), [1.0 + i, 2.0 + i, 3.0 + i])
+
+    def test_strides(self):
+        # Arrays of the same type with different strides don't share a kernel
+        a = nd.array([1, 2, 3, 4, 5, 6])
+        self.assertEqual(nd.as_py(nd.add(a[:3], a[:3])), [2, 4, 6])
+        self.assertEqual(nd.as_py(nd.add(a[::2], a[::2])), [2, 6, 10])
+        self.assertEqual(nd.as_py(nd.add(a[3:], a[3:])), [8, 10, 12])
+
+    def test_python_scalars(self):
+        self.assertEqual(nd.as_py(nd.add(1.5, 2.5)), 4.0)
+        self.assertEqual(nd.type_of(nd.add(1, 2)), nd.type_of(nd.array(3)))
+        self.assertEqual(nd.as_py(nd.add(1, 2)), 3)
+        self.assertEqual(nd.as_py(nd.add(1 << 40, 1)), (1 << 40) + 1)
+        self.assertEqual(nd.as_py(nd.add(1j, 2.0)), 2.0 + 1j)
+        self.assertEqual(nd.as_py(nd.asarray(True)), True)
+
+    def test_prepare(self):
+        add = nd.add.prepare('3 * float64', '3 * float64')
+        self.assertEqual(add.return_type, ndt.type('3 * float64'))
+        a = nd.array([1.0, 2.0, 3.0])
+        self.assertEqual(nd.as_py(add(a, a)), [2.0, 4.0, 6.0])
+        self.assertEqual(nd.as_py(add(a, [4.0, 5.0, 6.0])), [5.0, 7.0, 9.0])
+        # The arguments must have the prepared types and strides
+        self.assertRaises(TypeError, add, a, nd.array([1, 2, 3]))
+        self.assertRaises(TypeError, add, a, nd.array([1.0, 2.0, 3.0, 4.0, 5.0, 6.0])[::2])
+
+    def test_prepare_strided(self):
+        b = nd.array([1.0, 2.0, 3.0, 4.0, 5.0, 6.0])
+        add = nd.add.prepare(b[::2], b[1::2])
+        self.assertEqual(nd.as_py(add(b[::2], b[1::2])), [3.0, 7.0, 11.0])
+
+    def test_prepare_out(self):
+        out = nd.empty('3 * float64')
+        add = nd.add.prepare('3 * float64', '3 * float64', out=out)
+        a = nd.array([1.0, 2.0, 3.0])
+        self.assertTrue(add(a, a) is out)
+        self.assertEqual(nd.as_py(out), [2.0, 4.0, 6.0])
+        self.assertRaises(TypeError, nd.add.prepare, '3 * float64', '3 * float64',
+                          out=nd.empty('3 * int32'))
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
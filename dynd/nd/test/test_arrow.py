@@ -0,0 +1,117 @@
+import os
+import tempfile
+import unittest
+from dynd import nd, ndt
+
+try:
+    import pyarrow
+except ImportError:
+    pyarrow = None
+
+class TestArrowCapsules(unittest.TestCase):
+    def roundtrip(self, a):
+        return nd.from_arrow(a.__arrow_c_array__())
+
+    def test_numbers(self):
+        a = nd.array([1, 2, 3], type='3 * int32')
+        b = self.roundtrip(a)
+        self.assertEqual(nd.type_of(b), ndt.type('3 * int32'))
+        self.assertEqual(nd.as_py(b), [1, 2, 3])
+
+    def test_records(self):
+        vals = [{'x': 1, 'name': 'a', 'v': [1.5]},
+                {'x': None, 'name': None, 'v': []}]
+        a = nd.array(vals, type='2 * {x: ?int64, name: ?string, v: var * float64}')
+        b = self.roundtrip(a)
+        self.assertEqual(nd.as_py(b), vals)
+
+    def test_fixed_lists(self):
+        a = nd.array([[1, 2], [3, 4], [5, 6]], type='3 * 2 * int8')
+        b = self.roundtrip(a)
+        self.assertEqual(nd.type_of(b), ndt.type('3 * 2 * int8'))
+        self.assertEqual(nd.as_py(b), [[1, 2], [3, 4], [5, 6]])
+
+    def test_requested_schema(self):
+        a = nd.array([1, 2, 3], type='3 * int32')
+        schema = nd.array([0.0], type='1 * float64').__arrow_c_schema__()
+        b = nd.from_arrow(a.__arrow_c_array__(schema))
+        self.assertEqual(nd.type_of(b), ndt.type('3 * float64'))
+        self.assertEqual(nd.as_py(b), [1.0, 2.0, 3.0])
+
+    def test_capsules(self):
+        schema, array = nd.array([1.5, 2.5], type='2 * float64').__arrow_c_array__()
+        b = nd.from_arrow_capsule(schema, array)
+        self.assertEqual(nd.type_of(b), ndt.type('2 * float64'))
+        self.assertEqual(nd.as_py(b), [1.5, 2.5])
+
+    def test_scalar(self):
+        self.assertRaises(TypeError, nd.array(1).__arrow_c_array__)
+
+    @unittest.skipIf(pyarrow is None, 'pyarrow is not installed')
+    def test_pyarrow(self):
+        b = nd.from_arrow(pyarrow.array([1, None, 3]))
+        self.assertEqual(nd.type_of(b), ndt.type('3 * ?int64'))
+        self.assertEqual(nd.as_py(b), [1, None, 3])
+        a = nd.array(['x', 'yz'], type='2 * string')
+        self.assertEqual(pyarrow.array(a).to_pylist(), ['x', 'yz'])
+
+class TestReadArrow(unittest.TestCase):
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp(suffix='.feather')
+        os.close(fd)
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def test_not_arrow(self):
+        with open(self.path, 'wb') as f:
+            f.write(b'not an arrow file')
+        self.assertRaises(ValueError, nd.read_arrow, self.path)
+
+    @unittest.skipIf(pyarrow is None, 'pyarrow is not installed')
+    def test_columns(self):
+        from pyarrow import feather
+        t = pyarrow.table({
+            'i': pyarrow.array([1, 2, 3], pyarrow.int32()),
+            'f': [1.5, None, 3.5],
+            's': ['a', None, u'\xe9'],
+            'l': pyarrow.array([[1, 2], [], [3]], pyarrow.list_(pyarrow.int64())),
+            'w': pyarrow.array([[1, 2], [3, 4], [5, 6]], pyarrow.list_(pyarrow.float32(), 2)),
+            'st': [{'a': 1, 'b': 'x'}, {'a': 2, 'b': 'y'}, {'a': 3, 'b': 'z'}]})
+        feather.write_feather(t, self.path, compression='uncompressed')
+        a = nd.read_arrow(self.path)
+        self.assertEqual(sorted(a), ['f', 'i', 'l', 's', 'st', 'w'])
+        self.assertEqual(nd.type_of(a['i']), ndt.type('3 * int32'))
+        self.assertEqual(nd.type_of(a['f']), ndt.type('3 * ?float64'))
+        self.assertEqual(nd.type_of(a['l']), ndt.type('3 * var * int64'))
+        self.assertEqual(nd.type_of(a['w']), ndt.type('3 * 2 * float32'))
+        self.assertEqual(nd.type_of(a['st']), ndt.type('3 * {a: int64, b: string}'))
+        for name in a:
+            self.assertEqual(nd.as_py(a[name]), t.column(name).to_pylist())
+
+    @unittest.skipIf(pyarrow is None, 'pyarrow is not installed')
+    def test_batches(self):
+        from pyarrow import feather
+        t = pyarrow.table({'x': list(range(5)), 'y': [1.0, None, 2.0, 3.0, 4.0]})
+        feather.write_feather(t, self.path, compression='uncompressed', chunksize=2)
+        self.assertEqual(nd.as_py(nd.read_arrow(self.path)['y']), [1.0, None, 2.0, 3.0, 4.0])
+        self.assertEqual(nd.as_py(nd.read_arrow(self.path, ['x'], batch=1)['x']), [2, 3])
+        self.assertRaises(IndexError, nd.read_arrow, self.path, batch=3)
+        self.assertRaises(KeyError, nd.read_arrow, self.path, ['z'])
+
+    @unittest.skipIf(pyarrow is None, 'pyarrow is not installed')
+    def test_corrupt(self):
+        import struct
+        from pyarrow import feather
+        t = pyarrow.table({'s': ['a', 'bb', 'c']})
+        feather.write_feather(t, self.path, compression='uncompressed')
+        with open(self.path, 'rb') as f:
+            data = f.read()
+        # Point the last string offset past the bytes of the strings
+        i = data.find(struct.pack('<4i', 0, 1, 3, 4))
+        with open(self.path, 'wb') as f:
+            f.write(data[:i] + struct.pack('<4i', 0, 1, 3, 400) + data[i + 16:])
+        self.assertRaises(ValueError, nd.read_arrow, self.path)
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -0,0 +1,77 @@
+import os
+import tempfile
+import unittest
+from dynd import nd, ndt
+
+class TestReadCSV(unittest.TestCase):
+    def setUp(self):
+        self.paths = []
+
+    def tearDown(self):
+        for path in self.paths:
+            os.remove(path)
+
+    def write(self, text, suffix='.csv'):
+        fd, path = tempfile.mkstemp(suffix=suffix)
+        with os.fdopen(fd, 'wb') as f:
+            f.write(text if isinstance(text, bytes) else text.encode('utf-8'))
+        self.paths.append(path)
+        return path
+
+    def test_discover(self):
+        path = self.write('a,b,c,d\n1,2.5,x,true\r\n\n-3,,"y, z",False\n')
+        a = nd.read_csv(path)
+        self.assertEqual(nd.type_of(a), ndt.type('2 * {a: int64, b: ?float64, c: string, d: bool}'))
+        self.assertEqual(nd.as_py(a), [{'a': 1, 'b': 2.5, 'c': 'x', 'd': True},
+                                       {'a': -3, 'b': None, 'c': 'y, z', 'd': False}])
+
+    def test_type_by_header(self):
+        path = self.write('id,skip,name\n +07 ,x,"he said ""hi""\nthere"\n-128,y,\n')
+        a = nd.read_csv(path, '{name: string, id: int8, other: ?uint16}')
+        self.assertEqual(nd.as_py(a), [{'name': 'he said "hi"\nthere', 'id': 7, 'other': None},
+                                       {'name': '', 'id': -128, 'other': None}])
+
+    def test_tsv_without_header(self):
+        path = self.write(u'1\tfoo\n2\té\n', suffix='.tsv')
+        a = nd.read_csv(path, header=False)
+        self.assertEqual(nd.type_of(a), ndt.type('2 * {f0: int64, f1: string}'))
+        self.assertEqual(nd.as_py(a), [{'f0': 1, 'f1': 'foo'}, {'f0': 2, 'f1': u'é'}])
+
+    def test_threads(self):
+        lines = ['x,s'] + ['%d,"l1\nl2,""%d"""' % (i, i) for i in range(100000)]
+        path = self.write('\n'.join(lines))
+        a = nd.read_csv(path, nthreads=4)
+        self.assertEqual(nd.as_py(a), nd.as_py(nd.read_csv(path)))
+        self.assertEqual(nd.as_py(a[99999]), {'x': 99999, 's': 'l1\nl2,"99999"'})
+
+    def test_empty(self):
+        a = nd.read_csv(self.write(''), '{x: int32}')
+        self.assertEqual(len(a), 0)
+
+    def test_errors(self):
+        self.assertRaises(ValueError, nd.read_csv, self.write('x\n300\n'), '{x: int8}')
+        self.assertRaises(ValueError, nd.read_csv, self.write('x\n1,2\n'), '{x: int32}')
+        self.assertRaises(ValueError, nd.read_csv, self.write('x\n"abc\n'), '{x: string}')
+        self.assertRaises(ValueError, nd.read_csv, self.write('x\n1\n'), '{y: int32}')
+        self.assertRaises(ValueError, nd.read_csv, self.write('x\n1\n'), delimiter=';;')
+        self.assertRaises(TypeError, nd.read_csv, self.write('x\n1\n'), '{x: complex128}')
+
+    def test_floats(self):
+        # Only decimal numbers are floats, however long
+        digits = '1' * 100 + '.5'
+        a = nd.read_csv(self.write('x,y,z,w\n%s,nan,0x10,1e5\n-.5,inf,0x20,+2.E-3\n' % digits))
+        self.assertEqual(nd.type_of(a), ndt.type('2 * {x: float64, y: string, z: string, w: float64}'))
+        self.assertEqual(nd.as_py(a.x), [float(digits), -0.5])
+        self.assertEqual(nd.as_py(a.w), [1e5, 2e-3])
+        for value in ['nan', 'inf', '0x10', '1e', '1,5']:
+            self.assertRaises(ValueError, nd.read_csv, self.write('x\n%s\n' % value), '{x: float64}')
+
+    def test_invalid_utf8(self):
+        path = self.write(b'x,s\n1,a\n2,"b\xffc"\n')
+        with self.assertRaises(ValueError) as cm:
+            nd.read_csv(path, '{x: int32, s: string}')
+        self.assertTrue('row 1' in str(cm.exception))
+        self.assertTrue('column 1' in str(cm.exception))
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -0,0 +1,46 @@
+import unittest
+import numpy as np
+from dynd import nd, ndt
+
+class TestDLPack(unittest.TestCase):
+    def test_roundtrip(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]], type='2 * 3 * int16')
+        b = nd.from_dlpack(a)
+        self.assertEqual(nd.type_of(b), ndt.type('2 * 3 * int16'))
+        self.assertEqual(nd.as_py(b), [[1, 2, 3], [4, 5, 6]])
+        # The data is shared
+        b[0, 0] = 10
+        self.assertEqual(nd.as_py(a[0, 0]), 10)
+
+    def test_strides(self):
+        a = nd.array([[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]])[::2, ::-1]
+        b = nd.from_dlpack(a)
+        self.assertEqual(nd.as_py(b), [[2.0, 1.0], [6.0, 5.0]])
+
+    def test_device(self):
+        self.assertEqual(nd.array([1]).__dlpack_device__(), (1, 0))
+
+    def test_capsule(self):
+        a = nd.array([1, 2, 3], type='3 * int32')
+        capsule = a.__dlpack__()
+        self.assertEqual(nd.as_py(nd.from_dlpack(capsule)), [1, 2, 3])
+        # A capsule can only be used once
+        self.assertRaises(ValueError, nd.from_dlpack, capsule)
+
+    def test_unsupported(self):
+        self.assertRaises(TypeError, nd.array(['a', 'b']).__dlpack__)
+        self.assertRaises(ValueError, nd.array([1]).__dlpack__, stream=1)
+
+    @unittest.skipIf(not hasattr(np, 'from_dlpack'), 'numpy lacks from_dlpack')
+    def test_numpy(self):
+        x = np.arange(12, dtype=np.float32).reshape(3, 4).T
+        a = nd.from_dlpack(x)
+        self.assertEqual(nd.type_of(a), ndt.type('4 * 3 * float32'))
+        self.assertEqual(nd.as_py(a), x.tolist())
+        y = np.from_dlpack(a)
+        self.assertEqual(y.tolist(), x.tolist())
+        y[0, 0] = 100
+        self.assertEqual(x[0, 0], 100)
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -76,6 +76,18 @@ class TestReduction(unittest.TestCase):
         self.assertEqual(3, f([1, 2, 3]))
         self.assertEqual(6, f([[1, 2, 3], [4, 5, 6]]))
 
+class TestTreeReduction(unittest.TestCase):
+    def test_threads(self):
+        # The blocks are combined along the same tree for any number of threads
+        a = nd.array([((i * 7919) % 1000) / 7.0 for i in range(100000)])
+        expected = nd.as_py(nd.functional.tree_reduction(nd.sum, nd.add, block_size=1000)(a))
+        for nthreads in [2, 3, 8]:
+            f = nd.functional.tree_reduction(nd.sum, nd.add, block_size=1000, nthreads=nthreads)
+            self.assertEqual(nd.as_py(f(a)), expected)
+
+    def test_python_child(self):
+        self.assertRaises(ValueError, nd.functional.reduction, None, lambda x, y: x + y, nthreads=2)
+
 """
 def multigen(func):
     return lambda x: x
@@ -0,0 +1,139 @@
+import io
+import unittest
+from dynd import nd, ndt
+
+class TestParseJSON(unittest.TestCase):
+    def test_ectx_errmode(self):
+        self.assertEqual(nd.as_py(nd.parse_json('int8', '100', ectx={'errmode': 'overflow'})), 100)
+        self.assertRaises(OverflowError, nd.parse_json, 'int8', '1000', ectx={'errmode': 'overflow'})
+        self.assertRaises(ValueError, nd.parse_json, 'int8', '1', ectx={'errmode': 'sometimes'})
+        self.assertRaises(ValueError, nd.parse_json, 'int8', '1', ectx={'color': 'blue'})
+
+class TestParseJSONLines(unittest.TestCase):
+    lines = ['{"x": 1, "name": "a"}', '', '{"x": 2, "name": "bc"}\n', '{"name": "def", "x": 3}']
+
+    def test_chunks(self):
+        chunks = list(nd.parse_json_lines(self.lines, '{x: int32, name: string}', chunk_rows=2))
+        self.assertEqual(len(chunks), 2)
+        self.assertEqual(nd.type_of(chunks[0]), ndt.type('1 * {x: int32, name: string}'))
+        self.assertEqual(nd.as_py(chunks[0]), [{'x': 1, 'name': 'a'}])
+        self.assertEqual(nd.as_py(chunks[1]), [{'x': 2, 'name': 'bc'}, {'x': 3, 'name': 'def'}])
+
+    def test_file(self):
+        f = io.BytesIO('\n'.join(self.lines).encode('utf-8'))
+        chunks = list(nd.parse_json_lines(f, '{x: int32, name: string}'))
+        self.assertEqual(len(chunks), 1)
+        self.assertEqual([r['x'] for r in nd.as_py(chunks[0])], [1, 2, 3])
+
+    def test_read_json_lines(self):
+        lines = ['[%d]' % i for i in range(100)]
+        a = nd.read_json_lines(lines, 'var * int64', chunk_rows=7)
+        self.assertEqual(nd.type_of(a), ndt.type('100 * var * int64'))
+        self.assertEqual(nd.as_py(a), [[i] for i in range(100)])
+
+    def test_read_json_lines_empty(self):
+        a = nd.read_json_lines([], 'int32')
+        self.assertEqual(nd.type_of(a), ndt.type('0 * int32'))
+
+    def test_invalid(self):
+        self.assertRaises(ValueError, list, nd.parse_json_lines(['{"x": 1}'], '{x: int32}', chunk_rows=0))
+
+class TestJSONStructuralIndex(unittest.TestCase):
+    def backends(self):
+        from dynd.nd.array import _json_index_backend
+        result = ['scalar']
+        for name in ['sse2', 'avx2']:
+            try:
+                _json_index_backend(name)
+                result.append(name)
+            except ValueError:
+                pass
+        _json_index_backend('')
+        return result
+
+    def test_index(self):
+        from dynd.nd.array import _json_structural_index
+        data = b'{"a": [1, "x,\\"}"], "b\\\\": {}}'
+        self.assertEqual([chr(bytearray(data)[i]) for i in _json_structural_index(data)],
+                         ['{', '"', '"', ':', '[', ',', '"', '"', ']', ',', '"', '"', ':', '{', '}', '}'])
+
+    def test_backends_agree(self):
+        from dynd.nd.array import _json_structural_index, _json_index_backend
+        # Long enough to cross several 64 byte blocks, with escapes and
+        # strings straddling the block boundaries
+        data = b'\n'.join(('{"k%d": "v\\\\\\"%s", "n": [%d, {}]}' % (i, 'x' * i, i)).encode('ascii')
+                          for i in range(100))
+        expected = None
+        try:
+            for name in self.backends():
+                _json_index_backend(name)
+                index = _json_structural_index(data)
+                if expected is None:
+                    expected = index
+                self.assertEqual(index, expected, name)
+        finally:
+            _json_index_backend('')
+
+class TestParseJSONRecords(unittest.TestCase):
+    tp = '{i: int64, f: float64, s: string, b: bool, o: ?int16}'
+
+    def parse_slow(self, lines, tp):
+        return nd.as_py(nd.parse_json('%d * %s' % (len(lines), tp), '[' + ','.join(lines) + ']'))
+
+    def test_matches_parse_json(self):
+        lines = ['{"i": %d, "f": %r, "s": "r\\u00e9\\ud83d\\ude00\\n%d", "b": %s, "o": %s}' %
+                 (i * 1000003 - 2**40, i / 7.0, i, 'true' if i % 2 else 'false', 'null' if i % 3 else i)
+                 for i in range(1000)]
+        for nthreads in [1, 4]:
+            a = nd.read_json_lines(lines, self.tp, chunk_rows=300, nthreads=nthreads)
+            self.assertEqual(nd.as_py(a), self.parse_slow(lines, self.tp))
+
+    def test_field_order_and_unknown_fields(self):
+        lines = ['{"extra": {"nested": [1, "}"]}, "o": 5, "s": "a", "b": false, "f": -1e3, "i": 0}',
+                 '  {"s": "b", "i": 1, "f": 2, "b": true}  ']
+        self.assertEqual(nd.as_py(nd.read_json_lines(lines, self.tp)),
+                         [{'i': 0, 'f': -1000.0, 's': 'a', 'b': False, 'o': 5},
+                          {'i': 1, 'f': 2.0, 's': 'b', 'b': True, 'o': None}])
+
+    def test_fallback(self):
+        # Rows with nested values go through dynd's parser
+        tp = '{x: int32, y: var * int32}'
+        lines = ['{"x": 1, "y": [1, 2]}', '{"x": 2, "y": []}']
+        self.assertEqual(nd.as_py(nd.read_json_lines(lines, tp, nthreads=2)), self.parse_slow(lines, tp))
+
+    def test_errors(self):
+        for line in ['{"i": 1, "f": 1, "s": "", "b": true', '{"i": 1.5, "f": 1, "s": "", "b": true}',
+                     '{"i": 1, "f": 1, "s": ""}',
+                     '{"i": 1, "f": 1, "s": "", "b": true} 2']:
+            self.assertRaises(ValueError, nd.read_json_lines, [line], self.tp)
+        self.assertRaises(OverflowError, nd.read_json_lines, ['{"x": 300}'], '{x: uint8}',
+                          ectx={'errmode': 'overflow'})
+        self.assertRaises(OverflowError, nd.read_json_lines, ['{"x": 1e39}'], '{x: float32}')
+
+    def test_invalid_utf8(self):
+        # The fast path leaves invalid UTF-8 to dynd's parser
+        line = b'{"s": "a\xffb"}'
+        tp = '{s: string}'
+        try:
+            nd.parse_json('1 * ' + tp, b'[' + line + b']')
+        except (ValueError, UnicodeDecodeError) as e:
+            self.assertRaises(type(e), nd.read_json_lines, io.BytesIO(line), tp)
+        else:
+            self.assertEqual(nd.type_of(nd.read_json_lines(io.BytesIO(line), tp)), ndt.type('1 * ' + tp))
+
+    def test_unknown_field_values(self):
+        # The values of fields which aren't in the struct are checked like
+        # dynd's parser checks them
+        tp = '{i: int32}'
+        for line in [b'{"x": garbage, "i": 1}', b'{"x": tru, "i": 1}', b'{"x": [1,], "i": 1}',
+                     b'{"x": {"a": nul}, "i": 1}', b'{"x": "a\xffb", "i": 1}', b'{"x": ["a\xffb"], "i": 1}',
+                     b'{"x": [1, {"a": [true, "s"]}, {}], "i": 1}']:
+            try:
+                expected = nd.as_py(nd.parse_json('1 * ' + tp, b'[' + line + b']'))
+            except (ValueError, UnicodeDecodeError) as e:
+                self.assertRaises(type(e), nd.read_json_lines, io.BytesIO(line), tp)
+            else:
+                self.assertEqual(nd.as_py(nd.read_json_lines(io.BytesIO(line), tp)), expected)
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
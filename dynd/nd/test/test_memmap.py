@@ -0,0 +1,60 @@
+import os
+import sys
+import tempfile
+import unittest
+from dynd import nd, ndt
+import numpy as np
+
+class TestMemmap(unittest.TestCase):
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp(suffix='.bin')
+        os.close(fd)
+        np.arange(10, dtype=np.float64).tofile(self.path)
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def test_fixed_type(self):
+        a = nd.memmap(self.path, '10 * float64')
+        self.assertEqual(nd.type_of(a), ndt.type('10 * float64'))
+        self.assertEqual(nd.as_py(a), [float(i) for i in range(10)])
+        self.assertEqual(a.access_flags, 'readonly')
+
+    def test_deduced_dim(self):
+        a = nd.memmap(self.path, 'Fixed * float64')
+        self.assertEqual(nd.type_of(a), ndt.type('10 * float64'))
+        a = nd.memmap(self.path, 'Fixed * 2 * float64')
+        self.assertEqual(nd.type_of(a), ndt.type('5 * 2 * float64'))
+        self.assertEqual(nd.as_py(a[4]), [8.0, 9.0])
+
+    def test_offset(self):
+        a = nd.memmap(self.path, 'Fixed * float64', offset=16)
+        self.assertEqual(nd.as_py(a), [float(i) for i in range(2, 10)])
+
+    def test_too_small(self):
+        self.assertRaises(RuntimeError, nd.memmap, self.path, '11 * float64')
+
+    def test_readwrite(self):
+        a = nd.memmap(self.path, '10 * float64', mode='r+')
+        a[0] = 100.0
+        del a
+        self.assertEqual(np.fromfile(self.path)[0], 100.0)
+
+    def test_copy_on_write(self):
+        a = nd.memmap(self.path, '10 * float64', mode='c')
+        a[0] = 100.0
+        self.assertEqual(nd.as_py(a[0]), 100.0)
+        del a
+        self.assertEqual(np.fromfile(self.path)[0], 0.0)
+
+    def test_advice(self):
+        a = nd.memmap(self.path, '10 * float64', advice='sequential')
+        nd.madvise(a, 'willneed')
+        self.assertEqual(nd.as_py(a[9]), 9.0)
+        self.assertRaises(ValueError, nd.madvise, a, 'often')
+
+    def test_missing_file(self):
+        self.assertRaises(OSError, nd.memmap, self.path + '.missing', '10 * float64')
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -176,9 +176,9 @@ class TestNumpyViewInterop(unittest.TestCase):
         self.assertEqual(nd.type_of(n), ndt.int64)
         self.assertEqual(nd.as_py(n), 3)
         self.assertEqual(n.access_flags, 'readwrite')
-        # Ensure it's not a view
+        # Ensure it's a view
         a[...] = 4
-        self.assertEqual(nd.as_py(n), 3)
+        self.assertEqual(nd.as_py(n), 4)
 
     def test_dynd_scalar_asarray(self):
         a = np.array(3, dtype='int64')
@@ -376,6 +376,78 @@ class TestNumpyViewInterop(unittest.TestCase):
         self.assertEqual(nd.as_py(b[0]), 2.0)
         self.assertEqual(a[0], 2.0)
 
+class TestArrayConstructorView(unittest.TestCase):
+    def test_numpy_view(self):
+        a = np.arange(10, dtype=np.float64)
+        n = nd.array(a)
+        self.assertEqual(nd.type_of(n), ndt.type('10 * float64'))
+        a[3] = 100.0
+        self.assertEqual(nd.as_py(n[3]), 100.0)
+
+    def test_numpy_strided_view(self):
+        a = np.arange(20, dtype=np.int32)[::2]
+        n = nd.array(a)
+        self.assertEqual(n.strides, (8,))
+        self.assertEqual(nd.as_py(n), list(range(0, 20, 2)))
+
+    def test_numpy_same_type(self):
+        a = np.arange(5, dtype=np.int64)
+        n = nd.array(a, type='5 * int64')
+        a[0] = 7
+        self.assertEqual(nd.as_py(n[0]), 7)
+
+    def test_numpy_conversion(self):
+        a = np.arange(5, dtype=np.int64)
+        n = nd.array(a, type='5 * float32')
+        self.assertEqual(nd.type_of(n), ndt.type('5 * float32'))
+        self.assertEqual(nd.as_py(n), [0.0, 1.0, 2.0, 3.0, 4.0])
+        # A conversion makes a copy
+        a[0] = 7
+        self.assertEqual(nd.as_py(n[0]), 0.0)
+
+    def test_buffer_view(self):
+        import array
+        a = array.array('d', [1.0, 2.0, 3.0])
+        n = nd.array(a)
+        self.assertEqual(nd.type_of(n), ndt.type('3 * float64'))
+        a[1] = 5.0
+        self.assertEqual(nd.as_py(n), [1.0, 5.0, 3.0])
+
+    def test_dynd_view(self):
+        a = nd.array([1, 2, 3])
+        self.assertEqual(nd.as_py(nd.array(a)), [1, 2, 3])
+        self.assertEqual(nd.type_of(nd.array(a, type='3 * int64')), ndt.type('3 * int64'))
+
+    def test_bytes_scalar(self):
+        self.assertEqual(nd.type_of(nd.array(b'abc')), ndt.bytes)
+
+    def test_array_interface_view(self):
+        class Interface(object):
+            def __init__(self, a):
+                self.a = a
+                self.__array_interface__ = a.__array_interface__
+        a = np.arange(6, dtype=np.int16).reshape(2, 3)
+        n = nd.array(Interface(a))
+        self.assertEqual(nd.type_of(n), ndt.type('2 * 3 * int16'))
+        a[1, 2] = 100
+        self.assertEqual(nd.as_py(n[1, 2]), 100)
+
+    def test_byte_order(self):
+        a = np.arange(3, dtype='>i4')
+        n = nd.array(a)
+        self.assertEqual(nd.type_of(n), ndt.type('3 * int32'))
+        self.assertEqual(nd.as_py(n), [0, 1, 2])
+
+    def test_unaligned(self):
+        a = np.frombuffer(bytearray(13), dtype=np.int32, offset=1, count=3)
+        a[:] = [1, 2, 3]
+        self.assertFalse(a.flags.aligned)
+        self.assertEqual(nd.as_py(nd.array(a)), [1, 2, 3])
+
+    def test_unviewable_dtype(self):
+        # dynd has no float16, which raises rather than aborting
+        self.assertRaises(TypeError, nd.array, np.array([0.5, 1.5], dtype=np.float16))
+
 class TestAsNumpy(unittest.TestCase):
     def test_struct_as_numpy(self):
         # Aligned struct
@@ -414,6 +486,62 @@ class TestAsNumpy(unittest.TestCase):
         self.assertEqual(b.dtype, np.dtype('int32'))
         self.assertEqual(b.tolist(), [1, 3, 5])
 
+    def test_array_interface(self):
+        a = nd.array([[1, 2], [3, 4]], type='2 * 2 * float64')
+        ai = a.__array_interface__
+        self.assertEqual(ai['shape'], (2, 2))
+        self.assertEqual(ai['typestr'], np.dtype(np.float64).str)
+        self.assertEqual(ai['data'][0], np.asarray(a).ctypes.data)
+        self.assertFalse(hasattr(nd.array([[1], [2, 3]]), '__array_interface__'))
+
+    def test_array_protocol(self):
+        a = nd.array([1, 3, 5], type='3 * int32')
+        b = a.__array__()
+        self.assertEqual(b.dtype, np.dtype('int32'))
+        b[0] = 7
+        self.assertEqual(nd.as_py(a[0]), 7)
+        # The view is cached, but each call returns a new ndarray
+        c = a.__array__()
+        self.assertTrue(c.base is b.base)
+        c.shape = (3, 1)
+        self.assertEqual(a.__array__().shape, (3,))
+        # Copies
+        d = a.__array__(copy=True)
+        d[1] = 0
+        self.assertEqual(nd.as_py(a[1]), 3)
+        self.assertEqual(a.__array__(np.float64).tolist(), [7.0, 3.0, 5.0])
+        self.assertRaises(ValueError, a.__array__, np.float64, False)
+
+    def test_array_protocol_copy(self):
+        a = nd.array([[1], [2, 3]])
+        self.assertEqual(a.__array__().tolist(), [[1], [2, 3]])
+        self.assertRaises(ValueError, a.__array__, None, False)
+
+    def test_strings_fixed_width(self):
+        a = nd.array([[u'abc', u''], [u'h\xe9llo', u'\U0001f600']])
+        b = a.to(np.ndarray, strings='U')
+        self.assertEqual(b.dtype, np.dtype('U5'))
+        self.assertEqual(b.tolist(), [[u'abc', u''], [u'h\xe9llo', u'\U0001f600']])
+        b = a.to(np.ndarray, strings='S')
+        self.assertEqual(b.dtype, np.dtype('S6'))
+        self.assertEqual(b[1, 0].decode('utf-8'), u'h\xe9llo')
+        # Var dimensions are viewed as fixed
+        b = nd.array([u'x', u'yz'], type='var * string').to(np.ndarray, strings='U')
+        self.assertEqual(b.tolist(), [u'x', u'yz'])
+
+    @unittest.skipIf(not hasattr(np, 'dtypes') or not hasattr(np.dtypes, 'StringDType'),
+                     'StringDType requires NumPy 2')
+    def test_strings_stringdtype(self):
+        a = nd.array([u'abc', u'', u'h\xe9llo'])
+        b = a.to(np.ndarray, strings='T')
+        self.assertEqual(b.dtype, np.dtypes.StringDType())
+        self.assertEqual(b.tolist(), [u'abc', u'', u'h\xe9llo'])
+
+    def test_strings_errors(self):
+        a = nd.array([u'abc'])
+        self.assertRaises(ValueError, a.to, np.ndarray, strings='O')
+        self.assertRaises(TypeError, nd.array([1, 2]).to, np.ndarray, strings='U')
+
 @unittest.skip('Test disabled since callables were reworked')
 class TestNumpyScalarInterop(unittest.TestCase):
     def test_numpy_scalar_conversion_dtypes(self):
@@ -630,5 +758,127 @@ class TestNumpyScalarInterop(unittest.TestCase):
         self.assertEqual(b.tolist(), [(1, "testing", 1.5), (10, "abc", 2)])
 
 
+class TestNumpyDispatch(unittest.TestCase):
+    def test_ufunc(self):
+        a = nd.array([1.0, 2.0, 3.0])
+        b = nd.array([4.0, 5.0, 6.0])
+        c = np.add(a, b)
+        self.assertTrue(isinstance(c, nd.array))
+        self.assertEqual(nd.as_py(c), [5.0, 7.0, 9.0])
+        # NumPy arrays are viewed
+        c = np.add(a, np.array([1.0, 1.0, 1.0]))
+        self.assertTrue(isinstance(c, nd.array))
+        self.assertEqual(nd.as_py(c), [2.0, 3.0, 4.0])
+
+    def test_ufunc_out(self):
+        a = nd.array([1.0, 2.0, 3.0])
+        b = np.zeros(3)
+        self.assertTrue(np.add(a, a, out=b) is b)
+        self.assertEqual(b.tolist(), [2.0, 4.0, 6.0])
+        c = nd.array([0.0, 0.0, 0.0])
+        self.assertTrue(np.add(a, b, out=c) is c)
+        self.assertEqual(nd.as_py(c), [3.0, 6.0, 9.0])
+
+    def test_ufunc_fallback(self):
+        a = nd.array([1, 2, 3], type='3 * int32')
+        # Methods other than calls are computed by NumPy
+        self.assertEqual(np.add.reduce(a), 6)
+        # NumPy divides integers in floating point
+        c = np.divide(a, a)
+        self.assertTrue(isinstance(c, np.ndarray))
+        self.assertEqual(c.tolist(), [1.0, 1.0, 1.0])
+        # Results are written through to dynd arrays
+        b = nd.array([0, 0, 0], type='3 * int32')
+        np.add.accumulate(a, out=b)
+        self.assertEqual(nd.as_py(b), [1, 3, 6])
+
+    def test_function(self):
+        a = nd.array([[1.0, 2.0], [3.0, 4.0]])
+        self.assertEqual(np.ndim(a), 2)
+        self.assertEqual(np.shape(a), (2, 2))
+        s = np.sum(a)
+        self.assertTrue(isinstance(s, nd.array))
+        self.assertEqual(nd.as_py(s), 10.0)
+        self.assertEqual(nd.as_py(np.sum(a, axis=0)), [4.0, 6.0])
+        # Other functions and arguments are computed by NumPy
+        self.assertEqual(np.mean(a), 2.5)
+        self.assertEqual(np.sum(a, dtype=np.int64), 10)
+        self.assertEqual(np.concatenate([a, a]).shape, (4, 2))
+
+
+class TestRagged(unittest.TestCase):
+    def test_ragged_roundtrip(self):
+        v = np.arange(6.0)
+        a = nd.ragged_from_numpy(v, [0, 2, 2, 6])
+        self.assertEqual(nd.type_of(a), ndt.type('3 * var * float64'))
+        self.assertEqual(nd.as_py(a), [[0.0, 1.0], [], [2.0, 3.0, 4.0, 5.0]])
+        # No copies are made either way
+        v[0] = 10.0
+        self.assertEqual(nd.as_py(a[0, 0]), 10.0)
+        values, offsets = nd.ragged_to_numpy(a)
+        self.assertEqual(values.ctypes.data, v.ctypes.data)
+        self.assertEqual(values.tolist(), v.tolist())
+        self.assertEqual(offsets.dtype, np.dtype('int64'))
+        self.assertEqual(offsets.tolist(), [0, 2, 2, 6])
+
+    def test_ragged_fixed_elements(self):
+        a = nd.array([[[1, 2]], [], [[3, 4], [5, 6]]], type='3 * var * 2 * int32')
+        values, offsets = nd.ragged_to_numpy(a)
+        self.assertEqual(values.shape, (3, 2))
+        self.assertEqual(values.tolist(), [[1, 2], [3, 4], [5, 6]])
+        self.assertEqual(offsets.tolist(), [0, 1, 1, 3])
+        b = nd.ragged_from_numpy(values, offsets)
+        self.assertEqual(nd.type_of(b), ndt.type('3 * var * 2 * int32'))
+        self.assertEqual(nd.as_py(b), nd.as_py(a))
+
+    def test_ragged_compacted(self):
+        v = np.arange(4, dtype=np.int16)
+        a = nd.ragged_from_numpy(v, [0, 1, 4])[::-1]
+        values, offsets = nd.ragged_to_numpy(a)
+        self.assertNotEqual(values.ctypes.data, v.ctypes.data)
+        self.assertEqual(values.tolist(), [1, 2, 3, 0])
+        self.assertEqual(offsets.tolist(), [0, 3, 4])
+
+    def test_ragged_errors(self):
+        self.assertRaises(TypeError, nd.ragged_to_numpy, nd.array([1, 2, 3]))
+        self.assertRaises(TypeError, nd.ragged_to_numpy, nd.array([['a'], ['b', 'c']]))
+        v = np.arange(3)
+        self.assertRaises(ValueError, nd.ragged_from_numpy, v, [0, 2, 1])
+        self.assertRaises(ValueError, nd.ragged_from_numpy, v, [0, 4])
+        self.assertRaises(ValueError, nd.ragged_from_numpy, v, [])
+
+    def test_to_padded(self):
+        a = nd.array([[1, 2], [], [3, 4, 5]], type='3 * var * int32')
+        padded, mask = nd.to_padded(a)
+        self.assertEqual(nd.type_of(padded), ndt.type('3 * 3 * int32'))
+        self.assertEqual(nd.as_py(padded), [[1, 2, 0], [0, 0, 0], [3, 4, 5]])
+        self.assertEqual(nd.as_py(mask), [[True, True, False], [False, False, False],
+                                          [True, True, True]])
+        # The results can be viewed by NumPy
+        self.assertEqual(np.asarray(padded).tolist(), nd.as_py(padded))
+        self.assertEqual(np.asarray(mask).dtype, np.dtype('bool'))
+
+    def test_to_padded_options(self):
+        a = nd.array([[1.0, 2.0], [], [3.0, 4.0, 5.0]], type='3 * var * float64')
+        padded = nd.to_padded(a, fill=-1, maxlen=2, return_mask=False)
+        self.assertEqual(nd.as_py(padded), [[1.0, 2.0], [-1.0, -1.0], [3.0, 4.0]])
+        padded, mask = nd.to_padded(a, fill=-1, maxlen=4, align='right')
+        self.assertEqual(nd.as_py(padded), [[-1.0, -1.0, 1.0, 2.0], [-1.0, -1.0, -1.0, -1.0],
+                                            [-1.0, 3.0, 4.0, 5.0]])
+        self.assertEqual(nd.as_py(mask[0]), [False, False, True, True])
+        padded = nd.to_padded(a, maxlen=2, return_mask=False, truncate='start')
+        self.assertEqual(nd.as_py(padded[2]), [4.0, 5.0])
+        b = nd.array([[[1, 2]], [[3, 4], [5, 6]]], type='2 * var * 2 * int16')
+        self.assertEqual(nd.as_py(nd.to_padded(b, return_mask=False)),
+                         [[[1, 2], [0, 0]], [[3, 4], [5, 6]]])
+
+    def test_to_padded_errors(self):
+        a = nd.array([[1], [2, 3]])
+        self.assertRaises(ValueError, nd.to_padded, a, align='center')
+        self.assertRaises(ValueError, nd.to_padded, a, truncate='middle')
+        self.assertRaises(ValueError, nd.to_padded, a, maxlen=-1)
+        self.assertRaises(TypeError, nd.to_padded, nd.array([1, 2]))
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -1,3 +1,4 @@
+import sys
 import unittest
 from pickle import loads, dumps
 from dynd import nd, ndt
@@ -8,5 +9,85 @@ class TestPickle(unittest.TestCase):
         self.assertEqual(nd.callable, loads(dumps(nd.callable)))
         self.assertEqual(ndt.type, loads(dumps(ndt.type)))
 
+    def check_roundtrip(self, a):
+        for protocol in range(2, 6 if sys.version_info >= (3, 8) else 3):
+            b = loads(dumps(a, protocol))
+            self.assertEqual(nd.type_of(b), nd.type_of(a))
+            self.assertEqual(nd.as_py(b), nd.as_py(a))
+
+    def test_pickle_fixed(self):
+        self.check_roundtrip(nd.array([[1, 2, 3], [4, 5, 6]]))
+        self.check_roundtrip(nd.array([1.5, 2.5, 3.5])[::2])
+        self.check_roundtrip(nd.array(3.25))
+
+    def test_pickle_var(self):
+        self.check_roundtrip(nd.array([[1, 2], [], [3]], type='3 * var * int32'))
+
+    def test_pickle_struct(self):
+        self.check_roundtrip(nd.array([{'name': 'a', 'xs': [1.0, 2.0]}, {'name': 'bcd', 'xs': []}],
+                                      type='2 * {name: string, xs: var * float64}'))
+
+    def test_pickle_writable(self):
+        for a in [nd.array([1, 2, 3], type='3 * int32'), nd.array([[1, 2], [3]], type='2 * var * int32')]:
+            for protocol in range(2, 6 if sys.version_info >= (3, 8) else 3):
+                b = loads(dumps(a, protocol))
+                self.assertEqual(b.access_flags, 'readwrite')
+
+    @unittest.skipIf(sys.version_info < (3, 8), 'pickle protocol 5 requires Python 3.8')
+    def test_pickle_out_of_band(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]], type='2 * 3 * int64')
+        buffers = []
+        s = dumps(a, 5, buffer_callback=buffers.append)
+        self.assertEqual(len(buffers), 1)
+        self.assertEqual(buffers[0].raw().nbytes, 48)
+
+        # Unpickling views the received buffer
+        data = bytearray(buffers[0].raw())
+        b = loads(s, buffers=[data])
+        self.assertEqual(nd.as_py(b), [[1, 2, 3], [4, 5, 6]])
+        data[0] = 100
+        self.assertEqual(nd.as_py(b[0, 0]), 100)
+
+    @unittest.skipIf(sys.version_info < (3, 8), 'pickle protocol 5 requires Python 3.8')
+    def test_pickle_out_of_band_var_view(self):
+        a = nd.array([[11, 12, 13], [14]], type='2 * var * int64')
+        buffers = []
+        s = dumps(a, 5, buffer_callback=buffers.append)
+
+        # The var dimensions point into the received buffer
+        data = bytearray(buffers[0].raw())
+        b = loads(s, buffers=[data])
+        self.assertEqual(nd.as_py(b), [[11, 12, 13], [14]])
+        data[data.index((11).to_bytes(8, sys.byteorder))] = 100
+        self.assertEqual(nd.as_py(b[0, 0]), 100)
+
+        # A read-only buffer is copied from
+        b = loads(s, buffers=[bytes(buffers[0].raw())])
+        self.assertEqual(nd.as_py(b), [[11, 12, 13], [14]])
+        self.assertEqual(b.access_flags, 'readwrite')
+
+    @unittest.skipIf(sys.version_info < (3, 8), 'pickle protocol 5 requires Python 3.8')
+    def test_pickle_out_of_band_twice(self):
+        a = nd.array([[[1, 2], []], [[3]]], type='2 * var * var * int64')
+        buffers = []
+        s = dumps(a, 5, buffer_callback=buffers.append)
+
+        # The received buffer is left as it was, so it can be unpickled again
+        data = bytearray(buffers[0].raw())
+        before = bytes(data)
+        b = loads(s, buffers=[data])
+        c = loads(s, buffers=[data])
+        self.assertEqual(bytes(data), before)
+        self.assertEqual(nd.as_py(b), [[[1, 2], []], [[3]]])
+        self.assertEqual(nd.as_py(c), [[[1, 2], []], [[3]]])
+
+    @unittest.skipIf(sys.version_info < (3, 8), 'pickle protocol 5 requires Python 3.8')
+    def test_pickle_out_of_band_var(self):
+        a = nd.array([['a', 'bc'], ['def']], type='2 * var * string')
+        buffers = []
+        s = dumps(a, 5, buffer_callback=buffers.append)
+        self.assertEqual(len(buffers), 1)
+        self.assertEqual(nd.as_py(loads(s, buffers=buffers)), [['a', 'bc'], ['def']])
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,77 @@
+import os
+import sys
+import tempfile
+import unittest
+from dynd import nd, ndt
+
+class TestSaveLoad(unittest.TestCase):
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp(suffix='.dynd')
+        os.close(fd)
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def roundtrip(self, a, mmap=True):
+        nd.save(self.path, a)
+        return nd.load(self.path, mmap=mmap)
+
+    def test_fixed(self):
+        a = nd.array([[1.5, 2.5, 3.5], [4.5, 5.5, 6.5]])
+        for mmap in [True, False]:
+            b = self.roundtrip(a, mmap)
+            self.assertEqual(nd.type_of(b), nd.type_of(a))
+            self.assertEqual(nd.as_py(b), nd.as_py(a))
+
+    def test_mmap_is_readonly_view(self):
+        b = self.roundtrip(nd.array([1, 2, 3]))
+        self.assertEqual(b.access_flags, 'readonly')
+        b = self.roundtrip(nd.array([1, 2, 3]), mmap=False)
+        self.assertEqual(b.access_flags, 'readwrite')
+
+    def test_strided(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]])[:, ::2]
+        self.assertEqual(nd.as_py(self.roundtrip(a)), [[1, 3], [4, 6]])
+
+    def test_var_dim(self):
+        a = nd.array([[1, 2], [], [3, 4, 5]], type='3 * var * int32')
+        for mmap in [True, False]:
+            b = self.roundtrip(a, mmap)
+            self.assertEqual(nd.type_of(b), ndt.type('3 * var * int32'))
+            self.assertEqual(nd.as_py(b), [[1, 2], [], [3, 4, 5]])
+            self.assertEqual(nd.as_py(b[2]), [3, 4, 5])
+
+    def test_nested_var_dim(self):
+        val = [[[1], [2, 3]], [], [[], [4, 5, 6]]]
+        a = nd.array(val, type='var * var * var * int64')
+        self.assertEqual(nd.as_py(self.roundtrip(a)), val)
+
+    def test_string(self):
+        val = ['hello', '', u'\u00e9t\u00e9', 'a longer string ' * 10]
+        a = nd.array(val, type='4 * string')
+        for mmap in [True, False]:
+            self.assertEqual(nd.as_py(self.roundtrip(a, mmap)), val)
+
+    def test_struct(self):
+        tp = ndt.type('var * {name: string, scores: var * float64, id: int32}')
+        val = [{'name': 'a', 'scores': [1.0, 2.0], 'id': 1},
+               {'name': 'bcd', 'scores': [], 'id': 2}]
+        a = nd.array(val, type=tp)
+        b = self.roundtrip(a)
+        self.assertEqual(nd.type_of(b), tp)
+        self.assertEqual(nd.as_py(b), val)
+
+    def test_option(self):
+        a = nd.array([1, None, 3], type='3 * ?int32')
+        self.assertEqual(nd.as_py(self.roundtrip(a)), [1, None, 3])
+
+    def test_not_a_dynd_file(self):
+        with open(self.path, 'wb') as f:
+            f.write(b'\0' * 100)
+        self.assertRaises(RuntimeError, nd.load, self.path)
+
+    def test_missing_file(self):
+        self.assertRaises(OSError, nd.load, self.path + '.missing')
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
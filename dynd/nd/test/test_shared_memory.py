@@ -0,0 +1,76 @@
+import gc
+import multiprocessing
+import os
+import sys
+import unittest
+from dynd import nd, ndt
+
+def _sum_shared(handle):
+    return sum(nd.as_py(nd.attach_shared(handle)))
+
+@unittest.skipIf(sys.platform == 'win32', 'shared memory arrays require POSIX')
+class TestSharedMemory(unittest.TestCase):
+    def test_empty_shared(self):
+        a = nd.empty('3 * int32', shared=True)
+        self.assertEqual(nd.type_of(a), ndt.type('3 * int32'))
+        a[...] = [1, 2, 3]
+        self.assertEqual(nd.as_py(a), [1, 2, 3])
+        a = nd.empty((2, 3), ndt.float64, shared=True)
+        self.assertEqual(nd.type_of(a), ndt.type('2 * 3 * float64'))
+
+    def test_to_shared(self):
+        a = nd.to_shared(nd.array([{'x': 1, 'y': 2.5}, {'x': 3, 'y': 4.5}],
+                                  type='2 * {x: int32, y: float64}'))
+        self.assertEqual(nd.as_py(a), [{'x': 1, 'y': 2.5}, {'x': 3, 'y': 4.5}])
+
+    def test_attach(self):
+        a = nd.to_shared(nd.array([1, 2, 3]))
+        b = nd.attach_shared(nd.shared_handle(a))
+        self.assertEqual(b.access_flags, 'readonly')
+        a[0] = 100
+        self.assertEqual(nd.as_py(b), [100, 2, 3])
+        c = nd.attach_shared(nd.shared_handle(a), readonly=False)
+        c[1] = 200
+        self.assertEqual(nd.as_py(a), [100, 200, 3])
+
+    def test_released(self):
+        h = nd.shared_handle(nd.to_shared(nd.array([1, 2, 3])))
+        self.assertRaises(OSError, nd.attach_shared, h)
+
+    def test_view_has_no_handle(self):
+        a = nd.to_shared(nd.array([1, 2, 3]))
+        self.assertRaises(ValueError, nd.shared_handle, a[1:])
+        self.assertRaises(ValueError, nd.shared_handle, nd.array([1, 2, 3]))
+
+    def test_unsupported_type(self):
+        self.assertRaises(TypeError, nd.to_shared, nd.array(['a', 'b']))
+        self.assertRaises(TypeError, nd.empty, 'var * int32', shared=True)
+
+    def test_other_process(self):
+        a = nd.to_shared(nd.array(list(range(100))))
+        pool = multiprocessing.Pool(2)
+        try:
+            self.assertEqual(pool.map(_sum_shared, [nd.shared_handle(a)] * 2), [4950, 4950])
+        finally:
+            pool.close()
+            pool.join()
+
+    @unittest.skipIf(not hasattr(os, 'fork'), 'requires os.fork')
+    def test_fork(self):
+        # A forked child releasing the arrays it inherited leaves the count
+        # of attachments as it was
+        a = nd.to_shared(nd.array([1, 2, 3]))
+        h = nd.shared_handle(a)
+        pid = os.fork()
+        if pid == 0:
+            del a
+            gc.collect()
+            os._exit(0)
+        os.waitpid(pid, 0)
+        self.assertEqual(nd.as_py(nd.attach_shared(h)), [1, 2, 3])
+        del a
+        gc.collect()
+        self.assertRaises(OSError, nd.attach_shared, h)
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -0,0 +1,84 @@
+import io
+import json
+import locale
+import unittest
+from dynd import nd, ndt
+
+class TestToJSON(unittest.TestCase):
+    def test_scalars(self):
+        self.assertEqual(nd.to_json(nd.array(True)), 'true')
+        self.assertEqual(nd.to_json(nd.array(-9223372036854775808, type='int64')), '-9223372036854775808')
+        self.assertEqual(nd.to_json(nd.array(18446744073709551615, type='uint64')), '18446744073709551615')
+        self.assertEqual(nd.to_json(nd.array(0.1)), '0.1')
+        self.assertEqual(nd.to_json(nd.array(1.0)), '1.0')
+        self.assertEqual(nd.to_json(nd.array(0.1, type='float32')), '0.1')
+        self.assertEqual(nd.to_json(nd.array(float('nan'))), 'null')
+
+    def test_float_roundtrip(self):
+        values = [1 / 3.0, 5e-324, 1.7976931348623157e308, 2.0**-1022, 123456.789, -0.0, 1e22, 1e16, 1e-05,
+                  2.0**53 + 2, 0.3]
+        text = nd.to_json(nd.array(values))
+        self.assertEqual(json.loads(text), values)
+        self.assertEqual(text, json.dumps(values, separators=(',', ':')))
+
+    def test_float_locale(self):
+        # The numbers are written the same in a locale with a decimal comma
+        old = locale.setlocale(locale.LC_NUMERIC)
+        for name in ['de_DE.UTF-8', 'de_DE', 'fr_FR.UTF-8', 'German']:
+            try:
+                locale.setlocale(locale.LC_NUMERIC, name)
+                break
+            except locale.Error:
+                pass
+        else:
+            self.skipTest('no locale with a decimal comma')
+        try:
+            values = [1.5, 0.1, 1 / 3.0, 1e-300]
+            self.assertEqual(nd.to_json(nd.array(values)), json.dumps(values, separators=(',', ':')))
+            self.assertEqual(nd.to_json(nd.array([1.5, 0.1], type='2 * float32')), '[1.5,0.1]')
+        finally:
+            locale.setlocale(locale.LC_NUMERIC, old)
+
+    def test_strings(self):
+        s = u'a"b\\c\n\x01é\U0001f600'
+        text = nd.to_json(nd.array([s]))
+        self.assertEqual(json.loads(text), [s])
+
+    def test_struct(self):
+        a = nd.array([{'x': 1, 'y': [1, 2]}, {'x': None, 'y': []}], type='2 * {x: ?int32, y: var * int16}')
+        self.assertEqual(nd.to_json(a), '[{"x":1,"y":[1,2]},{"x":null,"y":[]}]')
+        self.assertEqual(json.loads(nd.to_json(a)), nd.as_py(a))
+
+    def test_roundtrip_parse_json(self):
+        tp = '3 * {name: string, score: float64, ok: bool}'
+        a = nd.array([{'name': 'a', 'score': 0.5, 'ok': True}, {'name': u'é', 'score': -1e300, 'ok': False},
+                      {'name': '', 'score': 3.0, 'ok': True}], type=tp)
+        self.assertEqual(nd.as_py(nd.parse_json(tp, nd.to_json(a))), nd.as_py(a))
+
+    def test_stream(self):
+        a = nd.array(list(range(10)), type='10 * int32')
+        expected = json.dumps(list(range(10)), separators=(',', ':'))
+        f = io.StringIO()
+        nd.to_json(a, f, chunk_rows=3)
+        self.assertEqual(f.getvalue(), expected)
+        f = io.BytesIO()
+        nd.to_json(a, f, chunk_rows=3)
+        self.assertEqual(f.getvalue().decode('utf-8'), expected)
+        f = io.BytesIO()
+        nd.to_json(nd.empty('0 * int32'), f)
+        self.assertEqual(f.getvalue(), b'[]')
+
+    def test_to_json_lines(self):
+        a = nd.array([{'x': 1}, {'x': 2}, {'x': 3}], type='3 * {x: int32}')
+        self.assertEqual(a.to_json_lines(), '{"x":1}\n{"x":2}\n{"x":3}\n')
+        f = io.BytesIO()
+        a.to_json_lines(f, chunk_rows=2)
+        self.assertEqual(nd.as_py(nd.read_json_lines(io.BytesIO(f.getvalue()), '{x: int32}')), nd.as_py(a))
+        self.assertRaises(TypeError, nd.array(1).to_json_lines)
+
+    def test_errors(self):
+        self.assertRaises(TypeError, nd.to_json, nd.array(1 + 2j))
+        self.assertRaises(ValueError, nd.to_json, nd.array([1]), io.BytesIO(), chunk_rows=0)
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -61,5 +61,54 @@ class TestDType(unittest.TestCase):
         self.assertEqual(nd.as_py(colors.ints), color_vals_int)
 """
 
+class TestCategoricalIngestion(unittest.TestCase):
+    def test_encode_strings(self):
+        vals = ['red', 'green', 'red', 'blue', 'green', 'red']
+        a = nd.array(vals, categorical='auto')
+        self.assertTrue(str(nd.dtype_of(a)).startswith('categorical'))
+        self.assertEqual(nd.as_py(a), vals)
+
+    def test_encode_struct_field(self):
+        vals = [{'name': 'x', 'count': 1}, {'name': 'y', 'count': 2},
+                {'name': 'x', 'count': 3}]
+        a = nd.array(vals, type='3 * {name: string, count: int32}',
+                     categorical='auto')
+        self.assertTrue('categorical' in str(nd.type_of(a)))
+        self.assertEqual(nd.as_py(a), vals)
+
+    def test_fallback_to_string(self):
+        vals = ['a', 'b', 'c', 'a']
+        a = nd.array(vals, categorical='auto', max_categories=2)
+        self.assertEqual(nd.dtype_of(a), ndt.string)
+        self.assertEqual(nd.as_py(a), vals)
+        a = nd.array(vals, categorical='auto', max_categories=3)
+        self.assertTrue(str(nd.dtype_of(a)).startswith('categorical'))
+        self.assertEqual(nd.as_py(a), vals)
+
+    def test_fallback_one_field(self):
+        vals = [{'a': 'x', 'b': 'p'}, {'a': 'y', 'b': 'q'}, {'a': 'x', 'b': 'r'}]
+        a = nd.array(vals, type='3 * {a: string, b: string}',
+                     categorical='auto', max_categories=2)
+        self.assertTrue(str(nd.type_of(a)).endswith('b: string}'))
+        self.assertTrue('categorical' in str(nd.type_of(a)))
+        self.assertEqual(nd.as_py(a), vals)
+
+    def test_fallback_values(self):
+        # The values of a string which isn't encoded, and of var dimensions,
+        # are assigned together per field
+        vals = [{'a': 'xy'[i % 2], 'b': str(i), 'v': list(range(i % 3))} for i in range(1000)]
+        a = nd.array(vals, type='1000 * {a: string, b: string, v: var * int32}',
+                     categorical='auto', max_categories=10)
+        self.assertTrue(str(nd.type_of(a)).endswith('b: string, v: var * int32}'))
+        self.assertTrue('categorical' in str(nd.type_of(a)))
+        self.assertEqual(nd.as_py(a), vals)
+
+    def test_no_strings(self):
+        a = nd.array([1, 2, 3], categorical='auto')
+        self.assertEqual(nd.type_of(a), ndt.type('3 * int32'))
+
+    def test_bad_option(self):
+        self.assertRaises(ValueError, nd.array, ['a'], categorical='always')
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -60,5 +60,53 @@ class TestEncodings(unittest.TestCase):
             self.assertEqual(t.encoding, x)
 
 
+class TestUTF8(unittest.TestCase):
+    def backends(self):
+        from dynd.nd.array import _utf8_backend
+        result = ['scalar']
+        for name in ['sse2', 'avx2']:
+            try:
+                _utf8_backend(name)
+                result.append(name)
+            except ValueError:
+                pass
+        _utf8_backend('')
+        return result
+
+    def test_length(self):
+        from dynd.nd.array import _utf8_length, _utf8_backend
+        # The invalid sequences at the end of 32 byte blocks, and straddling
+        # them, are checked by the vectorized validation
+        cases = [(b'', 0), (b'abc', 3), (u'h\xe9llo \u20ac\U0001f600'.encode('utf-8'), 8),
+                 (b'a' * 31 + u'\xe9'.encode('utf-8'), 32), (b'a' * 30 + u'\u20ac'.encode('utf-8'), 31),
+                 (b'\x80', -1), (b'\xc0\xaf', -1), (b'\xe0\x80\xaf', -1), (b'\xed\xa0\x80', -1),
+                 (b'\xf4\x90\x80\x80', -1), (b'\xf8\x88\x80\x80\x80', -1), (b'a' * 31 + b'\xc3', -1),
+                 (b'a' * 31 + b'\xe2\x82', -1), (b'a' * 64 + b'\xf0\x9f\x98', -1), (b'\xc3' + b'a' * 40, -1)]
+        try:
+            for name in self.backends():
+                _utf8_backend(name)
+                for data, length in cases:
+                    self.assertEqual(_utf8_length(data), length, (name, data))
+        finally:
+            _utf8_backend('')
+
+    def test_backends_agree(self):
+        from dynd.nd.array import _utf8_backend
+        import numpy as np
+        # Long enough to cross several blocks, with every width of code
+        # point and each of the narrowest Python string representations
+        values = [u'', u'x' * 100, u'caf\xe9 ' * 20, u'\u043f\u0440\u0438\u0432\u0435\u0442 ' * 20,
+                  u'a\U0001f600b' * 20, u'\ufeffbom']
+        try:
+            for name in self.backends():
+                _utf8_backend(name)
+                self.assertEqual(nd.as_py(nd.array(values)), values, name)
+                b = nd.array(values).to(np.ndarray, strings='U')
+                self.assertEqual(b.tolist(), values, name)
+                self.assertEqual(nd.as_py(nd.array(b)), values, name)
+        finally:
+            _utf8_backend('')
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
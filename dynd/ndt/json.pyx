@@ -1,7 +1,93 @@
 # cython: c_string_type=str, c_string_encoding=ascii
 
-from ..cpp.json_parser cimport discover as _discover
-#from ..wrapper cimport wrap
+from libc.stdint cimport intptr_t
 
-#def discover(obj):
-#    return wrap(_discover(str(obj)))
+from ..config cimport translate_exception
+from ..cpp.type cimport type as _type
+from .type cimport wrap
+
+cdef extern from 'json_discover.hpp' namespace 'pydynd':
+    cdef cppclass json_type_discoverer:
+        json_type_discoverer()
+        void add_lines(const char *, const char *) nogil except +translate_exception
+        void add_value(const char *, const char *, intptr_t) nogil except +translate_exception
+        intptr_t get_count()
+        _type get() except +translate_exception
+
+# The number of lines handed to the discoverer at a time
+cdef intptr_t _batch_lines = 4096
+
+cdef _discover_lines(json_type_discoverer *d, source, sample_rows):
+    cdef bytes data
+    cdef const char *begin
+    cdef intptr_t size
+    it = iter(source)
+    while sample_rows is None or d.get_count() < sample_rows:
+        # Rows are only counted once parsed, so a batch never holds more
+        # lines than the rows still missing from the sample
+        n = _batch_lines if sample_rows is None else min(_batch_lines, sample_rows - d.get_count())
+        lines = []
+        for line in it:
+            if isinstance(line, unicode):
+                line = (<unicode>line).encode('utf-8')
+            lines.append(line)
+            if len(lines) == n:
+                break
+        if not lines:
+            break
+        data = b'\n'.join(lines)
+        begin = data
+        size = len(data)
+        with nogil:
+            d.add_lines(begin, begin + size)
+
+def discover(source, sample_rows=1000):
+    """
+    ndt.json.discover(source, sample_rows=1000)
+    Discovers a dynd type for JSON, by scanning the text and merging the
+    shapes of the values without building them. Numbers are int64, or
+    float64 once any of them has a fraction or an exponent, lists are
+    var dimensions and objects are structs of all the fields seen.
+    Scalars which are null, and fields which are missing from some of
+    the objects, are options. Lists and objects can't be options, so
+    they raise a TypeError if they are null or missing in some rows.
+    Parameters
+    ----------
+    source : str, bytes, file or iterable
+        A JSON document as str or bytes. Otherwise, a file or an
+        iterable of lines of newline delimited JSON, whose row type is
+        discovered from the first rows, e.g. for nd.read_json_lines.
+    sample_rows : int or None, optional
+        The number of rows of newline delimited JSON, or of elements of
+        a document which is a list, to discover the type from, or None
+        for all of them. Only these are read from the source, and the
+        rest of a document isn't checked. Other documents are scanned
+        whole.
+    Examples
+    --------
+    >>> from dynd import ndt
+    >>> ndt.json.discover(['{"x": 1, "y": "a"}', '{"x": 2.5, "y": null}'])
+    ndt.type("{x: float64, y: ?string}")
+    >>> ndt.json.discover('[[1, 2], [3]]')
+    ndt.type("var * var * int64")
+    """
+    cdef json_type_discoverer d
+    cdef bytes data
+    cdef const char *begin
+    cdef intptr_t size
+    cdef intptr_t max_elements = -1 if sample_rows is None else sample_rows
+    if sample_rows is not None and sample_rows <= 0:
+        raise ValueError('sample_rows must be positive or None')
+
+    if isinstance(source, unicode):
+        source = (<unicode>source).encode('utf-8')
+    if isinstance(source, bytes):
+        data = source
+        begin = data
+        size = len(data)
+        with nogil:
+            d.add_value(begin, begin + size, max_elements)
+    else:
+        _discover_lines(&d, source, sample_rows)
+
+    return wrap(d.get())
@@ -0,0 +1,65 @@
+import io
+import unittest
+from dynd import nd, ndt
+
+class TestJSONDiscover(unittest.TestCase):
+    def test_scalars(self):
+        self.assertEqual(ndt.json.discover('1'), ndt.int64)
+        self.assertEqual(ndt.json.discover('1.5'), ndt.float64)
+        self.assertEqual(ndt.json.discover('9223372036854775808'), ndt.float64)
+        self.assertEqual(ndt.json.discover('true'), ndt.bool)
+        self.assertEqual(ndt.json.discover(b'"abc"'), ndt.string)
+
+    def test_document(self):
+        self.assertEqual(ndt.json.discover('[[1, 2], [], [3.5]]'), ndt.type('var * var * float64'))
+        self.assertEqual(ndt.json.discover('[{"x": 1}, {"x": null, "y": "a"}]'),
+                         ndt.type('var * {x: ?int64, y: ?string}'))
+
+    def test_lines(self):
+        lines = ['{"id": 1, "name": "a", "tags": ["x"]}', '',
+                 '{"id": 2, "name": null, "tags": [], "score": 0.5}']
+        tp = ndt.json.discover(lines)
+        self.assertEqual(tp, ndt.type('{id: int64, name: ?string, tags: var * string, score: ?float64}'))
+        a = nd.read_json_lines(lines, tp)
+        self.assertEqual(nd.as_py(a)[1]['score'], 0.5)
+
+    def test_missing_lists_and_objects(self):
+        # Only scalars can be options, so a list or an object which is
+        # missing from some rows, or null, is an error
+        for lines in [['{"a": 1, "v": [1]}', '{"a": 2}'], ['{"a": 1}', '{"a": 2, "o": {"x": 1}}'],
+                      ['{"v": [1]}', '{"v": null}'], ['{"v": [{"x": []}, {"y": 1}]}']]:
+            self.assertRaises(TypeError, ndt.json.discover, lines)
+        self.assertRaises(TypeError, ndt.json.discover, '[[1], null]')
+        self.assertEqual(ndt.json.discover(['{"o": {"x": 1}}', '{"o": {"y": "a"}}']),
+                         ndt.type('{o: {x: ?int64, y: ?string}}'))
+
+    def test_file(self):
+        f = io.BytesIO(b'{"a": 1}\n{"a": 2}\n')
+        self.assertEqual(ndt.json.discover(f), ndt.type('{a: int64}'))
+
+    def test_sample_rows(self):
+        lines = ['{"a": %d}' % i for i in range(10000)] + ['{"a": "not a number"}']
+        self.assertEqual(ndt.json.discover(lines, sample_rows=10000), ndt.type('{a: int64}'))
+        self.assertRaises(TypeError, ndt.json.discover, lines, sample_rows=None)
+        # Only the sampled rows are read from the source
+        it = iter(['{"a": 1}', '', '{"a": 2}', '{"a": 3}'])
+        ndt.json.discover(it, sample_rows=2)
+        self.assertEqual(list(it), ['{"a": 3}'])
+
+    def test_sample_elements(self):
+        # Only the first elements of a document which is a list are scanned
+        doc = '[' + ', '.join(['1'] * 10) + ', "a", {'
+        self.assertEqual(ndt.json.discover(doc, sample_rows=10), ndt.type('var * int64'))
+        self.assertRaises(TypeError, ndt.json.discover, doc, sample_rows=11)
+        self.assertRaises(TypeError, ndt.json.discover, doc, sample_rows=None)
+        self.assertRaises(ValueError, ndt.json.discover, doc.replace(", \"a\"", ""), sample_rows=None)
+
+    def test_errors(self):
+        self.assertRaises(ValueError, ndt.json.discover, '{"a": 1,}')
+        self.assertRaises(ValueError, ndt.json.discover, '[1] 2')
+        self.assertRaises(ValueError, ndt.json.discover, [])
+        self.assertRaises(ValueError, ndt.json.discover, ['{}'], sample_rows=0)
+        self.assertRaises(TypeError, ndt.json.discover, '[1, "a"]')
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -15,6 +15,7 @@
 #include "assign.hpp"
 #include "numpy_interop.hpp"
 #include "types/pyobject_type.hpp"
+#include "utf8.hpp"
 #include "utility_functions.hpp"
 
 #include <dynd/kernels/assignment_kernels.hpp>
@@ -22,6 +23,7 @@
 #include <dynd/types/bytes_type.hpp>
 #include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/fixed_string_type.hpp>
+#include <dynd/types/string_type.hpp>
 #include <dynd/types/struct_type.hpp>
 
 using namespace std;
@@ -428,6 +430,140 @@ static void as_numpy_analysis(pyobject_ownref *out_numpy_dtype, bool *out_requir
   throw dynd::type_error(ss.str());
 }
 
+/**
+ * Appends the strings of the `ndim` fixed dimensions at `data` to `out`,
+ * in C order.
+ */
+static void collect_strings(intptr_t ndim, const char *arrmeta, const char *data, vector<const dynd::string *> &out)
+{
+  if (ndim == 0) {
+    out.push_back(reinterpret_cast<const dynd::string *>(data));
+    return;
+  }
+  const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+  for (intptr_t i = 0; i < md->dim_size; ++i) {
+    collect_strings(ndim - 1, arrmeta + sizeof(fixed_dim_type_arrmeta), data + i * md->stride, out);
+  }
+}
+
+/**
+ * Returns the number of code points of every string, checking that they
+ * are valid UTF-8.
+ */
+static vector<intptr_t> string_lengths(const vector<const dynd::string *> &strings)
+{
+  vector<intptr_t> lengths(strings.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    lengths[i] = utf8_length(strings[i]->begin(), strings[i]->end());
+    if (lengths[i] < 0) {
+      stringstream ss;
+      ss << "cannot export string " << i << " to NumPy, it isn't valid UTF-8";
+      throw invalid_argument(ss.str());
+    }
+  }
+
+  return lengths;
+}
+
+/**
+ * Returns a new C contiguous NumPy array of zeros of the fixed width
+ * string type `type_num`, whose elements are `elsize` bytes.
+ */
+static PyObject *new_fixed_string_array(int type_num, intptr_t elsize, intptr_t ndim, intptr_t *shape)
+{
+  PyArray_Descr *dtype = PyArray_DescrNewFromType(type_num);
+  if (dtype == NULL) {
+    throw runtime_error("propagating python error");
+  }
+  dtype->elsize = static_cast<int>(elsize);
+  pyobject_ownref result(PyArray_NewFromDescr(&PyArray_Type, dtype, (int)ndim, shape, NULL, NULL, 0, NULL));
+  memset(PyArray_BYTES((PyArrayObject *)result.get()), 0, PyArray_NBYTES((PyArrayObject *)result.get()));
+
+  return result.release();
+}
+
+static PyObject *strings_as_numpy_unicode(const vector<const dynd::string *> &strings, intptr_t ndim,
+                                          intptr_t *shape)
+{
+  vector<intptr_t> lengths = string_lengths(strings);
+  intptr_t width = 1;
+  for (intptr_t length : lengths) {
+    width = max(width, length);
+  }
+
+  pyobject_ownref result(new_fixed_string_array(NPY_UNICODE, width * 4, ndim, shape));
+  uint32_t *data = reinterpret_cast<uint32_t *>(PyArray_BYTES((PyArrayObject *)result.get()));
+  for (size_t i = 0; i < strings.size(); ++i) {
+    utf8_to_utf32(strings[i]->begin(), strings[i]->end(), data + i * width);
+  }
+
+  return result.release();
+}
+
+PyObject *pydynd::array_strings_as_numpy(PyObject *a_obj, char kind)
+{
+  if (!PyObject_TypeCheck(a_obj, pydynd::get_array_pytypeobject())) {
+    throw runtime_error("can only call dynd's as_numpy on dynd arrays");
+  }
+  nd::array a = pydynd::array_to_cpp_ref(a_obj);
+  if (a.get_type().get_id() == var_dim_id) {
+    // View a var_dim as fixed, like array_as_numpy does
+    a = a.view(
+        ndt::make_fixed_dim(a.get_dim_size(), a.get_type().extended<ndt::base_dim_type>()->get_element_type()));
+  }
+
+  intptr_t ndim = 0;
+  ndt::type el_tp = a.get_type();
+  while (el_tp.get_id() == fixed_dim_id) {
+    ++ndim;
+    el_tp = el_tp.extended<ndt::base_dim_type>()->get_element_type();
+  }
+  if (el_tp.get_id() != string_id) {
+    stringstream ss;
+    ss << "cannot export dynd type " << a.get_type() << " as NumPy strings, it must have fixed dimensions of string";
+    throw dynd::type_error(ss.str());
+  }
+  dimvector shape(ndim);
+  a.get_shape(shape.get());
+  vector<const dynd::string *> strings;
+  collect_strings(ndim, a.get()->metadata(), a.cdata(), strings);
+
+  switch (kind) {
+  case 'S': {
+    // The UTF-8 bytes as they are
+    intptr_t width = 1;
+    for (const dynd::string *s : strings) {
+      width = max<intptr_t>(width, s->end() - s->begin());
+    }
+    pyobject_ownref result(new_fixed_string_array(NPY_STRING, width, ndim, shape.get()));
+    char *data = PyArray_BYTES((PyArrayObject *)result.get());
+    for (size_t i = 0; i < strings.size(); ++i) {
+      if (strings[i]->begin() != strings[i]->end()) {
+        memcpy(data + i * width, strings[i]->begin(), strings[i]->end() - strings[i]->begin());
+      }
+    }
+    return result.release();
+  }
+  case 'U':
+    return strings_as_numpy_unicode(strings, ndim, shape.get());
+  case 'T': {
+    // NumPy casts a UCS4 copy to StringDType. Packing the UTF-8 directly
+    // needs the string API of NumPy 2, which is only compiled in with
+    // NPY_TARGET_VERSION >= 2.0, and then the module doesn't import in NumPy 1
+    pyobject_ownref dtypes(PyImport_ImportModule("numpy.dtypes"));
+    pyobject_ownref string_dtype(PyObject_CallMethod(dtypes.get(), const_cast<char *>("StringDType"), NULL));
+    pyobject_ownref unicode(strings_as_numpy_unicode(strings, ndim, shape.get()));
+    return PyObject_CallMethod(unicode.get(), const_cast<char *>("astype"), const_cast<char *>("O"),
+                               string_dtype.get());
+  }
+  default: {
+    stringstream ss;
+    ss << "the kind of NumPy strings must be 'U', 'S' or 'T', not '" << kind << "'";
+    throw invalid_argument(ss.str());
+  }
+  }
+}
+
 PyObject *pydynd::array_as_numpy(PyObject *a_obj, bool allow_copy)
 {
   if (!PyObject_TypeCheck(a_obj, pydynd::get_array_pytypeobject())) {
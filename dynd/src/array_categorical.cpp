@@ -0,0 +1,508 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dynd/types/categorical_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "array_categorical.hpp"
+#include "types/pyobject_type.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+/**
+ * The places of a type which hold strings, found by a depth first walk
+ * through its dimensions and struct fields. The other places aren't
+ * walked, a node for them has the id `uninitialized_id`.
+ */
+struct string_place {
+  type_id_t id;
+  // The index of the category table of a string
+  size_t leaf;
+  // The index of this place among all of them
+  size_t index;
+  // The field names of a struct, owned by a list of them all
+  vector<PyObject *> names;
+  // The element of a dimension, or the fields of a struct
+  vector<string_place> children;
+  // Whether a string below this place is encoded
+  bool encoded;
+};
+
+bool find_strings(const ndt::type &tp, string_place &place, size_t &leaf_count, size_t &place_count,
+                  PyObject *names)
+{
+  place.id = uninitialized_id;
+  place.index = place_count++;
+  place.encoded = false;
+  switch (tp.get_id()) {
+  case fixed_dim_id:
+  case var_dim_id:
+    place.children.resize(1);
+    if (find_strings(tp.extended<ndt::base_dim_type>()->get_element_type(), place.children[0], leaf_count,
+                     place_count, names)) {
+      place.id = tp.get_id();
+    }
+    break;
+  case struct_id: {
+    const ndt::struct_type *st = tp.extended<ndt::struct_type>();
+    bool found = false;
+    place.children.resize(st->get_field_count());
+    for (intptr_t i = 0; i < st->get_field_count(); ++i) {
+      const dynd::string &name = st->get_field_name(i);
+      pyobject_ownref name_str(PyUnicode_FromStringAndSize(name.begin(), name.end() - name.begin()));
+      if (PyList_Append(names, name_str.get()) < 0) {
+        throw exception();
+      }
+      place.names.push_back(name_str.get());
+      found |= find_strings(st->get_field_type(i), place.children[i], leaf_count, place_count, names);
+    }
+    if (found) {
+      place.id = struct_id;
+    }
+    break;
+  }
+  case string_id:
+    place.id = string_id;
+    place.leaf = leaf_count++;
+    break;
+  default:
+    break;
+  }
+
+  return place.id != uninitialized_id;
+}
+
+/**
+ * Returns a borrowed reference to the value of field `i` of a struct, from
+ * a dict or a sequence, or NULL if it has none.
+ */
+PyObject *field_of(PyObject *obj, const string_place &place, size_t i)
+{
+  if (PyDict_Check(obj)) {
+    return PyDict_GetItem(obj, place.names[i]);
+  }
+  else if (PyTuple_Check(obj)) {
+    return static_cast<size_t>(PyTuple_GET_SIZE(obj)) > i ? PyTuple_GET_ITEM(obj, i) : NULL;
+  }
+  else if (PyList_Check(obj)) {
+    return static_cast<size_t>(PyList_GET_SIZE(obj)) > i ? PyList_GET_ITEM(obj, i) : NULL;
+  }
+  return NULL;
+}
+
+bool is_sequence(PyObject *obj)
+{
+  return PySequence_Check(obj) && !PyUnicode_Check(obj) && !PyBytes_Check(obj) && !PyDict_Check(obj);
+}
+
+bool mark_encoded(string_place &place, const vector<bool> &encoded)
+{
+  if (place.id == string_id) {
+    place.encoded = encoded[place.leaf];
+  }
+  else {
+    place.encoded = false;
+    for (size_t i = 0; i < place.children.size(); ++i) {
+      place.encoded |= mark_encoded(place.children[i], encoded);
+    }
+  }
+
+  return place.encoded;
+}
+
+/**
+ * A walk through a Python object which interns its strings and writes
+ * their codes into an array of its type, with each encoded string replaced
+ * by `uint32`. A string gets the code of the order it was first seen in,
+ * and the codes are remapped to the sorted order once all are known.
+ *
+ * The values of the places without encoded strings are written too. They
+ * are gathered, and assigned from Python together per place after the walk.
+ */
+struct string_encoder {
+  intptr_t max_categories;
+  // Per string, the codes of the distinct values, and the values in the order of their codes
+  vector<pyobject_ownref> tables;
+  vector<pyobject_ownref> categories;
+  vector<bool> encoded;
+  // Whether a string stopped being encoded during the walk, which has to be redone without it
+  bool failed;
+  // Per place, the values gathered for it, where they go, and their type and arrmeta
+  vector<vector<PyObject *>> values;
+  vector<vector<char *>> value_data;
+  vector<ndt::type> value_types;
+  vector<char *> value_arrmeta;
+  // The lists made of sequences which aren't lists or tuples, which own the values gathered from them
+  pyobject_ownref sequences;
+
+  string_encoder(const vector<bool> &encoded, size_t place_count, intptr_t max_categories)
+      : max_categories(max_categories), tables(encoded.size()), categories(encoded.size()), encoded(encoded),
+        failed(false), values(place_count), value_data(place_count), value_types(place_count),
+        value_arrmeta(place_count), sequences(PyList_New(0))
+  {
+    for (size_t i = 0; i < encoded.size(); ++i) {
+      tables[i].reset(PyDict_New());
+      categories[i].reset(PyList_New(0));
+    }
+  }
+
+  /**
+   * Returns a borrowed reference to the items of a sequence, as a list or
+   * tuple which lives as long as the walk.
+   */
+  PyObject *items_of(PyObject *obj)
+  {
+    pyobject_ownref items(PySequence_Fast(obj, "expected a sequence"));
+    if (items.get() != obj && PyList_Append(sequences.get(), items.get()) < 0) {
+      throw exception();
+    }
+    return items.get();
+  }
+
+  /**
+   * Writes `obj` to the value of type `tp` at `place`. Returns false if
+   * `obj` doesn't have the shape of `tp`, leaving it to the assignment
+   * from Python to broadcast or raise an error.
+   */
+  bool write(PyObject *obj, const string_place &place, const ndt::type &tp, const char *arrmeta, char *data)
+  {
+    if (!place.encoded) {
+      write_value(obj, place, tp, arrmeta, data);
+      return true;
+    }
+
+    switch (place.id) {
+    case fixed_dim_id: {
+      if (!is_sequence(obj)) {
+        return false;
+      }
+      PyObject *items = items_of(obj);
+      const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+      if (PySequence_Fast_GET_SIZE(items) != md->dim_size) {
+        return false;
+      }
+      const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+      for (intptr_t i = 0; i < md->dim_size; ++i) {
+        if (!write(PySequence_Fast_GET_ITEM(items, i), place.children[0], el_tp,
+                   arrmeta + sizeof(fixed_dim_type_arrmeta), data + i * md->stride)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case var_dim_id: {
+      if (!is_sequence(obj)) {
+        return false;
+      }
+      PyObject *items = items_of(obj);
+      const ndt::var_dim_type::metadata_type *md = reinterpret_cast<const ndt::var_dim_type::metadata_type *>(arrmeta);
+      const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+      ndt::var_dim_type::data_type *vdd = reinterpret_cast<ndt::var_dim_type::data_type *>(data);
+      vdd->size = PySequence_Fast_GET_SIZE(items);
+      vdd->begin = (vdd->size != 0) ? md->blockref->alloc(vdd->size) : NULL;
+      for (size_t i = 0; i < vdd->size; ++i) {
+        if (!write(PySequence_Fast_GET_ITEM(items, i), place.children[0], el_tp,
+                   arrmeta + sizeof(ndt::var_dim_type::metadata_type), vdd->begin + i * md->stride)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case struct_id: {
+      // A dict has to have exactly the fields, and a list or tuple a value for each
+      const ndt::struct_type *st = tp.extended<ndt::struct_type>();
+      intptr_t field_count = st->get_field_count();
+      if (PyDict_Check(obj)) {
+        if (PyDict_Size(obj) != field_count) {
+          return false;
+        }
+      }
+      else if (!(PyTuple_Check(obj) || PyList_Check(obj)) || PySequence_Size(obj) != field_count) {
+        return false;
+      }
+      const uintptr_t *data_offsets = st->get_data_offsets(arrmeta);
+      const uintptr_t *arrmeta_offsets = st->get_arrmeta_offsets_raw();
+      for (intptr_t i = 0; i < field_count; ++i) {
+        PyObject *field = field_of(obj, place, i);
+        if (field == NULL || !write(field, place.children[i], st->get_field_type(i), arrmeta + arrmeta_offsets[i],
+                                    data + data_offsets[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      write_string(obj, place.leaf, data);
+      return true;
+    }
+  }
+
+  void write_value(PyObject *obj, const string_place &place, const ndt::type &tp, const char *arrmeta, char *data)
+  {
+    values[place.index].push_back(obj);
+    value_data[place.index].push_back(data);
+    value_types[place.index] = tp;
+    // The arrmeta of a place is the same for all of its values, and belongs to the array being written
+    value_arrmeta[place.index] = const_cast<char *>(arrmeta);
+  }
+
+  void write_string(PyObject *obj, size_t leaf, char *data)
+  {
+    if (!encoded[leaf]) {
+      return;
+    }
+
+    // The dict looks the strings up by their cached hash
+    if (PyUnicode_Check(obj)) {
+      PyObject *code = PyDict_GetItem(tables[leaf].get(), obj);
+      if (code != NULL) {
+        *reinterpret_cast<uint32_t *>(data) = static_cast<uint32_t>(PyLong_AsSsize_t(code));
+        return;
+      }
+      Py_ssize_t count = PyList_GET_SIZE(categories[leaf].get());
+      if (count < max_categories) {
+        pyobject_ownref new_code(PyLong_FromSsize_t(count));
+        if (PyDict_SetItem(tables[leaf].get(), obj, new_code.get()) < 0 ||
+            PyList_Append(categories[leaf].get(), obj) < 0) {
+          throw exception();
+        }
+        *reinterpret_cast<uint32_t *>(data) = static_cast<uint32_t>(count);
+        return;
+      }
+    }
+    encoded[leaf] = false;
+    failed = true;
+  }
+
+  /**
+   * Assigns the values gathered for each place from Python in one go, and
+   * moves them to where they go.
+   *
+   * Values which own memory, e.g. strings, are zeroed in the column after
+   * they are copied, so that it releases nothing. The elements of var
+   * dimensions stay in the memory of the column, which the arrmeta of the
+   * place then refers to instead of its own.
+   */
+  void assign_values()
+  {
+    for (size_t i = 0; i < values.size(); ++i) {
+      intptr_t count = values[i].size();
+      if (count == 0) {
+        continue;
+      }
+      const ndt::type &tp = value_types[i];
+      nd::array objects = nd::empty(count, ndt::make_type<pyobject_type>());
+      memcpy(objects.data(), values[i].data(), count * sizeof(PyObject *));
+      nd::array column = nd::empty(count, tp);
+      column.assign(objects);
+
+      intptr_t size = tp.get_data_size();
+      intptr_t stride = reinterpret_cast<const fixed_dim_type_arrmeta *>(column.get()->metadata())->stride;
+      bool owns_memory = (tp.get_flags() & type_flag_destructor) != 0;
+      for (intptr_t j = 0; j < count; ++j) {
+        memcpy(value_data[i][j], column.data() + j * stride, size);
+        if (owns_memory) {
+          memset(column.data() + j * stride, 0, size);
+        }
+      }
+      if ((tp.get_flags() & type_flag_blockref) != 0) {
+        tp.extended()->arrmeta_destruct(value_arrmeta[i]);
+        tp.extended()->arrmeta_copy_construct(value_arrmeta[i],
+                                              column.get()->metadata() + sizeof(fixed_dim_type_arrmeta), column);
+      }
+    }
+  }
+};
+
+/**
+ * Sorts the strings of a category list, fills in the sorted position of
+ * each code in `ranks`, and returns a categorical type of them.
+ */
+ndt::type make_categories(PyObject *categories, PyObject *table, vector<uint32_t> &ranks)
+{
+  pyobject_ownref keys(PySequence_List(categories));
+  if (PyList_Sort(keys.get()) < 0) {
+    throw exception();
+  }
+
+  Py_ssize_t count = PyList_GET_SIZE(keys.get());
+  ranks.resize(count);
+  nd::array values = nd::empty(count, ndt::make_type<ndt::string_type>());
+  dynd::string *data = reinterpret_cast<dynd::string *>(values.data());
+  for (Py_ssize_t i = 0; i < count; ++i) {
+    PyObject *key = PyList_GET_ITEM(keys.get(), i);
+    ranks[PyLong_AsSsize_t(PyDict_GetItem(table, key))] = static_cast<uint32_t>(i);
+    pyobject_ownref utf8(PyUnicode_AsUTF8String(key));
+    char *s = NULL;
+    Py_ssize_t len = 0;
+    if (PyBytes_AsStringAndSize(utf8.get(), &s, &len) < 0) {
+      throw exception();
+    }
+    data[i].assign(s, len);
+  }
+
+  return ndt::make_type<ndt::categorical_type>(values);
+}
+
+/**
+ * Replaces the codes at the encoded places below `place` by their sorted
+ * positions in `ranks`.
+ */
+void remap_codes(const string_place &place, const ndt::type &tp, const char *arrmeta, char *data,
+                 const vector<vector<uint32_t>> &ranks)
+{
+  if (!place.encoded) {
+    return;
+  }
+
+  switch (place.id) {
+  case fixed_dim_id: {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    for (intptr_t i = 0; i < md->dim_size; ++i) {
+      remap_codes(place.children[0], el_tp, arrmeta + sizeof(fixed_dim_type_arrmeta), data + i * md->stride, ranks);
+    }
+    break;
+  }
+  case var_dim_id: {
+    const ndt::var_dim_type::metadata_type *md = reinterpret_cast<const ndt::var_dim_type::metadata_type *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    const ndt::var_dim_type::data_type *vdd = reinterpret_cast<const ndt::var_dim_type::data_type *>(data);
+    for (size_t i = 0; i < vdd->size; ++i) {
+      remap_codes(place.children[0], el_tp, arrmeta + sizeof(ndt::var_dim_type::metadata_type),
+                  vdd->begin + md->offset + i * md->stride, ranks);
+    }
+    break;
+  }
+  case struct_id: {
+    const ndt::struct_type *st = tp.extended<ndt::struct_type>();
+    const uintptr_t *data_offsets = st->get_data_offsets(arrmeta);
+    const uintptr_t *arrmeta_offsets = st->get_arrmeta_offsets_raw();
+    for (intptr_t i = 0; i < st->get_field_count(); ++i) {
+      remap_codes(place.children[i], st->get_field_type(i), arrmeta + arrmeta_offsets[i], data + data_offsets[i],
+                  ranks);
+    }
+    break;
+  }
+  default: {
+    uint32_t &code = *reinterpret_cast<uint32_t *>(data);
+    code = ranks[place.leaf][code];
+    break;
+  }
+  }
+}
+
+/**
+ * Returns `tp` with the string at each place i replaced by `leaf_types[i]`.
+ */
+ndt::type replace_strings(const ndt::type &tp, const string_place &place, const vector<ndt::type> &leaf_types)
+{
+  if (!place.encoded) {
+    return tp;
+  }
+
+  switch (place.id) {
+  case fixed_dim_id:
+    return ndt::make_fixed_dim(
+        tp.extended<ndt::fixed_dim_type>()->get_fixed_dim_size(),
+        replace_strings(tp.extended<ndt::base_dim_type>()->get_element_type(), place.children[0], leaf_types));
+  case var_dim_id:
+    return ndt::make_type<ndt::var_dim_type>(
+        replace_strings(tp.extended<ndt::base_dim_type>()->get_element_type(), place.children[0], leaf_types));
+  case struct_id: {
+    const ndt::struct_type *st = tp.extended<ndt::struct_type>();
+    vector<std::string> names(st->get_field_count());
+    vector<ndt::type> types(st->get_field_count());
+    for (intptr_t i = 0; i < st->get_field_count(); ++i) {
+      const dynd::string &name = st->get_field_name(i);
+      names[i].assign(name.begin(), name.end());
+      types[i] = replace_strings(st->get_field_type(i), place.children[i], leaf_types);
+    }
+    return ndt::make_type<ndt::struct_type>(names, types);
+  }
+  default:
+    return leaf_types[place.leaf];
+  }
+}
+
+} // anonymous namespace
+
+dynd::nd::array pydynd::array_from_py_categorical(PyObject *obj, const dynd::ndt::type &tp, intptr_t max_categories)
+{
+  if (max_categories < 1) {
+    throw invalid_argument("max_categories must be positive");
+  }
+
+  string_place root;
+  size_t leaf_count = 0, place_count = 0;
+  pyobject_ownref names(PyList_New(0));
+  if (tp.is_symbolic() || !find_strings(tp, root, leaf_count, place_count, names.get())) {
+    return nd::array();
+  }
+
+  // The walk is redone without the strings which turn out not to be encodable, usually at most once
+  vector<bool> encoded(leaf_count, true);
+  while (mark_encoded(root, encoded)) {
+    nd::array codes = nd::empty(replace_strings(tp, root, vector<ndt::type>(leaf_count, ndt::make_type<uint32_t>())));
+    string_encoder encoder(encoded, place_count, max_categories);
+    if (!encoder.write(obj, root, codes.get_type(), codes.get()->metadata(), codes.data())) {
+      return nd::array();
+    }
+    for (size_t i = 0; i < leaf_count; ++i) {
+      // A string with no values has no categories to make a type of
+      if (encoder.encoded[i] && PyList_GET_SIZE(encoder.categories[i].get()) == 0) {
+        encoder.encoded[i] = false;
+        encoder.failed = true;
+      }
+    }
+    if (encoder.failed) {
+      encoded = encoder.encoded;
+      continue;
+    }
+    encoder.assign_values();
+    codes.get_type().extended()->arrmeta_finalize_buffers(codes.get()->metadata());
+
+    vector<ndt::type> categorical_types(leaf_count), storage_types(leaf_count);
+    vector<vector<uint32_t>> ranks(leaf_count);
+    for (size_t i = 0; i < leaf_count; ++i) {
+      if (encoded[i]) {
+        categorical_types[i] = make_categories(encoder.categories[i].get(), encoder.tables[i].get(), ranks[i]);
+        storage_types[i] = categorical_types[i].extended<ndt::categorical_type>()->get_storage_type();
+      }
+    }
+    remap_codes(root, codes.get_type(), codes.get()->metadata(), codes.data(), ranks);
+
+    // The codes are narrowed to their storage types if they're smaller,
+    // and viewed as the categorical types, which have the same layout
+    ndt::type storage_tp = replace_strings(tp, root, storage_types);
+    if (storage_tp != codes.get_type()) {
+      nd::array narrowed = nd::empty(storage_tp);
+      narrowed.assign(codes);
+      codes = narrowed;
+    }
+    ndt::type result_tp = replace_strings(tp, root, categorical_types);
+    nd::array result = nd::make_array(result_tp, codes.data(), codes.get_owner() ? codes.get_owner() : codes,
+                                      codes.get_flags());
+    if (result_tp.get_arrmeta_size() > 0) {
+      result_tp.extended()->arrmeta_copy_construct(result.get()->metadata(), codes.get()->metadata(), codes);
+    }
+
+    return result;
+  }
+
+  return nd::array();
+}
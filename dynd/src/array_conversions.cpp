@@ -1,4 +1,5 @@
 #include "array_conversions.hpp"
+#include "kernel_cache.hpp"
 
 #include "array_api.h"
 #include "callable_api.h"
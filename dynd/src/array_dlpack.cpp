@@ -0,0 +1,320 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dynd/memblock/external_memory_block.hpp>
+#include <dynd/shortvector.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "array_dlpack.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+struct dlpack_type {
+  type_id_t id;
+  uint8_t code;
+  uint8_t bits;
+};
+
+const dlpack_type dlpack_types[] = {{bool_id, kDLBool, 8},
+                                    {int8_id, kDLInt, 8},
+                                    {int16_id, kDLInt, 16},
+                                    {int32_id, kDLInt, 32},
+                                    {int64_id, kDLInt, 64},
+                                    {uint8_id, kDLUInt, 8},
+                                    {uint16_id, kDLUInt, 16},
+                                    {uint32_id, kDLUInt, 32},
+                                    {uint64_id, kDLUInt, 64},
+                                    {float32_id, kDLFloat, 32},
+                                    {float64_id, kDLFloat, 64},
+                                    {complex_float32_id, kDLComplex, 64},
+                                    {complex_float64_id, kDLComplex, 128}};
+
+ndt::type builtin_type(type_id_t id)
+{
+  switch (id) {
+  case bool_id:
+    return ndt::make_type<bool1>();
+  case int8_id:
+    return ndt::make_type<int8_t>();
+  case int16_id:
+    return ndt::make_type<int16_t>();
+  case int32_id:
+    return ndt::make_type<int32_t>();
+  case int64_id:
+    return ndt::make_type<int64_t>();
+  case uint8_id:
+    return ndt::make_type<uint8_t>();
+  case uint16_id:
+    return ndt::make_type<uint16_t>();
+  case uint32_id:
+    return ndt::make_type<uint32_t>();
+  case uint64_id:
+    return ndt::make_type<uint64_t>();
+  case float32_id:
+    return ndt::make_type<float>();
+  case float64_id:
+    return ndt::make_type<double>();
+  case complex_float32_id:
+    return ndt::make_type<dynd::complex<float>>();
+  default:
+    return ndt::make_type<dynd::complex<double>>();
+  }
+}
+
+/**
+ * Raises a BufferError, which is what consumers expect when a tensor
+ * can't be exchanged.
+ */
+void raise_buffer_error(const std::string &msg)
+{
+  PyErr_SetString(PyExc_BufferError, msg.c_str());
+  throw runtime_error("propagating a Python exception...");
+}
+
+/**
+ * The manager context of an exported tensor, which keeps the array it
+ * views alive, and owns its shape and strides.
+ */
+struct dlpack_export {
+  nd::array keep;
+  vector<int64_t> shape;
+  vector<int64_t> strides;
+};
+
+template <typename Tensor>
+void delete_exported_tensor(Tensor *self)
+{
+  // Consumers may delete the tensor from any thread, while the array can
+  // hold references to Python objects
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  delete static_cast<dlpack_export *>(self->manager_ctx);
+  delete self;
+  PyGILState_Release(gstate);
+}
+
+// A consumer renames the capsule when it takes over the tensor, so only
+// tensors which weren't consumed are deleted with their capsule
+void release_dltensor_capsule(PyObject *capsule)
+{
+  if (PyCapsule_IsValid(capsule, "dltensor")) {
+    DLManagedTensor *tensor = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, "dltensor"));
+    tensor->deleter(tensor);
+  }
+}
+
+void release_dltensor_versioned_capsule(PyObject *capsule)
+{
+  if (PyCapsule_IsValid(capsule, "dltensor_versioned")) {
+    DLManagedTensorVersioned *tensor =
+        static_cast<DLManagedTensorVersioned *>(PyCapsule_GetPointer(capsule, "dltensor_versioned"));
+    tensor->deleter(tensor);
+  }
+}
+
+/**
+ * Fills in `tensor` to view the data of `ctx->keep`.
+ */
+void fill_tensor(dlpack_export *ctx, DLTensor *tensor)
+{
+  ndt::type tp = ctx->keep.get_type();
+  const char *arrmeta = ctx->keep.get()->metadata();
+  while (tp.get_id() == fixed_dim_id) {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    ctx->shape.push_back(md->dim_size);
+    ctx->strides.push_back(md->stride);
+    arrmeta += sizeof(fixed_dim_type_arrmeta);
+    tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+  }
+
+  const dlpack_type *dtype = NULL;
+  for (const dlpack_type &t : dlpack_types) {
+    if (t.id == tp.get_id()) {
+      dtype = &t;
+    }
+  }
+  if (dtype == NULL) {
+    stringstream ss;
+    ss << "cannot export an array of type " << ctx->keep.get_type()
+       << " to DLPack, it must have fixed dimensions of a builtin numeric type";
+    throw type_error(ss.str());
+  }
+
+  // DLPack strides are in elements, not in bytes
+  int64_t itemsize = tp.get_data_size();
+  for (int64_t &stride : ctx->strides) {
+    if (stride % itemsize != 0) {
+      stringstream ss;
+      ss << "cannot export an array of type " << ctx->keep.get_type()
+         << " to DLPack, its strides aren't multiples of its element size";
+      raise_buffer_error(ss.str());
+    }
+    stride /= itemsize;
+  }
+
+  tensor->data = const_cast<char *>(ctx->keep.cdata());
+  tensor->device.device_type = kDLCPU;
+  tensor->device.device_id = 0;
+  tensor->ndim = static_cast<int32_t>(ctx->shape.size());
+  tensor->dtype.code = dtype->code;
+  tensor->dtype.bits = dtype->bits;
+  tensor->dtype.lanes = 1;
+  tensor->shape = ctx->shape.data();
+  tensor->strides = ctx->strides.data();
+  tensor->byte_offset = 0;
+}
+
+void delete_imported_tensor(void *obj)
+{
+  DLManagedTensor *tensor = reinterpret_cast<DLManagedTensor *>(obj);
+  if (tensor->deleter != NULL) {
+    tensor->deleter(tensor);
+  }
+}
+
+void delete_imported_tensor_versioned(void *obj)
+{
+  DLManagedTensorVersioned *tensor = reinterpret_cast<DLManagedTensorVersioned *>(obj);
+  if (tensor->deleter != NULL) {
+    tensor->deleter(tensor);
+  }
+}
+
+/**
+ * Returns the dynd type of the elements of `tensor`, checking that they
+ * are in memory the CPU can read.
+ */
+ndt::type tensor_element_type(const DLTensor *tensor)
+{
+  if (tensor->device.device_type != kDLCPU) {
+    stringstream ss;
+    ss << "cannot import a DLPack tensor on device type " << tensor->device.device_type << ", only CPU tensors";
+    raise_buffer_error(ss.str());
+  }
+  if (tensor->ndim < 0) {
+    throw invalid_argument("a DLPack tensor has a negative number of dimensions");
+  }
+
+  if (tensor->dtype.lanes == 1) {
+    for (const dlpack_type &t : dlpack_types) {
+      if (t.code == tensor->dtype.code && t.bits == tensor->dtype.bits) {
+        return builtin_type(t.id);
+      }
+    }
+  }
+  stringstream ss;
+  ss << "cannot import a DLPack tensor of type code " << static_cast<int>(tensor->dtype.code) << " with "
+     << static_cast<int>(tensor->dtype.bits) << " bits and " << tensor->dtype.lanes << " lanes";
+  throw type_error(ss.str());
+}
+
+} // anonymous namespace
+
+PyObject *pydynd::array_to_dlpack(const dynd::nd::array &a, bool versioned, bool copy)
+{
+  unique_ptr<dlpack_export> ctx(new dlpack_export);
+  ctx->keep = a;
+  uint64_t flags = 0;
+  if (copy) {
+    ctx->keep = nd::empty(a.get_type());
+    ctx->keep.assign(a);
+    flags |= DLPACK_FLAG_BITMASK_IS_COPIED;
+  }
+  else if ((a.get_flags() & nd::write_access_flag) == 0) {
+    if (!versioned) {
+      raise_buffer_error("cannot export a read-only array to a DLPack tensor before version 1.0");
+    }
+    flags |= DLPACK_FLAG_BITMASK_READ_ONLY;
+  }
+
+  PyObject *capsule;
+  if (versioned) {
+    unique_ptr<DLManagedTensorVersioned> tensor(new DLManagedTensorVersioned);
+    fill_tensor(ctx.get(), &tensor->dl_tensor);
+    tensor->version.major = DLPACK_MAJOR_VERSION;
+    tensor->version.minor = DLPACK_MINOR_VERSION;
+    tensor->flags = flags;
+    tensor->manager_ctx = ctx.get();
+    tensor->deleter = &delete_exported_tensor<DLManagedTensorVersioned>;
+    capsule = PyCapsule_New(tensor.get(), "dltensor_versioned", &release_dltensor_versioned_capsule);
+    if (capsule != NULL) {
+      tensor.release();
+    }
+  }
+  else {
+    unique_ptr<DLManagedTensor> tensor(new DLManagedTensor);
+    fill_tensor(ctx.get(), &tensor->dl_tensor);
+    tensor->manager_ctx = ctx.get();
+    tensor->deleter = &delete_exported_tensor<DLManagedTensor>;
+    capsule = PyCapsule_New(tensor.get(), "dltensor", &release_dltensor_capsule);
+    if (capsule != NULL) {
+      tensor.release();
+    }
+  }
+  if (capsule == NULL) {
+    throw runtime_error("propagating a Python exception...");
+  }
+  ctx.release();
+
+  return capsule;
+}
+
+dynd::nd::array pydynd::array_from_dlpack(PyObject *capsule)
+{
+  bool versioned = PyCapsule_IsValid(capsule, "dltensor_versioned") != 0;
+  if (!versioned && !PyCapsule_IsValid(capsule, "dltensor")) {
+    throw invalid_argument("from_dlpack requires a \"dltensor\" or \"dltensor_versioned\" capsule which wasn't used");
+  }
+
+  DLTensor *tensor;
+  bool readonly = false;
+  void *managed;
+  if (versioned) {
+    DLManagedTensorVersioned *m =
+        static_cast<DLManagedTensorVersioned *>(PyCapsule_GetPointer(capsule, "dltensor_versioned"));
+    if (m->version.major > DLPACK_MAJOR_VERSION) {
+      stringstream ss;
+      ss << "cannot import a tensor of DLPack version " << m->version.major << "." << m->version.minor;
+      raise_buffer_error(ss.str());
+    }
+    tensor = &m->dl_tensor;
+    readonly = (m->flags & DLPACK_FLAG_BITMASK_READ_ONLY) != 0;
+    managed = m;
+  }
+  else {
+    DLManagedTensor *m = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, "dltensor"));
+    tensor = &m->dl_tensor;
+    managed = m;
+  }
+  ndt::type el_tp = tensor_element_type(tensor);
+
+  // DLPack strides are in elements, and absent for C order
+  intptr_t ndim = tensor->ndim;
+  dimvector shape(ndim), strides(ndim);
+  intptr_t itemsize = el_tp.get_data_size(), stride = itemsize;
+  for (intptr_t i = ndim - 1; i >= 0; --i) {
+    shape[i] = tensor->shape[i];
+    strides[i] = (tensor->strides != NULL) ? tensor->strides[i] * itemsize : stride;
+    stride *= shape[i];
+  }
+
+  // Take over the tensor, so that it's deleted with the last view of it
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(
+      managed, versioned ? &delete_imported_tensor_versioned : &delete_imported_tensor);
+  PyCapsule_SetName(capsule, versioned ? "used_dltensor_versioned" : "used_dltensor");
+
+  return nd::make_strided_array_from_data(el_tp, ndim, shape.get(), strides.get(),
+                                          nd::read_access_flag | (readonly ? 0 : nd::write_access_flag),
+                                          static_cast<char *>(tensor->data) + tensor->byte_offset, memblock, NULL);
+}
@@ -313,6 +313,59 @@ static dynd::nd::array array_from_pylist(PyObject *obj)
   return result;
 }
 
+template <typename T>
+static dynd::nd::array make_pyscalar_array(const T &value)
+{
+  nd::array result = nd::empty(ndt::make_type<T>());
+  *reinterpret_cast<T *>(result.data()) = value;
+  return result;
+}
+
+dynd::nd::array pydynd::array_from_pyscalar(PyObject *obj)
+{
+  PyTypeObject *tp = Py_TYPE(obj);
+  if (tp == &PyFloat_Type) {
+    return make_pyscalar_array(PyFloat_AS_DOUBLE(obj));
+  }
+  else if (tp == &PyBool_Type) {
+    nd::array result = nd::empty(ndt::make_type<bool>());
+    *result.data() = (obj == Py_True);
+    return result;
+#if PY_VERSION_HEX < 0x03000000
+  }
+  else if (tp == &PyInt_Type) {
+    long value = PyInt_AS_LONG(obj);
+#if SIZEOF_LONG > SIZEOF_INT
+    // Use a 32-bit int if it fits.
+    if (value >= INT_MIN && value <= INT_MAX) {
+      return make_pyscalar_array(static_cast<int>(value));
+    }
+#endif
+    return make_pyscalar_array(value);
+#endif // PY_VERSION_HEX < 0x03000000
+  }
+  else if (tp == &PyLong_Type) {
+    PY_LONG_LONG value = PyLong_AsLongLong(obj);
+    if (value == -1 && PyErr_Occurred()) {
+      // Leave the overflow to be reported by the general conversion.
+      PyErr_Clear();
+      return nd::array();
+    }
+
+    // Use a 32-bit int if it fits.
+    if (value >= INT_MIN && value <= INT_MAX) {
+      return make_pyscalar_array(static_cast<int>(value));
+    }
+    return make_pyscalar_array(value);
+  }
+  else if (tp == &PyComplex_Type) {
+    Py_complex value = PyComplex_AsCComplex(obj);
+    return make_pyscalar_array(dynd::complex<double>(value.real, value.imag));
+  }
+
+  return nd::array();
+}
+
 dynd::nd::array pydynd::array_from_py(PyObject *obj, uint32_t access_flags, bool always_copy)
 {
   // If it's a Cython w_array
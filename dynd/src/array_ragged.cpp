@@ -0,0 +1,254 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <dynd/memblock/external_memory_block.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "array_ragged.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+/**
+ * Finds the shape and the strides of the fixed dimensions of `tp`, and
+ * returns the type of their elements, which is null if it isn't builtin.
+ */
+ndt::type value_layout(ndt::type tp, const char *arrmeta, vector<intptr_t> &shape, vector<intptr_t> &strides)
+{
+  while (tp.get_id() == fixed_dim_id) {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    shape.push_back(md->dim_size);
+    strides.push_back(md->stride);
+    arrmeta += sizeof(fixed_dim_type_arrmeta);
+    tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+  }
+
+  return tp.is_builtin() ? tp : ndt::type();
+}
+
+/**
+ * Copies the value at `src`, with the fixed dimensions `shape[i:]`, to
+ * `dst` in C order, and returns the end of the copy.
+ */
+char *copy_value(char *dst, const char *src, const vector<intptr_t> &shape, const vector<intptr_t> &strides, size_t i,
+                 size_t itemsize)
+{
+  if (i == shape.size()) {
+    memcpy(dst, src, itemsize);
+    return dst + itemsize;
+  }
+  for (intptr_t j = 0; j < shape[i]; ++j) {
+    dst = copy_value(dst, src + j * strides[i], shape, strides, i + 1, itemsize);
+  }
+  return dst;
+}
+
+/**
+ * Checks that `a` has type "N * var * T", for a builtin type T or fixed
+ * dimensions of one, and finds the layout of T.
+ */
+ndt::type ragged_layout(const nd::array &a, const char *action, ndt::type &el_tp, vector<intptr_t> &shape,
+                        vector<intptr_t> &strides)
+{
+  const ndt::type &tp = a.get_type();
+  ndt::type scalar_tp;
+  if (tp.get_id() == fixed_dim_id && tp.extended<ndt::base_dim_type>()->get_element_type().get_id() == var_dim_id) {
+    el_tp = tp.extended<ndt::base_dim_type>()->get_element_type().extended<ndt::base_dim_type>()->get_element_type();
+    scalar_tp = value_layout(el_tp, a.get()->metadata() + sizeof(fixed_dim_type_arrmeta) +
+                                        sizeof(ndt::var_dim_type::metadata_type),
+                             shape, strides);
+  }
+  if (scalar_tp.is_null()) {
+    stringstream ss;
+    ss << "cannot " << action << " an array of type " << tp << ", it must have type \"N * var * T\""
+       << " where T is a builtin type or fixed dimensions of one";
+    throw type_error(ss.str());
+  }
+
+  return scalar_tp;
+}
+
+void delete_elements(void *obj) { delete reinterpret_cast<vector<ndt::var_dim_type::data_type> *>(obj); }
+
+} // anonymous namespace
+
+void pydynd::array_to_ragged(const dynd::nd::array &a, dynd::nd::array &out_values, dynd::nd::array &out_offsets)
+{
+  ndt::type el_tp;
+  vector<intptr_t> shape(1), strides(1);
+  ndt::type scalar_tp = ragged_layout(a, "split into values and offsets", el_tp, shape, strides);
+
+  const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(a.get()->metadata());
+  const ndt::var_dim_type::metadata_type *var_md =
+      reinterpret_cast<const ndt::var_dim_type::metadata_type *>(a.get()->metadata() + sizeof(fixed_dim_type_arrmeta));
+  intptr_t length = md->dim_size;
+  out_offsets = nd::empty(length + 1, ndt::make_type<int64_t>());
+  int64_t *offsets = reinterpret_cast<int64_t *>(out_offsets.data());
+
+  // The values can be viewed if every element begins where the one before
+  // it ends
+  bool contiguous = true;
+  const char *begin = NULL, *end = NULL;
+  offsets[0] = 0;
+  for (intptr_t i = 0; i < length; ++i) {
+    const ndt::var_dim_type::data_type *vdd =
+        reinterpret_cast<const ndt::var_dim_type::data_type *>(a.cdata() + i * md->stride);
+    offsets[i + 1] = offsets[i] + vdd->size;
+    if (vdd->size != 0) {
+      const char *data = vdd->begin + var_md->offset;
+      if (begin == NULL) {
+        begin = data;
+      }
+      else if (data != end) {
+        contiguous = false;
+      }
+      end = data + vdd->size * var_md->stride;
+    }
+  }
+
+  shape[0] = offsets[length];
+  strides[0] = var_md->stride;
+  if (begin != NULL && contiguous) {
+    out_values = nd::make_strided_array_from_data(scalar_tp, shape.size(), shape.data(), strides.data(),
+                                                  a.get_flags(), const_cast<char *>(begin), var_md->blockref, NULL);
+    return;
+  }
+
+  // Compact the values into a new array in a single pass
+  out_values = nd::empty(shape[0], el_tp);
+  char *dst = out_values.data();
+  for (intptr_t i = 0; i < length; ++i) {
+    const ndt::var_dim_type::data_type *vdd =
+        reinterpret_cast<const ndt::var_dim_type::data_type *>(a.cdata() + i * md->stride);
+    for (size_t j = 0; j < vdd->size; ++j) {
+      dst = copy_value(dst, vdd->begin + var_md->offset + j * var_md->stride, shape, strides, 1,
+                       scalar_tp.get_data_size());
+    }
+  }
+}
+
+dynd::nd::array pydynd::array_from_ragged(const dynd::nd::array &values, const dynd::nd::array &offsets)
+{
+  const ndt::type &tp = values.get_type();
+  vector<intptr_t> shape, strides;
+  if (tp.get_id() != fixed_dim_id || value_layout(tp, values.get()->metadata(), shape, strides).is_null()) {
+    stringstream ss;
+    ss << "cannot make a ragged array from values of type " << tp << ", they must have type \"M * T\""
+       << " where T is a builtin type or fixed dimensions of one";
+    throw type_error(ss.str());
+  }
+  if (offsets.get_ndim() != 1 || offsets.get_dim_size() == 0) {
+    throw invalid_argument("the offsets of a ragged array must be one dimensional, with one more element than the "
+                           "ragged array");
+  }
+
+  intptr_t length = offsets.get_dim_size() - 1;
+  nd::array offsets_int64 = nd::empty(length + 1, ndt::make_type<int64_t>());
+  offsets_int64.assign(offsets);
+  const int64_t *o = reinterpret_cast<const int64_t *>(offsets_int64.cdata());
+  for (intptr_t i = 0; i < length; ++i) {
+    if (o[i] > o[i + 1]) {
+      throw invalid_argument("the offsets of a ragged array must be nondecreasing");
+    }
+  }
+  if (o[0] < 0 || o[length] > shape[0]) {
+    stringstream ss;
+    ss << "the offsets of a ragged array must be between 0 and the number of values, " << shape[0];
+    throw invalid_argument(ss.str());
+  }
+
+  const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+  ndt::type result_tp = ndt::make_fixed_dim(length, ndt::make_type<ndt::var_dim_type>(el_tp));
+  if (length == 0) {
+    return nd::empty(result_tp);
+  }
+
+  // Only the begin and size of each element are new, they point into the
+  // values which the var dimension references
+  vector<ndt::var_dim_type::data_type> *elements = new vector<ndt::var_dim_type::data_type>(length);
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(elements, &delete_elements);
+  char *data = const_cast<char *>(values.cdata());
+  for (intptr_t i = 0; i < length; ++i) {
+    (*elements)[i].begin = data + o[i] * strides[0];
+    (*elements)[i].size = o[i + 1] - o[i];
+  }
+
+  nd::array result =
+      nd::make_array(result_tp, reinterpret_cast<char *>(elements->data()), memblock, values.get_flags());
+  result_tp.extended()->arrmeta_default_construct(result.get()->metadata(), true);
+  ndt::var_dim_type::metadata_type *var_md =
+      reinterpret_cast<ndt::var_dim_type::metadata_type *>(result.get()->metadata() + sizeof(fixed_dim_type_arrmeta));
+  var_md->blockref = values.get_data_memblock();
+  var_md->stride = strides[0];
+  var_md->offset = 0;
+  // The arrmeta of the fixed dimensions of the values is plain data
+  memcpy(reinterpret_cast<char *>(var_md + 1), values.get()->metadata() + sizeof(fixed_dim_type_arrmeta),
+         el_tp.get_arrmeta_size());
+
+  return result;
+}
+
+dynd::nd::array pydynd::array_to_padded(const dynd::nd::array &a, const dynd::nd::array &fill, intptr_t maxlen,
+                                        bool align_right, bool truncate_start, dynd::nd::array *out_mask)
+{
+  ndt::type el_tp;
+  vector<intptr_t> shape(2), strides(2);
+  ndt::type scalar_tp = ragged_layout(a, "pad", el_tp, shape, strides);
+
+  const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(a.get()->metadata());
+  const ndt::var_dim_type::metadata_type *var_md =
+      reinterpret_cast<const ndt::var_dim_type::metadata_type *>(a.get()->metadata() + sizeof(fixed_dim_type_arrmeta));
+  intptr_t length = md->dim_size;
+  if (maxlen < 0) {
+    maxlen = 0;
+    for (intptr_t i = 0; i < length; ++i) {
+      maxlen = max(maxlen, static_cast<intptr_t>(
+                               reinterpret_cast<const ndt::var_dim_type::data_type *>(a.cdata() + i * md->stride)->size));
+    }
+  }
+
+  nd::array result = nd::empty(length, ndt::make_fixed_dim(maxlen, el_tp));
+  result.assign(fill);
+  const fixed_dim_type_arrmeta *result_md = reinterpret_cast<const fixed_dim_type_arrmeta *>(result.get()->metadata());
+  char *mask = NULL;
+  if (out_mask != NULL) {
+    *out_mask = nd::empty(length, ndt::make_fixed_dim(maxlen, ndt::make_type<bool1>()));
+    mask = out_mask->data();
+    memset(mask, 0, length * maxlen);
+  }
+
+  // The rows of the result are C contiguous, so the values of a row are
+  // copied one after the other
+  for (intptr_t i = 0; i < length; ++i) {
+    const ndt::var_dim_type::data_type *vdd =
+        reinterpret_cast<const ndt::var_dim_type::data_type *>(a.cdata() + i * md->stride);
+    intptr_t size = vdd->size, skip = 0;
+    if (size > maxlen) {
+      skip = truncate_start ? size - maxlen : 0;
+      size = maxlen;
+    }
+    intptr_t start = align_right ? maxlen - size : 0;
+    char *dst = result.data() + i * result_md[0].stride + start * result_md[1].stride;
+    const char *src = vdd->begin + var_md->offset + skip * var_md->stride;
+    for (intptr_t j = 0; j < size; ++j) {
+      dst = copy_value(dst, src + j * var_md->stride, shape, strides, 2, scalar_tp.get_data_size());
+    }
+    if (mask != NULL) {
+      memset(mask + i * maxlen + start, 1, size);
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,754 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dynd/memblock/external_memory_block.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "array_dims.hpp"
+#include "arrow_c_data.hpp"
+#include "record_fields.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+struct arrow_primitive {
+  char format;
+  type_id_t id;
+};
+
+const arrow_primitive arrow_primitives[] = {{'b', bool_id},   {'c', int8_id},    {'C', uint8_id},
+                                            {'s', int16_id},  {'S', uint16_id},  {'i', int32_id},
+                                            {'I', uint32_id}, {'l', int64_id},   {'L', uint64_id},
+                                            {'f', float32_id}, {'g', float64_id}};
+
+ndt::type scalar_type(type_id_t id)
+{
+  switch (id) {
+  case bool_id:
+    return ndt::make_type<bool1>();
+  case int8_id:
+    return ndt::make_type<int8_t>();
+  case int16_id:
+    return ndt::make_type<int16_t>();
+  case int32_id:
+    return ndt::make_type<int32_t>();
+  case int64_id:
+    return ndt::make_type<int64_t>();
+  case uint8_id:
+    return ndt::make_type<uint8_t>();
+  case uint16_id:
+    return ndt::make_type<uint16_t>();
+  case uint32_id:
+    return ndt::make_type<uint32_t>();
+  case uint64_id:
+    return ndt::make_type<uint64_t>();
+  case float32_id:
+    return ndt::make_type<float>();
+  case float64_id:
+    return ndt::make_type<double>();
+  default:
+    return ndt::make_type<ndt::string_type>();
+  }
+}
+
+/**
+ * Whether values of type `tp` have the same layout in dynd and Arrow, so
+ * that they can be viewed in place. Arrow packs booleans into bits.
+ */
+bool is_viewable(const ndt::type &tp)
+{
+  field_kind kind;
+  return field_kind_of(tp.get_id(), kind) && kind != bool_field && kind != string_field;
+}
+
+bool has_nulls(const ArrowArray *array)
+{
+  return array != NULL && array->null_count != 0 && array->n_buffers > 0 && array->buffers[0] != NULL;
+}
+
+bool is_valid(const ArrowArray *array, int64_t i)
+{
+  const uint8_t *bits = static_cast<const uint8_t *>(array->buffers[0]);
+  return bits == NULL || ((bits[i >> 3] >> (i & 7)) & 1) != 0;
+}
+
+bool get_bit(const void *bits, int64_t i) { return ((static_cast<const uint8_t *>(bits)[i >> 3] >> (i & 7)) & 1) != 0; }
+
+int64_t list_offset(const ArrowArray *array, bool large, int64_t i)
+{
+  if (large) {
+    return static_cast<const int64_t *>(array->buffers[1])[i];
+  }
+  return static_cast<const int32_t *>(array->buffers[1])[i];
+}
+
+void check_layout(const ArrowSchema *schema, const ArrowArray *array, int64_t n_buffers, int64_t n_children)
+{
+  if (schema->n_children != n_children || (array != NULL && (array->n_buffers != n_buffers ||
+                                                               array->n_children != n_children))) {
+    stringstream ss;
+    ss << "an Arrow array of format '" << schema->format << "' must have " << n_buffers << " buffers and "
+       << n_children << " children";
+    throw invalid_argument(ss.str());
+  }
+}
+
+/**
+ * Returns the dynd type of the values of an Arrow array, or of any array
+ * of `schema` if `array` is NULL. Only scalars may be options.
+ */
+ndt::type import_type(const ArrowSchema *schema, const ArrowArray *array)
+{
+  const char *format = schema->format;
+  if (schema->dictionary != NULL) {
+    throw type_error("cannot import a dictionary encoded Arrow array");
+  }
+
+  if (format[0] == '+') {
+    if (has_nulls(array)) {
+      stringstream ss;
+      ss << "cannot import an Arrow array of format '" << format << "' with nulls, only scalars can be unavailable";
+      throw invalid_argument(ss.str());
+    }
+    if (strcmp(format, "+l") == 0 || strcmp(format, "+L") == 0) {
+      check_layout(schema, array, 2, 1);
+      return ndt::make_type<ndt::var_dim_type>(
+          import_type(schema->children[0], array != NULL ? array->children[0] : NULL));
+    }
+    if (strncmp(format, "+w:", 3) == 0) {
+      check_layout(schema, array, 1, 1);
+      char *size_end;
+      long long size = strtoll(format + 3, &size_end, 10);
+      if (*size_end != '\0' || size < 0) {
+        throw invalid_argument("invalid Arrow format '" + std::string(format) + "'");
+      }
+      return ndt::make_fixed_dim(size, import_type(schema->children[0], array != NULL ? array->children[0] : NULL));
+    }
+    if (strcmp(format, "+s") == 0) {
+      check_layout(schema, array, 1, schema->n_children);
+      vector<std::string> names;
+      vector<ndt::type> types;
+      for (int64_t i = 0; i < schema->n_children; ++i) {
+        names.push_back(schema->children[i]->name != NULL ? schema->children[i]->name : "");
+        types.push_back(import_type(schema->children[i], array != NULL ? array->children[i] : NULL));
+      }
+      return ndt::make_type<ndt::struct_type>(names, types);
+    }
+  }
+  else if (format[0] != '\0' && format[1] == '\0') {
+    ndt::type tp;
+    bool found = false;
+    if (format[0] == 'u' || format[0] == 'U') {
+      check_layout(schema, array, 3, 0);
+      tp = ndt::make_type<ndt::string_type>();
+      found = true;
+    }
+    for (const arrow_primitive &p : arrow_primitives) {
+      if (p.format == format[0]) {
+        check_layout(schema, array, 2, 0);
+        tp = scalar_type(p.id);
+        found = true;
+      }
+    }
+    if (found) {
+      bool nullable = (array != NULL) ? has_nulls(array) : (schema->flags & ARROW_FLAG_NULLABLE) != 0;
+      return nullable ? ndt::make_type<ndt::option_type>(tp) : tp;
+    }
+  }
+
+  throw type_error("cannot import an Arrow array of format '" + std::string(format) + "'");
+}
+
+/**
+ * Copies the values [begin, begin + count) of an Arrow array into the
+ * values of type `tp` at `dst`, `stride` bytes apart, which are those of
+ * a new array. With `skip_nulls`, the null values aren't copied.
+ */
+void copy_values(const ndt::type &tp, const char *arrmeta, char *dst, intptr_t stride, const ArrowSchema *schema,
+                 const ArrowArray *array, int64_t begin, int64_t count, bool skip_nulls)
+{
+  // The index of the first value in the buffers
+  int64_t first = array->offset + begin;
+  switch (tp.get_id()) {
+  case option_id: {
+    const ndt::type &value_tp = tp.extended<ndt::option_type>()->get_value_type();
+    copy_values(value_tp, arrmeta, dst, stride, schema, array, begin, count, true);
+    field_plan f;
+    field_kind_of(value_tp.get_id(), f.kind);
+    for (int64_t i = 0; i < count; ++i) {
+      if (!is_valid(array, first + i)) {
+        store_na(f, dst + i * stride);
+      }
+    }
+    break;
+  }
+  case bool_id:
+    for (int64_t i = 0; i < count; ++i) {
+      dst[i * stride] = get_bit(array->buffers[1], first + i);
+    }
+    break;
+  case string_id: {
+    bool large = (schema->format[0] == 'U');
+    const char *data = static_cast<const char *>(array->buffers[2]);
+    for (int64_t i = 0; i < count; ++i) {
+      int64_t value_begin = list_offset(array, large, first + i), value_end = list_offset(array, large, first + i + 1);
+      if (value_end > value_begin && !(skip_nulls && !is_valid(array, first + i))) {
+        reinterpret_cast<dynd::string *>(dst + i * stride)->assign(data + value_begin, value_end - value_begin);
+      }
+    }
+    break;
+  }
+  case var_dim_id: {
+    const ndt::var_dim_type::metadata_type *md = reinterpret_cast<const ndt::var_dim_type::metadata_type *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    bool large = (schema->format[1] == 'L');
+    for (int64_t i = 0; i < count; ++i) {
+      ndt::var_dim_type::data_type *vdd = reinterpret_cast<ndt::var_dim_type::data_type *>(dst + i * stride);
+      int64_t el_begin = list_offset(array, large, first + i), el_end = list_offset(array, large, first + i + 1);
+      vdd->size = el_end - el_begin;
+      vdd->begin = (vdd->size != 0) ? md->blockref->alloc(vdd->size) : NULL;
+      copy_values(el_tp, arrmeta + sizeof(ndt::var_dim_type::metadata_type), vdd->begin, md->stride,
+                  schema->children[0], array->children[0], el_begin, el_end - el_begin, false);
+    }
+    break;
+  }
+  case fixed_dim_id: {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    for (int64_t i = 0; i < count; ++i) {
+      copy_values(el_tp, arrmeta + sizeof(fixed_dim_type_arrmeta), dst + i * stride, md->stride,
+                  schema->children[0], array->children[0], (first + i) * md->dim_size, md->dim_size, false);
+    }
+    break;
+  }
+  case struct_id: {
+    // The children of a struct are indexed like it, including its offset
+    const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+    const uintptr_t *data_offsets = tt->get_data_offsets(arrmeta);
+    const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+    for (intptr_t j = 0; j < tt->get_field_count(); ++j) {
+      copy_values(tt->get_field_type(j), arrmeta + arrmeta_offsets[j], dst + data_offsets[j], stride,
+                  schema->children[j], array->children[j], first, count, false);
+    }
+    break;
+  }
+  default: {
+    intptr_t size = tp.get_data_size();
+    const char *src = static_cast<const char *>(array->buffers[1]) + first * size;
+    if (stride == size && !skip_nulls) {
+      memcpy(dst, src, count * size);
+    }
+    else {
+      for (int64_t i = 0; i < count; ++i) {
+        memcpy(dst + i * stride, src + i * size, size);
+      }
+    }
+    break;
+  }
+  }
+}
+
+/**
+ * An imported Arrow array, and the var dimension data of a view of it.
+ */
+struct arrow_import {
+  ArrowArray array;
+  vector<ndt::var_dim_type::data_type> lists;
+};
+
+void release_import(void *obj)
+{
+  arrow_import *imp = reinterpret_cast<arrow_import *>(obj);
+  if (imp->array.release != NULL) {
+    imp->array.release(&imp->array);
+  }
+  delete imp;
+}
+
+/**
+ * The private data of an exported array, which owns its buffers and its
+ * children.
+ */
+struct exported_array {
+  // The array whose data the buffers point into, if any
+  nd::array keep;
+  vector<vector<char>> storage;
+  vector<const void *> buffers;
+  vector<ArrowArray> children;
+  vector<ArrowArray *> child_pointers;
+
+  ~exported_array()
+  {
+    for (ArrowArray &child : children) {
+      if (child.release != NULL) {
+        child.release(&child);
+      }
+    }
+  }
+
+  char *new_buffer(size_t size)
+  {
+    // Arrow buffers may not be NULL, even when empty
+    storage.push_back(vector<char>(max<size_t>(size, 8)));
+    buffers.push_back(storage.back().data());
+    return storage.back().data();
+  }
+};
+
+void release_exported_array(ArrowArray *array)
+{
+  delete static_cast<exported_array *>(array->private_data);
+  array->release = NULL;
+}
+
+/**
+ * Fills in `array` from the buffers and the children of `ex`, which it
+ * takes over.
+ */
+void finish_array(unique_ptr<exported_array> &ex, int64_t length, int64_t null_count, ArrowArray *array)
+{
+  for (ArrowArray &child : ex->children) {
+    ex->child_pointers.push_back(&child);
+  }
+  array->length = length;
+  array->null_count = null_count;
+  array->offset = 0;
+  array->n_buffers = ex->buffers.size();
+  array->n_children = ex->children.size();
+  array->buffers = ex->buffers.data();
+  array->children = ex->child_pointers.empty() ? NULL : ex->child_pointers.data();
+  array->dictionary = NULL;
+  array->release = &release_exported_array;
+  array->private_data = ex.release();
+}
+
+/**
+ * Finds the size and the elements of the outermost dimension, like
+ * dim_elements, raising an error if there is none.
+ */
+void dim(const ndt::type &tp, const char *arrmeta, const char *&data, intptr_t &size, intptr_t &stride,
+         const char *&el_arrmeta)
+{
+  if (!dim_elements(tp, arrmeta, data, size, stride, el_arrmeta)) {
+    stringstream ss;
+    ss << "cannot export an array of type " << tp << " to Arrow, it has no fixed or var outermost dimension";
+    throw type_error(ss.str());
+  }
+}
+
+/**
+ * Exports the values of type `tp` at `elements` as the Arrow array
+ * `array`, copying them.
+ */
+void export_values(const ndt::type &tp, const char *arrmeta, const vector<const char *> &elements, ArrowArray *array)
+{
+  unique_ptr<exported_array> ex(new exported_array);
+  int64_t length = elements.size(), null_count = 0;
+  ndt::type value_tp = tp;
+  if (tp.get_id() == option_id) {
+    value_tp = tp.extended<ndt::option_type>()->get_value_type();
+    field_kind kind;
+    if (!field_kind_of(value_tp.get_id(), kind)) {
+      stringstream ss;
+      ss << "cannot export an option of type " << value_tp << " to Arrow";
+      throw type_error(ss.str());
+    }
+    uint8_t *bits = reinterpret_cast<uint8_t *>(ex->new_buffer((length + 7) / 8));
+    for (int64_t i = 0; i < length; ++i) {
+      if (is_na(kind, elements[i])) {
+        ++null_count;
+      }
+      else {
+        bits[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+      }
+    }
+  }
+  else {
+    ex->buffers.push_back(NULL);
+  }
+
+  switch (value_tp.get_id()) {
+  case bool_id: {
+    uint8_t *bits = reinterpret_cast<uint8_t *>(ex->new_buffer((length + 7) / 8));
+    for (int64_t i = 0; i < length; ++i) {
+      if (*elements[i] != 0) {
+        bits[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+      }
+    }
+    break;
+  }
+  case string_id: {
+    int64_t *offsets = reinterpret_cast<int64_t *>(ex->new_buffer((length + 1) * sizeof(int64_t)));
+    offsets[0] = 0;
+    for (int64_t i = 0; i < length; ++i) {
+      const dynd::string *s = reinterpret_cast<const dynd::string *>(elements[i]);
+      offsets[i + 1] = offsets[i] + (s->end() - s->begin());
+    }
+    char *data = ex->new_buffer(offsets[length]);
+    for (int64_t i = 0; i < length; ++i) {
+      const dynd::string *s = reinterpret_cast<const dynd::string *>(elements[i]);
+      if (s->begin() != NULL) {
+        memcpy(data + offsets[i], s->begin(), s->end() - s->begin());
+      }
+    }
+    break;
+  }
+  case fixed_dim_id:
+  case var_dim_id: {
+    const ndt::type &el_tp = value_tp.extended<ndt::base_dim_type>()->get_element_type();
+    int64_t *offsets = NULL;
+    if (value_tp.get_id() == var_dim_id) {
+      offsets = reinterpret_cast<int64_t *>(ex->new_buffer((length + 1) * sizeof(int64_t)));
+      offsets[0] = 0;
+    }
+    vector<const char *> children;
+    const char *el_arrmeta = NULL;
+    for (int64_t i = 0; i < length; ++i) {
+      const char *data = elements[i];
+      intptr_t size, stride;
+      dim(value_tp, arrmeta, data, size, stride, el_arrmeta);
+      for (intptr_t j = 0; j < size; ++j) {
+        children.push_back(data + j * stride);
+      }
+      if (offsets != NULL) {
+        offsets[i + 1] = children.size();
+      }
+    }
+    if (el_arrmeta == NULL) {
+      el_arrmeta = arrmeta + (value_tp.get_id() == var_dim_id ? sizeof(ndt::var_dim_type::metadata_type)
+                                                              : sizeof(fixed_dim_type_arrmeta));
+    }
+    ex->children.resize(1, ArrowArray());
+    export_values(el_tp, el_arrmeta, children, &ex->children[0]);
+    break;
+  }
+  case struct_id: {
+    const ndt::tuple_type *tt = value_tp.extended<ndt::tuple_type>();
+    const uintptr_t *data_offsets = tt->get_data_offsets(arrmeta);
+    const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+    ex->children.resize(tt->get_field_count(), ArrowArray());
+    vector<const char *> fields(length);
+    for (intptr_t j = 0; j < tt->get_field_count(); ++j) {
+      for (int64_t i = 0; i < length; ++i) {
+        fields[i] = elements[i] + data_offsets[j];
+      }
+      export_values(tt->get_field_type(j), arrmeta + arrmeta_offsets[j], fields, &ex->children[j]);
+    }
+    break;
+  }
+  default: {
+    if (!is_viewable(value_tp)) {
+      stringstream ss;
+      ss << "cannot export values of type " << value_tp << " to Arrow";
+      throw type_error(ss.str());
+    }
+    size_t size = value_tp.get_data_size();
+    char *data = ex->new_buffer(length * size);
+    for (int64_t i = 0; i < length; ++i) {
+      memcpy(data + i * size, elements[i], size);
+    }
+    break;
+  }
+  }
+
+  finish_array(ex, length, null_count, array);
+}
+
+/**
+ * The private data of an exported schema, which owns its strings and its
+ * children.
+ */
+struct exported_schema {
+  std::string format;
+  std::string name;
+  vector<ArrowSchema> children;
+  vector<ArrowSchema *> child_pointers;
+
+  ~exported_schema()
+  {
+    for (ArrowSchema &child : children) {
+      if (child.release != NULL) {
+        child.release(&child);
+      }
+    }
+  }
+};
+
+void release_exported_schema(ArrowSchema *schema)
+{
+  delete static_cast<exported_schema *>(schema->private_data);
+  schema->release = NULL;
+}
+
+void export_type(const ndt::type &tp, const std::string &name, ArrowSchema *schema)
+{
+  unique_ptr<exported_schema> ex(new exported_schema);
+  ex->name = name;
+  int64_t flags = 0;
+  ndt::type value_tp = tp;
+  if (tp.get_id() == option_id) {
+    value_tp = tp.extended<ndt::option_type>()->get_value_type();
+    flags = ARROW_FLAG_NULLABLE;
+  }
+
+  switch (value_tp.get_id()) {
+  case string_id:
+    ex->format = "U";
+    break;
+  case fixed_dim_id:
+  case var_dim_id: {
+    if (value_tp.get_id() == var_dim_id) {
+      ex->format = "+L";
+    }
+    else {
+      stringstream ss;
+      ss << "+w:" << value_tp.extended<ndt::fixed_dim_type>()->get_fixed_dim_size();
+      ex->format = ss.str();
+    }
+    ex->children.resize(1, ArrowSchema());
+    export_type(value_tp.extended<ndt::base_dim_type>()->get_element_type(), "item", &ex->children[0]);
+    break;
+  }
+  case struct_id: {
+    const ndt::struct_type *st = value_tp.extended<ndt::struct_type>();
+    ex->format = "+s";
+    ex->children.resize(st->get_field_count(), ArrowSchema());
+    for (intptr_t j = 0; j < st->get_field_count(); ++j) {
+      const dynd::string &field_name = st->get_field_name(j);
+      export_type(st->get_field_type(j), std::string(field_name.begin(), field_name.end()), &ex->children[j]);
+    }
+    break;
+  }
+  default:
+    for (const arrow_primitive &p : arrow_primitives) {
+      if (p.id == value_tp.get_id()) {
+        ex->format = std::string(1, p.format);
+      }
+    }
+    break;
+  }
+  if (ex->format.empty() || (flags != 0 && ex->format[0] == '+')) {
+    stringstream ss;
+    ss << "cannot export the type " << tp << " to Arrow";
+    throw type_error(ss.str());
+  }
+
+  for (ArrowSchema &child : ex->children) {
+    ex->child_pointers.push_back(&child);
+  }
+  schema->format = ex->format.c_str();
+  schema->name = ex->name.c_str();
+  schema->metadata = NULL;
+  schema->flags = flags;
+  schema->n_children = ex->children.size();
+  schema->children = ex->child_pointers.empty() ? NULL : ex->child_pointers.data();
+  schema->dictionary = NULL;
+  schema->release = &release_exported_schema;
+  schema->private_data = ex.release();
+}
+
+const ndt::type &element_type(const nd::array &a)
+{
+  const ndt::type &tp = a.get_type();
+  if (tp.get_id() != fixed_dim_id && tp.get_id() != var_dim_id) {
+    stringstream ss;
+    ss << "cannot export an array of type " << tp << " to Arrow, it has no fixed or var outermost dimension";
+    throw type_error(ss.str());
+  }
+
+  return tp.extended<ndt::base_dim_type>()->get_element_type();
+}
+
+template <typename T>
+T *capsule_pointer(PyObject *capsule, const char *name)
+{
+  void *ptr = PyCapsule_GetPointer(capsule, name);
+  if (ptr == NULL) {
+    throw runtime_error("propagating a Python exception...");
+  }
+
+  return reinterpret_cast<T *>(ptr);
+}
+
+void release_schema_capsule(PyObject *capsule)
+{
+  ArrowSchema *schema = reinterpret_cast<ArrowSchema *>(PyCapsule_GetPointer(capsule, "arrow_schema"));
+  if (schema->release != NULL) {
+    schema->release(schema);
+  }
+  delete schema;
+}
+
+void release_array_capsule(PyObject *capsule)
+{
+  ArrowArray *array = reinterpret_cast<ArrowArray *>(PyCapsule_GetPointer(capsule, "arrow_array"));
+  if (array->release != NULL) {
+    array->release(array);
+  }
+  delete array;
+}
+
+PyObject *schema_capsule(const ndt::type &tp)
+{
+  unique_ptr<ArrowSchema> schema(new ArrowSchema());
+  type_to_arrow(tp, schema.get());
+  PyObject *capsule = PyCapsule_New(schema.get(), "arrow_schema", &release_schema_capsule);
+  if (capsule == NULL) {
+    schema->release(schema.get());
+    throw runtime_error("propagating a Python exception...");
+  }
+  schema.release();
+
+  return capsule;
+}
+
+PyObject *array_capsule(const nd::array &a)
+{
+  unique_ptr<ArrowArray> array(new ArrowArray());
+  array_to_arrow(a, array.get());
+  PyObject *capsule = PyCapsule_New(array.get(), "arrow_array", &release_array_capsule);
+  if (capsule == NULL) {
+    array->release(array.get());
+    throw runtime_error("propagating a Python exception...");
+  }
+  array.release();
+
+  return capsule;
+}
+
+} // anonymous namespace
+
+dynd::ndt::type pydynd::type_from_arrow(const ArrowSchema *schema) { return import_type(schema, NULL); }
+
+void pydynd::type_to_arrow(const dynd::ndt::type &tp, ArrowSchema *schema) { export_type(tp, "", schema); }
+
+dynd::nd::array pydynd::array_from_arrow(const ArrowSchema *schema, ArrowArray *array)
+{
+  if (array->release == NULL) {
+    throw invalid_argument("the Arrow array was already released or imported");
+  }
+
+  // Take over the array, so that it's released with the last view of it
+  arrow_import *imp = new arrow_import;
+  imp->array = *array;
+  array->release = NULL;
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(imp, &release_import);
+
+  const ArrowArray *src = &imp->array;
+  ndt::type el_tp = import_type(schema, src);
+  intptr_t length = src->length;
+  if (length > 0 && is_viewable(el_tp)) {
+    intptr_t stride = el_tp.get_data_size();
+    char *data = const_cast<char *>(static_cast<const char *>(src->buffers[1])) + src->offset * stride;
+    return nd::make_strided_array_from_data(el_tp, 1, &length, &stride, nd::read_access_flag, data, memblock, NULL);
+  }
+
+  if (length > 0 && el_tp.get_id() == fixed_dim_id &&
+      is_viewable(el_tp.extended<ndt::base_dim_type>()->get_element_type())) {
+    const ndt::type &scalar_tp = el_tp.extended<ndt::base_dim_type>()->get_element_type();
+    const ArrowArray *values = src->children[0];
+    intptr_t size = el_tp.extended<ndt::fixed_dim_type>()->get_fixed_dim_size();
+    intptr_t shape[2] = {length, size};
+    intptr_t strides[2] = {size * static_cast<intptr_t>(scalar_tp.get_data_size()),
+                           static_cast<intptr_t>(scalar_tp.get_data_size())};
+    char *data = const_cast<char *>(static_cast<const char *>(values->buffers[1])) +
+                 (values->offset + src->offset * size) * strides[1];
+    return nd::make_strided_array_from_data(scalar_tp, 2, shape, strides, nd::read_access_flag, data, memblock,
+                                            NULL);
+  }
+
+  ndt::type tp = ndt::make_fixed_dim(length, el_tp);
+  if (length > 0 && el_tp.get_id() == var_dim_id &&
+      is_viewable(el_tp.extended<ndt::base_dim_type>()->get_element_type())) {
+    // Point the var dimension into the values of the list, whose offsets
+    // become the (begin, size) pairs of its elements
+    const ArrowArray *values = src->children[0];
+    size_t value_size = el_tp.extended<ndt::base_dim_type>()->get_element_type().get_data_size();
+    char *value_data = const_cast<char *>(static_cast<const char *>(values->buffers[1]));
+    bool large = (schema->format[1] == 'L');
+    imp->lists.resize(length);
+    for (intptr_t i = 0; i < length; ++i) {
+      int64_t begin = list_offset(src, large, src->offset + i), end = list_offset(src, large, src->offset + i + 1);
+      imp->lists[i].begin = value_data + (values->offset + begin) * value_size;
+      imp->lists[i].size = end - begin;
+    }
+    nd::array result = nd::make_array(tp, reinterpret_cast<char *>(imp->lists.data()), memblock, nd::read_access_flag);
+    tp.extended()->arrmeta_default_construct(result.get()->metadata(), true);
+    reinterpret_cast<ndt::var_dim_type::metadata_type *>(result.get()->metadata() + sizeof(fixed_dim_type_arrmeta))
+        ->blockref = memblock;
+    return result;
+  }
+
+  nd::array result = nd::empty(tp);
+  copy_values(el_tp, result.get()->metadata() + sizeof(fixed_dim_type_arrmeta), result.data(),
+              reinterpret_cast<const fixed_dim_type_arrmeta *>(result.get()->metadata())->stride, schema, src, 0,
+              length, false);
+  return result;
+}
+
+void pydynd::array_to_arrow(const dynd::nd::array &a, ArrowArray *array)
+{
+  const ndt::type &el_tp = element_type(a);
+  const char *data = a.cdata();
+  intptr_t size, stride;
+  const char *el_arrmeta;
+  dim(a.get_type(), a.get()->metadata(), data, size, stride, el_arrmeta);
+
+  if (is_viewable(el_tp) && stride == static_cast<intptr_t>(el_tp.get_data_size())) {
+    // Export the contiguous numbers in place
+    unique_ptr<exported_array> ex(new exported_array);
+    ex->keep = a;
+    ex->buffers.push_back(NULL);
+    ex->buffers.push_back(data);
+    finish_array(ex, size, 0, array);
+    return;
+  }
+
+  vector<const char *> elements(size);
+  for (intptr_t i = 0; i < size; ++i) {
+    elements[i] = data + i * stride;
+  }
+  export_values(el_tp, el_arrmeta, elements, array);
+}
+
+PyObject *pydynd::array_arrow_schema_capsule(const dynd::nd::array &a) { return schema_capsule(element_type(a)); }
+
+PyObject *pydynd::array_arrow_capsules(const dynd::nd::array &a, PyObject *requested_schema)
+{
+  nd::array src = a;
+  if (requested_schema != Py_None) {
+    ndt::type tp = type_from_arrow(capsule_pointer<ArrowSchema>(requested_schema, "arrow_schema"));
+    if (tp != element_type(a)) {
+      src = nd::empty(ndt::make_fixed_dim(a.get_dim_size(), tp));
+      src.assign(a);
+    }
+  }
+
+  pyobject_ownref schema(schema_capsule(element_type(src)));
+  pyobject_ownref array(array_capsule(src));
+  return PyTuple_Pack(2, schema.get(), array.get());
+}
+
+dynd::nd::array pydynd::array_from_arrow_capsules(PyObject *schema_capsule, PyObject *array_capsule)
+{
+  return array_from_arrow(capsule_pointer<ArrowSchema>(schema_capsule, "arrow_schema"),
+                          capsule_pointer<ArrowArray>(array_capsule, "arrow_array"));
+}
@@ -0,0 +1,660 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dynd/irange.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "arrow_c_data.hpp"
+#include "arrow_ipc.hpp"
+#include "memmap.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+const char arrow_magic[] = "ARROW1";
+const size_t arrow_magic_size = 6;
+
+void raise_invalid(const char *what) { throw invalid_argument(std::string("invalid Arrow IPC file, ") + what); }
+
+template <typename T>
+T load(const char *p)
+{
+  T value;
+  memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+/**
+ * A table of a flatbuffer in [begin, end), whose accesses are all checked
+ * against the bounds of the buffer.
+ */
+class fb_table {
+  const char *m_begin, *m_end;
+  const char *m_table, *m_vtable;
+  uint16_t m_vtable_size;
+
+  void check(const char *p, size_t size) const
+  {
+    if (p < m_begin || p > m_end || size > static_cast<size_t>(m_end - p)) {
+      raise_invalid("a flatbuffer offset is out of bounds");
+    }
+  }
+
+  // The target of the offset stored in field `i`
+  const char *deref(int i) const
+  {
+    const char *p = field(i);
+    if (p == NULL) {
+      raise_invalid("a required flatbuffer field is missing");
+    }
+    check(p, 4);
+    p += load<uint32_t>(p);
+    check(p, 4);
+    return p;
+  }
+
+public:
+  fb_table(const char *begin, const char *end, const char *table) : m_begin(begin), m_end(end), m_table(table)
+  {
+    check(table, 4);
+    m_vtable = table - load<int32_t>(table);
+    check(m_vtable, 4);
+    m_vtable_size = load<uint16_t>(m_vtable);
+    check(m_vtable, m_vtable_size);
+  }
+
+  // The root table of the flatbuffer
+  static fb_table root(const char *begin, const char *end)
+  {
+    if (end - begin < 4) {
+      raise_invalid("a flatbuffer is truncated");
+    }
+    return fb_table(begin, end, begin + load<uint32_t>(begin));
+  }
+
+  // Where field `i` is stored, or NULL if it has the default value
+  const char *field(int i) const
+  {
+    size_t entry = 4 + 2 * i;
+    uint16_t offset = (entry + 2 <= m_vtable_size) ? load<uint16_t>(m_vtable + entry) : 0;
+    if (offset == 0) {
+      return NULL;
+    }
+    check(m_table + offset, 1);
+    return m_table + offset;
+  }
+
+  bool has(int i) const { return field(i) != NULL; }
+
+  template <typename T>
+  T scalar(int i, T def) const
+  {
+    const char *p = field(i);
+    if (p == NULL) {
+      return def;
+    }
+    check(p, sizeof(T));
+    return load<T>(p);
+  }
+
+  fb_table table(int i) const { return fb_table(m_begin, m_end, deref(i)); }
+
+  std::string string(int i) const
+  {
+    if (!has(i)) {
+      return std::string();
+    }
+    const char *p = deref(i);
+    uint32_t size = load<uint32_t>(p);
+    check(p + 4, size);
+    return std::string(p + 4, size);
+  }
+
+  // The number of elements of the vector in field `i`, and where they start
+  uint32_t vector(int i, size_t element_size, const char *&elements) const
+  {
+    if (!has(i)) {
+      elements = NULL;
+      return 0;
+    }
+    const char *p = deref(i);
+    uint32_t count = load<uint32_t>(p);
+    elements = p + 4;
+    if (count > (m_end - elements) / element_size) {
+      raise_invalid("a flatbuffer vector is out of bounds");
+    }
+    return count;
+  }
+
+  // Element `k` of a vector of tables
+  fb_table table_at(const char *elements, uint32_t k) const
+  {
+    const char *p = elements + 4 * k;
+    return fb_table(m_begin, m_end, p + load<uint32_t>(p));
+  }
+};
+
+// The values of the Type union of Schema.fbs
+const char *const arrow_type_names[] = {
+    "NONE", "Null", "Int", "FloatingPoint", "Binary", "Utf8", "Bool", "Decimal", "Date", "Time", "Timestamp",
+    "Interval", "List", "Struct_", "Union", "FixedSizeBinary", "FixedSizeList", "Map", "Duration", "LargeBinary",
+    "LargeUtf8", "LargeList", "RunEndEncoded", "BinaryView", "Utf8View", "ListView", "LargeListView"};
+
+enum {
+  arrow_int = 2,
+  arrow_floating_point = 3,
+  arrow_utf8 = 5,
+  arrow_bool = 6,
+  arrow_list = 12,
+  arrow_struct = 13,
+  arrow_union = 14,
+  arrow_fixed_size_list = 16,
+  arrow_large_utf8 = 20,
+  arrow_large_list = 21,
+  arrow_run_end_encoded = 22,
+  arrow_binary_view = 23,
+  arrow_utf8_view = 24,
+  arrow_list_view = 25,
+  arrow_large_list_view = 26
+};
+
+enum { record_batch_header = 3 };
+
+void release_field_schema(ArrowSchema *schema) { schema->release = NULL; }
+
+} // anonymous namespace
+
+namespace pydynd {
+
+/**
+ * A field of the schema, with the Arrow C Data Interface schema of the
+ * supported ones, and where its field node and buffers are in the record
+ * batches, which list them for all the fields in depth first order.
+ */
+struct arrow_ipc_field {
+  std::string name;
+  // The C Data Interface format, or empty if the type isn't supported
+  std::string format;
+  const char *type_name;
+  ArrowSchema schema;
+  vector<unique_ptr<arrow_ipc_field>> children;
+  vector<ArrowSchema *> child_schemas;
+  intptr_t node;
+  intptr_t buffer;
+  intptr_t buffer_count;
+};
+
+struct arrow_ipc_batch {
+  int64_t length;
+  const char *nodes;
+  intptr_t node_count;
+  const char *buffers;
+  intptr_t buffer_count;
+  const char *body;
+  int64_t body_length;
+};
+
+struct arrow_ipc_layout {
+  vector<unique_ptr<arrow_ipc_field>> columns;
+  vector<arrow_ipc_batch> batches;
+  intptr_t node_count;
+  intptr_t buffer_count;
+};
+
+} // namespace pydynd
+
+namespace {
+
+unique_ptr<arrow_ipc_field> parse_field(const fb_table &field, intptr_t &node, intptr_t &buffer)
+{
+  unique_ptr<arrow_ipc_field> f(new arrow_ipc_field);
+  f->name = field.string(0);
+  uint8_t type_id = field.scalar<uint8_t>(2, 0);
+  f->type_name = (type_id < sizeof(arrow_type_names) / sizeof(arrow_type_names[0])) ? arrow_type_names[type_id]
+                                                                                     : "unknown";
+  f->node = node++;
+  f->buffer = buffer;
+
+  // The buffers of each layout, from the columnar format specification
+  switch (type_id) {
+  case arrow_int: {
+    fb_table type = field.table(3);
+    int32_t bit_width = type.scalar<int32_t>(0, 0);
+    bool is_signed = type.scalar<uint8_t>(1, 0) != 0;
+    const char *formats = is_signed ? "csil" : "CSIL";
+    int bits = 8;
+    for (const char *c = formats; *c != '\0'; ++c, bits *= 2) {
+      if (bit_width == bits) {
+        f->format = std::string(1, *c);
+      }
+    }
+    f->buffer_count = 2;
+    break;
+  }
+  case arrow_floating_point: {
+    // HALF, SINGLE and DOUBLE precision
+    int16_t precision = field.table(3).scalar<int16_t>(0, 0);
+    if (precision == 1 || precision == 2) {
+      f->format = (precision == 1) ? "f" : "g";
+    }
+    f->buffer_count = 2;
+    break;
+  }
+  case arrow_bool:
+    f->format = "b";
+    f->buffer_count = 2;
+    break;
+  case arrow_utf8:
+  case arrow_large_utf8:
+    f->format = (type_id == arrow_utf8) ? "u" : "U";
+    f->buffer_count = 3;
+    break;
+  case arrow_list:
+  case arrow_large_list:
+    f->format = (type_id == arrow_list) ? "+l" : "+L";
+    f->buffer_count = 2;
+    break;
+  case arrow_fixed_size_list: {
+    stringstream ss;
+    ss << "+w:" << field.table(3).scalar<int32_t>(0, 0);
+    f->format = ss.str();
+    f->buffer_count = 1;
+    break;
+  }
+  case arrow_struct:
+    f->format = "+s";
+    f->buffer_count = 1;
+    break;
+  case arrow_union:
+    // Sparse unions have type ids, dense ones offsets as well
+    f->buffer_count = (field.table(3).scalar<int16_t>(0, 0) == 0) ? 1 : 2;
+    break;
+  case arrow_run_end_encoded:
+    f->buffer_count = 0;
+    break;
+  case arrow_binary_view:
+  case arrow_utf8_view: {
+    // Their variadic buffers would have to be counted per record batch
+    stringstream ss;
+    ss << "cannot read Arrow IPC files with the " << f->type_name << " column '" << f->name << "'";
+    throw type_error(ss.str());
+  }
+  case arrow_list_view:
+  case arrow_large_list_view:
+    f->buffer_count = 3;
+    break;
+  default:
+    // Null has no buffers, (Large)Binary has offsets, and the others have fixed size values
+    f->buffer_count = (type_id == 1) ? 0 : (type_id == 4 || type_id == 19) ? 3 : 2;
+    break;
+  }
+  const char *children;
+  uint32_t child_count = field.vector(5, 4, children);
+  if (field.has(4)) {
+    // Dictionary encoded, the record batches only hold the indices
+    f->format.clear();
+    f->type_name = "dictionary encoded";
+    f->buffer_count = 2;
+    child_count = 0;
+  }
+  buffer += f->buffer_count;
+
+  for (uint32_t k = 0; k < child_count; ++k) {
+    f->children.push_back(parse_field(field.table_at(children, k), node, buffer));
+    f->child_schemas.push_back(&f->children.back()->schema);
+  }
+
+  f->schema.format = f->format.c_str();
+  f->schema.name = f->name.c_str();
+  f->schema.metadata = NULL;
+  f->schema.flags = (field.scalar<uint8_t>(1, 0) != 0) ? ARROW_FLAG_NULLABLE : 0;
+  f->schema.n_children = f->children.size();
+  f->schema.children = f->child_schemas.empty() ? NULL : f->child_schemas.data();
+  f->schema.dictionary = NULL;
+  f->schema.release = &release_field_schema;
+  f->schema.private_data = NULL;
+  return f;
+}
+
+void check_supported(const arrow_ipc_field &f, const std::string &column)
+{
+  if (f.format.empty()) {
+    stringstream ss;
+    ss << "cannot read the Arrow IPC column '" << column << "', it holds values of the unsupported type "
+       << f.type_name;
+    throw type_error(ss.str());
+  }
+  for (const unique_ptr<arrow_ipc_field> &child : f.children) {
+    check_supported(*child, column);
+  }
+}
+
+/**
+ * Parses the metadata of the record batch in `block`, the Block struct of
+ * the footer, with the bounds of the file in [begin, end).
+ */
+arrow_ipc_batch parse_batch(const char *begin, const char *end, const char *block)
+{
+  int64_t offset = load<int64_t>(block), metadata_length = load<int32_t>(block + 8);
+  int64_t body_length = load<int64_t>(block + 16);
+  if (offset < 0 || metadata_length < 8 || body_length < 0 || offset > end - begin ||
+      metadata_length > end - begin - offset || body_length > end - begin - offset - metadata_length) {
+    raise_invalid("a record batch is out of bounds");
+  }
+
+  // The message may start with a continuation marker, and always with its size
+  const char *message = begin + offset;
+  if (load<uint32_t>(message) == 0xFFFFFFFFu) {
+    message += 4;
+  }
+  message += 4;
+  fb_table msg = fb_table::root(message, begin + offset + metadata_length);
+  if (msg.scalar<uint8_t>(1, 0) != record_batch_header) {
+    raise_invalid("a record batch block doesn't hold a record batch");
+  }
+
+  fb_table rb = msg.table(2);
+  if (rb.has(3)) {
+    throw invalid_argument("cannot read a compressed Arrow IPC file");
+  }
+  arrow_ipc_batch b;
+  b.length = rb.scalar<int64_t>(0, 0);
+  b.node_count = rb.vector(1, 16, b.nodes);
+  b.buffer_count = rb.vector(2, 16, b.buffers);
+  b.body = begin + offset + metadata_length;
+  b.body_length = body_length;
+  return b;
+}
+
+/**
+ * The private data of the arrays of a column in a record batch, which
+ * point into the mapped file.
+ */
+struct ipc_arrays {
+  nd::array keep;
+  deque<ArrowArray> children;
+  deque<vector<const void *>> buffers;
+  deque<vector<ArrowArray *>> child_pointers;
+};
+
+void release_child_array(ArrowArray *array) { array->release = NULL; }
+
+void release_ipc_arrays(ArrowArray *array)
+{
+  delete static_cast<ipc_arrays *>(array->private_data);
+  array->release = NULL;
+}
+
+void check_buffer_size(int64_t size, int64_t count, int64_t itemsize)
+{
+  if (size / itemsize < count) {
+    raise_invalid("a buffer is too short for the length of its field");
+  }
+}
+
+/**
+ * Checks that the `length + 1` offsets at `offsets` start at zero or more,
+ * never decrease, and end at most at `limit`.
+ */
+template <typename T>
+void check_offsets(const char *offsets, int64_t length, int64_t limit)
+{
+  T prev = load<T>(offsets);
+  if (prev < 0) {
+    raise_invalid("an offset is negative");
+  }
+  for (int64_t i = 1; i <= length; ++i) {
+    T next = load<T>(offsets + i * sizeof(T));
+    if (next < prev) {
+      raise_invalid("the offsets of a field decrease");
+    }
+    prev = next;
+  }
+  if (static_cast<int64_t>(prev) > limit) {
+    raise_invalid("an offset is out of the values it indexes");
+  }
+}
+
+/**
+ * Checks that the buffers of field `f`, of the sizes `sizes`, and its
+ * children hold the values its field node says it has, so importing it
+ * only reads within the record batch.
+ */
+void check_layout(const arrow_ipc_field &f, const ArrowArray *array, const vector<int64_t> &sizes)
+{
+  int64_t length = array->length;
+  if (length < 0 || array->null_count < 0 || array->null_count > length) {
+    raise_invalid("a field node has an invalid length or null count");
+  }
+  if (f.buffer_count > 0 && array->buffers[0] != NULL) {
+    check_buffer_size(sizes[0], (length + 7) / 8, 1);
+  }
+  const std::string &format = f.format;
+  if (format[0] == '+' && format != "+s" && array->n_children != 1) {
+    raise_invalid("a list field doesn't have one child");
+  }
+
+  // The formats of the integers and floating point numbers, and the sizes of their values
+  const char *value_formats = "cCsSiIlLfg";
+  const int64_t value_sizes[] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8};
+  if (format == "b") {
+    check_buffer_size(sizes[1], (length + 7) / 8, 1);
+  }
+  else if (format.size() == 1 && strchr(value_formats, format[0]) != NULL) {
+    check_buffer_size(sizes[1], length, value_sizes[strchr(value_formats, format[0]) - value_formats]);
+  }
+  else if (format == "u" || format == "U" || format == "+l" || format == "+L") {
+    bool large = (format == "U" || format == "+L");
+    int64_t offset_size = large ? 8 : 4;
+    if (length == 0 && sizes[1] == 0) {
+      return;
+    }
+    // There is one more offset than values
+    if (sizes[1] / offset_size <= length) {
+      raise_invalid("a buffer is too short for the length of its field");
+    }
+    // Strings index their bytes, lists the values of their child
+    int64_t limit = (format[0] == '+') ? array->children[0]->length : sizes[2];
+    const char *offsets = static_cast<const char *>(array->buffers[1]);
+    if (large) {
+      check_offsets<int64_t>(offsets, length, limit);
+    }
+    else {
+      check_offsets<int32_t>(offsets, length, limit);
+    }
+  }
+  else if (format.compare(0, 3, "+w:") == 0) {
+    int64_t size = atoll(format.c_str() + 3);
+    if (size < 0 || (size > 0 && array->children[0]->length / size < length)) {
+      raise_invalid("the values of a fixed size list are too short for its length");
+    }
+  }
+  else if (format == "+s") {
+    for (int64_t i = 0; i < array->n_children; ++i) {
+      if (array->children[i]->length < length) {
+        raise_invalid("a field of a struct is too short for its length");
+      }
+    }
+  }
+}
+
+/**
+ * Fills in `array` for field `f` of record batch `b`, with its buffers and
+ * children kept by `arrays`. The buffers are checked against the length of
+ * the field, and the offsets against what they index.
+ */
+void fill_array(const arrow_ipc_field &f, const arrow_ipc_batch &b, ipc_arrays &arrays, ArrowArray *array)
+{
+  const char *node = b.nodes + 16 * f.node;
+  array->length = load<int64_t>(node);
+  array->null_count = load<int64_t>(node + 8);
+  array->offset = 0;
+
+  arrays.buffers.push_back(vector<const void *>(f.buffer_count));
+  vector<const void *> &buffers = arrays.buffers.back();
+  vector<int64_t> sizes(f.buffer_count);
+  for (intptr_t i = 0; i < f.buffer_count; ++i) {
+    const char *buffer = b.buffers + 16 * (f.buffer + i);
+    int64_t offset = load<int64_t>(buffer), length = load<int64_t>(buffer + 8);
+    if (offset < 0 || length < 0 || offset > b.body_length || length > b.body_length - offset) {
+      raise_invalid("a buffer is out of the body of its record batch");
+    }
+    buffers[i] = b.body + offset;
+    sizes[i] = length;
+    if (i == 0 && (array->null_count == 0 || length == 0)) {
+      // The validity bitmap may be left out without nulls
+      buffers[i] = NULL;
+    }
+  }
+  array->n_buffers = f.buffer_count;
+  array->buffers = buffers.data();
+
+  arrays.child_pointers.push_back(vector<ArrowArray *>());
+  vector<ArrowArray *> &child_pointers = arrays.child_pointers.back();
+  for (const unique_ptr<arrow_ipc_field> &child : f.children) {
+    arrays.children.push_back(ArrowArray());
+    child_pointers.push_back(&arrays.children.back());
+    fill_array(*child, b, arrays, child_pointers.back());
+  }
+  array->n_children = child_pointers.size();
+  array->children = child_pointers.empty() ? NULL : child_pointers.data();
+  array->dictionary = NULL;
+  array->release = &release_child_array;
+  array->private_data = NULL;
+
+  check_layout(f, array, sizes);
+}
+
+const ndt::type &element_type(const nd::array &a)
+{
+  return a.get_type().extended<ndt::base_dim_type>()->get_element_type();
+}
+
+} // anonymous namespace
+
+pydynd::arrow_ipc_reader::arrow_ipc_reader(const std::string &path)
+    : m_bytes(array_memmap(path, ndt::type("Fixed * uint8"), "r", 0, ""))
+{
+  const char *begin = m_bytes.cdata();
+  const char *end = begin + m_bytes.get_dim_size();
+  // The file starts with the magic padded to 8 bytes, and ends with the footer size and the magic
+  if (end - begin < static_cast<intptr_t>(8 + 4 + arrow_magic_size) ||
+      memcmp(begin, arrow_magic, arrow_magic_size) != 0 ||
+      memcmp(end - arrow_magic_size, arrow_magic, arrow_magic_size) != 0) {
+    throw invalid_argument("the file " + path + " isn't an Arrow IPC file, it lacks the ARROW1 magic");
+  }
+
+  const char *footer_end = end - arrow_magic_size - 4;
+  int32_t footer_size = load<int32_t>(footer_end);
+  if (footer_size < 0 || footer_size > footer_end - (begin + 8)) {
+    raise_invalid("the footer is out of bounds");
+  }
+  fb_table footer = fb_table::root(footer_end - footer_size, footer_end);
+
+  unique_ptr<arrow_ipc_layout> layout(new arrow_ipc_layout);
+  fb_table schema = footer.table(1);
+  // Little endian is 0, which is the default
+  bool little_endian = schema.scalar<int16_t>(0, 0) == 0;
+  uint16_t probe = 1;
+  if (little_endian != (*reinterpret_cast<const char *>(&probe) == 1)) {
+    throw invalid_argument("cannot read an Arrow IPC file of the opposite byte order");
+  }
+  const char *fields;
+  uint32_t field_count = schema.vector(1, 4, fields);
+  layout->node_count = 0;
+  layout->buffer_count = 0;
+  for (uint32_t k = 0; k < field_count; ++k) {
+    layout->columns.push_back(parse_field(schema.table_at(fields, k), layout->node_count, layout->buffer_count));
+  }
+
+  // Blocks are structs of an int64 offset, an int32 metadata length and an int64 body length
+  const char *blocks;
+  uint32_t block_count = footer.vector(3, 24, blocks);
+  for (uint32_t k = 0; k < block_count; ++k) {
+    arrow_ipc_batch b = parse_batch(begin, end, blocks + 24 * k);
+    if (b.node_count != layout->node_count || b.buffer_count != layout->buffer_count) {
+      raise_invalid("a record batch doesn't match the schema");
+    }
+    layout->batches.push_back(b);
+  }
+
+  m_layout.reset(layout.release());
+}
+
+intptr_t pydynd::arrow_ipc_reader::get_batch_count() const { return m_layout->batches.size(); }
+
+intptr_t pydynd::arrow_ipc_reader::get_column_count() const { return m_layout->columns.size(); }
+
+const std::string &pydynd::arrow_ipc_reader::get_column_name(intptr_t i) const { return m_layout->columns[i]->name; }
+
+dynd::ndt::type pydynd::arrow_ipc_reader::get_column_type(intptr_t i) const
+{
+  const arrow_ipc_field &f = *m_layout->columns[i];
+  check_supported(f, f.name);
+  return type_from_arrow(&f.schema);
+}
+
+dynd::nd::array pydynd::arrow_ipc_reader::read_column(intptr_t i, intptr_t batch) const
+{
+  const arrow_ipc_field &f = *m_layout->columns[i];
+  check_supported(f, f.name);
+  intptr_t batch_count = m_layout->batches.size();
+  if (batch < -1 || batch >= batch_count) {
+    stringstream ss;
+    ss << "record batch " << batch << " is out of bounds for an Arrow IPC file with " << batch_count;
+    throw invalid_argument(ss.str());
+  }
+
+  if (batch == -1 && batch_count != 1) {
+    // Concatenate the record batches, as options if only some have nulls
+    vector<nd::array> parts;
+    intptr_t size = 0;
+    bool same_type = true;
+    for (intptr_t k = 0; k < batch_count; ++k) {
+      parts.push_back(read_column(i, k));
+      size += parts.back().get_dim_size();
+      same_type = same_type && element_type(parts.back()) == element_type(parts.front());
+    }
+    ndt::type el_tp = (same_type && !parts.empty()) ? element_type(parts.front()) : type_from_arrow(&f.schema);
+    nd::array result = nd::empty(ndt::make_fixed_dim(size, el_tp));
+    intptr_t pos = 0;
+    for (const nd::array &part : parts) {
+      intptr_t part_size = part.get_dim_size();
+      if (part_size > 0) {
+        result(irange(pos, pos + part_size)).assign(part);
+      }
+      pos += part_size;
+    }
+    return result;
+  }
+
+  const arrow_ipc_batch &b = m_layout->batches[batch == -1 ? 0 : batch];
+  ipc_arrays *arrays = new ipc_arrays;
+  arrays->keep = m_bytes;
+  ArrowArray array;
+  try {
+    fill_array(f, b, *arrays, &array);
+  }
+  catch (...) {
+    delete arrays;
+    throw;
+  }
+  // array_from_arrow takes over the array, which releases all the others
+  array.release = &release_ipc_arrays;
+  array.private_data = arrays;
+  return array_from_arrow(&f.schema, &array);
+}
@@ -0,0 +1,689 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "csv_reader.hpp"
+#include "parallel_for.hpp"
+#include "record_fields.hpp"
+#include "utf8.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+typedef pair<const char *, const char *> text_range;
+
+// Texts smaller than this are split into rows on one thread
+const intptr_t min_parallel_split_size = 1 << 20;
+
+const char *const field_kind_names[] = {"bool",   "int8",   "int16",   "int32",   "int64",   "uint8",
+                                        "uint16", "uint32", "uint64",  "float32", "float64", "string"};
+
+/**
+ * Adds the row [begin, end) to `rows`, without the carriage return of a
+ * Windows line ending, unless it is empty.
+ */
+void add_row(const char *begin, const char *end, vector<text_range> &rows)
+{
+  if (end != begin && end[-1] == '\r') {
+    --end;
+  }
+  if (end != begin) {
+    rows.push_back(text_range(begin, end));
+  }
+}
+
+/**
+ * Appends the newlines in [begin, end) which aren't inside quotes to
+ * `out`, starting inside quotes if `in_quote` is true.
+ */
+void find_row_ends(const char *begin, const char *end, char quote, bool in_quote, vector<const char *> &out)
+{
+  for (const char *p = begin; p != end; ++p) {
+    if (*p == quote) {
+      in_quote = !in_quote;
+    }
+    else if (*p == '\n' && !in_quote) {
+      out.push_back(p);
+    }
+  }
+}
+
+/**
+ * Splits [begin, end) into its rows which aren't empty.
+ *
+ * A newline only ends a row outside of quotes, so the text is cut into
+ * chunks which first count their quotes in parallel. The parity of the
+ * quotes before a chunk tells whether it starts inside a quoted field,
+ * and then the chunks find their row ends in parallel.
+ */
+void split_rows(const char *begin, const char *end, char quote, intptr_t nthreads, vector<text_range> &rows)
+{
+  intptr_t size = end - begin;
+  intptr_t nchunks = (nthreads > 1 && size >= min_parallel_split_size) ? 4 * nthreads : 1;
+  vector<const char *> bounds(nchunks + 1);
+  for (intptr_t i = 0; i <= nchunks; ++i) {
+    bounds[i] = begin + size * i / nchunks;
+  }
+
+  vector<char> odd_quotes(nchunks, 0);
+  if (nchunks > 1) {
+    parallel_for(nchunks, nthreads,
+                 [&](intptr_t i) { odd_quotes[i] = count(bounds[i], bounds[i + 1], quote) % 2 != 0; });
+  }
+
+  vector<vector<const char *>> row_ends(nchunks);
+  vector<char> in_quote(nchunks, 0);
+  for (intptr_t i = 1; i < nchunks; ++i) {
+    in_quote[i] = in_quote[i - 1] != odd_quotes[i - 1];
+  }
+  parallel_for(nchunks, nthreads,
+               [&](intptr_t i) { find_row_ends(bounds[i], bounds[i + 1], quote, in_quote[i] != 0, row_ends[i]); });
+
+  const char *row_begin = begin;
+  for (const vector<const char *> &ends : row_ends) {
+    for (const char *row_end : ends) {
+      add_row(row_begin, row_end, rows);
+      row_begin = row_end + 1;
+    }
+  }
+  add_row(row_begin, end, rows);
+}
+
+/**
+ * Reads the next row which isn't empty from `p` on, and moves `p` past it.
+ * Returns false at the end of the text.
+ */
+bool next_row(const char *&p, const char *end, char quote, text_range &row)
+{
+  while (p < end) {
+    bool in_quote = false;
+    const char *row_begin = p;
+    while (p != end && (in_quote || *p != '\n')) {
+      if (*p == quote) {
+        in_quote = !in_quote;
+      }
+      ++p;
+    }
+    const char *row_end = p;
+    if (p != end) {
+      ++p;
+    }
+    if (row_end != row_begin && row_end[-1] == '\r') {
+      --row_end;
+    }
+    if (row_end != row_begin) {
+      row = text_range(row_begin, row_end);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Raises an error in the row `row` of the data, or in the header if it's
+ * negative.
+ */
+void raise_row_error(intptr_t row, const std::string &msg)
+{
+  stringstream ss;
+  if (row < 0) {
+    ss << "CSV header: " << msg;
+  }
+  else {
+    ss << "CSV row " << row << ": " << msg;
+  }
+  throw invalid_argument(ss.str());
+}
+
+/**
+ * Reads the fields of a row one at a time. A quoted field is returned
+ * without its quotes, but with its doubled quotes, which `unquote` turns
+ * into single ones.
+ */
+class field_reader {
+  const char *m_p, *m_end;
+  char m_delimiter, m_quote;
+  bool m_done;
+  intptr_t m_row;
+
+public:
+  field_reader(const text_range &row, const csv_dialect &dialect, intptr_t row_index)
+      : m_p(row.first), m_end(row.second), m_delimiter(dialect.delimiter), m_quote(dialect.quote), m_done(false),
+        m_row(row_index)
+  {
+  }
+
+  bool next(text_range &field, bool &quoted)
+  {
+    if (m_done) {
+      return false;
+    }
+
+    const char *field_end;
+    quoted = (m_p != m_end && *m_p == m_quote);
+    if (quoted) {
+      const char *q = m_p + 1;
+      for (;;) {
+        q = reinterpret_cast<const char *>(memchr(q, m_quote, m_end - q));
+        if (q == NULL) {
+          raise_row_error(m_row, "unterminated quoted field");
+        }
+        if (q + 1 != m_end && q[1] == m_quote) {
+          q += 2;
+          continue;
+        }
+        break;
+      }
+      field = text_range(m_p + 1, q);
+      field_end = q + 1;
+      if (field_end != m_end && *field_end != m_delimiter) {
+        raise_row_error(m_row, "unexpected text after a quoted field");
+      }
+    }
+    else {
+      field_end = reinterpret_cast<const char *>(memchr(m_p, m_delimiter, m_end - m_p));
+      if (field_end == NULL) {
+        field_end = m_end;
+      }
+      field = text_range(m_p, field_end);
+    }
+
+    if (field_end == m_end) {
+      m_done = true;
+    }
+    else {
+      m_p = field_end + 1;
+    }
+    return true;
+  }
+};
+
+void unquote(const text_range &field, char quote, std::string &out)
+{
+  out.clear();
+  for (const char *p = field.first; p != field.second; ++p) {
+    out += *p;
+    if (*p == quote) {
+      // Skip the second quote of the pair
+      ++p;
+    }
+  }
+}
+
+text_range trim(text_range t)
+{
+  while (t.first != t.second && (*t.first == ' ' || *t.first == '\t')) {
+    ++t.first;
+  }
+  while (t.second != t.first && (t.second[-1] == ' ' || t.second[-1] == '\t')) {
+    --t.second;
+  }
+
+  return t;
+}
+
+template <typename T>
+bool parse_normalized_int(const char *begin, const char *end, char *dst, std::true_type)
+{
+  return parse_signed<T>(begin, end, dst);
+}
+
+template <typename T>
+bool parse_normalized_int(const char *begin, const char *end, char *dst, std::false_type)
+{
+  return parse_unsigned<T>(begin, end, dst);
+}
+
+/**
+ * Parses an integer, which unlike in JSON may have a plus sign and leading
+ * zeros, by normalizing it for `parse_signed` or `parse_unsigned`.
+ */
+template <typename T>
+bool parse_int(text_range t, char *dst)
+{
+  char buf[24];
+  size_t n = 0;
+  if (t.first != t.second && (*t.first == '+' || *t.first == '-')) {
+    if (*t.first == '-') {
+      buf[n++] = '-';
+    }
+    ++t.first;
+  }
+  while (t.second - t.first > 1 && *t.first == '0') {
+    ++t.first;
+  }
+  if (t.second - t.first > 20) {
+    return false;
+  }
+  memcpy(buf + n, t.first, t.second - t.first);
+  n += t.second - t.first;
+
+  return parse_normalized_int<T>(buf, buf + n, dst, std::is_signed<T>());
+}
+
+const char *skip_digits(const char *begin, const char *end)
+{
+  while (begin != end && *begin >= '0' && *begin <= '9') {
+    ++begin;
+  }
+  return begin;
+}
+
+/**
+ * Parses a decimal number, with an optional sign, digits with an optional
+ * point, and an optional exponent. Unlike strtod, this doesn't take hex
+ * numbers, infinities or NaNs, nor the decimal point of the locale.
+ */
+bool parse_float(text_range t, double &out)
+{
+  const char *p = t.first, *end = t.second;
+  bool negative = (p != end && *p == '-');
+  if (p != end && (*p == '+' || *p == '-')) {
+    ++p;
+  }
+  const char *int_begin = p, *int_end = skip_digits(p, end);
+  const char *frac_begin = int_end, *frac_end = int_end;
+  if (int_end != end && *int_end == '.') {
+    frac_begin = int_end + 1;
+    frac_end = skip_digits(frac_begin, end);
+  }
+  if (int_begin == int_end && frac_begin == frac_end) {
+    return false;
+  }
+  p = frac_end;
+
+  long long exponent = 0;
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = (p != end && *p == '-');
+    if (p != end && (*p == '+' || *p == '-')) {
+      ++p;
+    }
+    const char *exponent_begin = p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      // Any larger exponent overflows or underflows all the same
+      if (exponent < 1000000000) {
+        exponent = exponent * 10 + (*p - '0');
+      }
+    }
+    if (p == exponent_begin) {
+      return false;
+    }
+    if (negative_exponent) {
+      exponent = -exponent;
+    }
+  }
+  if (p != end) {
+    return false;
+  }
+
+  // strtod reads the digits without the point, and the exponent moved past
+  // them, the same in any locale. The text also has to be null terminated,
+  // which the field isn't.
+  exponent -= frac_end - frac_begin;
+  size_t size = (int_end - int_begin) + (frac_end - frac_begin) + 32;
+  char small[64];
+  std::string large;
+  char *buf = small;
+  if (size > sizeof(small)) {
+    large.resize(size);
+    buf = &large[0];
+  }
+  char *q = buf;
+  if (negative) {
+    *q++ = '-';
+  }
+  q = copy(int_begin, int_end, q);
+  q = copy(frac_begin, frac_end, q);
+  snprintf(q, 32, "e%lld", exponent);
+  out = strtod(buf, NULL);
+
+  return true;
+}
+
+bool equals(const text_range &t, const char *s)
+{
+  size_t n = t.second - t.first;
+  return n == strlen(s) && memcmp(t.first, s, n) == 0;
+}
+
+bool parse_bool(text_range t, char *dst)
+{
+  if (equals(t, "true") || equals(t, "True") || equals(t, "TRUE") || equals(t, "1")) {
+    *dst = 1;
+    return true;
+  }
+  if (equals(t, "false") || equals(t, "False") || equals(t, "FALSE") || equals(t, "0")) {
+    *dst = 0;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Stores the value of a field. Returns false if it isn't a value of the
+ * field's type.
+ */
+bool store_field(const field_plan &f, const text_range &text, bool quoted, char quote, char *dst, std::string &scratch)
+{
+  if (f.kind == string_field) {
+    if (text.first == text.second) {
+      // A new string is already empty, which is unavailable for an option
+      return true;
+    }
+    if (utf8_length(text.first, text.second) < 0) {
+      return false;
+    }
+    dynd::bytes *s = reinterpret_cast<dynd::bytes *>(dst);
+    if (quoted && memchr(text.first, quote, text.second - text.first) != NULL) {
+      unquote(text, quote, scratch);
+      s->assign(scratch.data(), scratch.size());
+    }
+    else {
+      s->assign(text.first, text.second - text.first);
+    }
+    return true;
+  }
+
+  text_range t = trim(text);
+  if (t.first == t.second) {
+    return f.option && store_na(f, dst);
+  }
+
+  switch (f.kind) {
+  case bool_field:
+    return parse_bool(t, dst);
+  case int8_field:
+    return parse_int<int8_t>(t, dst);
+  case int16_field:
+    return parse_int<int16_t>(t, dst);
+  case int32_field:
+    return parse_int<int32_t>(t, dst);
+  case int64_field:
+    return parse_int<int64_t>(t, dst);
+  case uint8_field:
+    return parse_int<uint8_t>(t, dst);
+  case uint16_field:
+    return parse_int<uint16_t>(t, dst);
+  case uint32_field:
+    return parse_int<uint32_t>(t, dst);
+  case uint64_field:
+    return parse_int<uint64_t>(t, dst);
+  case float32_field: {
+    double value;
+    if (!parse_float(t, value)) {
+      return false;
+    }
+    float result = static_cast<float>(value);
+    memcpy(dst, &result, sizeof(float));
+    return true;
+  }
+  case float64_field: {
+    double value;
+    if (!parse_float(t, value)) {
+      return false;
+    }
+    memcpy(dst, &value, sizeof(double));
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+void raise_columns_error(intptr_t row, size_t ncolumns, const char *of)
+{
+  stringstream ss;
+  ss << "found more than the " << ncolumns << " columns of the " << of;
+  raise_row_error(row, ss.str());
+}
+
+void raise_value_error(intptr_t row, size_t column, const field_plan &f, const text_range &text)
+{
+  stringstream ss;
+  if (f.kind == string_field) {
+    ss << "found invalid UTF-8 in column " << column << " for the field '" << f.name << "'";
+    raise_row_error(row, ss.str());
+  }
+
+  // The start of the value, cut at a character, if it is valid UTF-8
+  const char *value_end = text.first + min<intptr_t>(text.second - text.first, 40);
+  while (value_end != text.second && value_end != text.first && (static_cast<unsigned char>(*value_end) & 0xC0) == 0x80) {
+    --value_end;
+  }
+  ss << "cannot parse ";
+  if (utf8_length(text.first, value_end) >= 0) {
+    ss << "'" << std::string(text.first, value_end) << "' ";
+  }
+  ss << "as " << field_kind_names[f.kind] << " in column " << column << " for the field '" << f.name << "'";
+  raise_row_error(row, ss.str());
+}
+
+/**
+ * The columns of the CSV, each the index of the field it is parsed into,
+ * or -1 to skip it.
+ */
+vector<intptr_t> match_columns(const vector<field_plan> &fields, const vector<std::string> &names)
+{
+  vector<intptr_t> columns(names.size(), -1);
+  for (size_t j = 0; j < fields.size(); ++j) {
+    vector<std::string>::const_iterator it = find(names.begin(), names.end(), fields[j].name);
+    if (it != names.end()) {
+      columns[it - names.begin()] = j;
+    }
+    else if (!fields[j].option) {
+      throw invalid_argument("the CSV has no column for the field '" + fields[j].name +
+                             "', which only an option field may lack");
+    }
+  }
+
+  return columns;
+}
+
+vector<std::string> read_names(const text_range &row, const csv_dialect &dialect)
+{
+  vector<std::string> names;
+  field_reader reader(row, dialect, -1);
+  text_range field;
+  bool quoted;
+  std::string name;
+  while (reader.next(field, quoted)) {
+    if (quoted) {
+      unquote(field, dialect.quote, name);
+    }
+    else {
+      text_range t = trim(field);
+      name.assign(t.first, t.second);
+    }
+    names.push_back(name);
+  }
+
+  return names;
+}
+
+enum column_kind { unknown_column, int_column, float_column, bool_column, string_column };
+
+column_kind merge_columns(column_kind a, column_kind b)
+{
+  if (a == unknown_column || a == b) {
+    return b;
+  }
+  if ((a == int_column && b == float_column) || (a == float_column && b == int_column)) {
+    return float_column;
+  }
+
+  return string_column;
+}
+
+column_kind classify(const text_range &field)
+{
+  text_range t = trim(field);
+  char buf[8];
+  double value;
+  if (parse_int<int64_t>(t, buf)) {
+    return int_column;
+  }
+  if (parse_float(t, value)) {
+    return float_column;
+  }
+  if (parse_bool(t, buf)) {
+    return bool_column;
+  }
+
+  return string_column;
+}
+
+} // anonymous namespace
+
+dynd::ndt::type pydynd::discover_csv(const char *begin, const char *end, const csv_dialect &dialect,
+                                     intptr_t sample_rows)
+{
+  const char *p = begin;
+  text_range row;
+  vector<std::string> names;
+  if (dialect.header && next_row(p, end, dialect.quote, row)) {
+    names = read_names(row, dialect);
+  }
+
+  vector<column_kind> kinds(names.size(), unknown_column);
+  vector<char> nullable(names.size(), 0);
+  for (intptr_t i = 0; i < sample_rows && next_row(p, end, dialect.quote, row); ++i) {
+    field_reader reader(row, dialect, i);
+    text_range field;
+    bool quoted;
+    size_t j = 0;
+    for (; reader.next(field, quoted); ++j) {
+      if (j == kinds.size()) {
+        if (dialect.header) {
+          raise_columns_error(i, names.size(), "header");
+        }
+        // The rows before lacked this column
+        kinds.push_back(unknown_column);
+        nullable.push_back(i > 0);
+      }
+      text_range t = trim(field);
+      if (!quoted && t.first == t.second) {
+        nullable[j] = 1;
+      }
+      else {
+        kinds[j] = merge_columns(kinds[j], quoted && field.first == field.second ? string_column : classify(field));
+      }
+    }
+    for (; j < kinds.size(); ++j) {
+      nullable[j] = 1;
+    }
+  }
+
+  vector<ndt::type> types;
+  for (size_t j = 0; j < kinds.size(); ++j) {
+    if (j == names.size()) {
+      stringstream ss;
+      ss << "f" << j;
+      names.push_back(ss.str());
+    }
+    ndt::type tp;
+    switch (kinds[j]) {
+    case int_column:
+      tp = ndt::make_type<int64_t>();
+      break;
+    case float_column:
+      tp = ndt::make_type<double>();
+      break;
+    case bool_column:
+      tp = ndt::make_type<bool1>();
+      break;
+    default:
+      tp = ndt::make_type<ndt::string_type>();
+      break;
+    }
+    types.push_back((nullable[j] || kinds[j] == unknown_column) ? ndt::make_type<ndt::option_type>(tp) : tp);
+  }
+
+  return ndt::make_type<ndt::struct_type>(names, types);
+}
+
+dynd::nd::array pydynd::parse_csv(const dynd::ndt::type &tp, const char *begin, const char *end,
+                                  const csv_dialect &dialect, intptr_t nthreads)
+{
+  vector<text_range> rows;
+  split_rows(begin, end, dialect.quote, nthreads, rows);
+  vector<std::string> names;
+  size_t first_row = 0;
+  if (dialect.header && !rows.empty()) {
+    names = read_names(rows[0], dialect);
+    first_row = 1;
+  }
+
+  intptr_t nrows = rows.size() - first_row;
+  nd::array result = nd::empty(ndt::make_fixed_dim(nrows, tp));
+  const char *arrmeta = result.get()->metadata();
+  vector<field_plan> fields;
+  if (!make_record_plan(tp, arrmeta + sizeof(fixed_dim_type_arrmeta), fields)) {
+    stringstream ss;
+    ss << "cannot read CSV rows of type " << tp
+       << ", it must be a struct of booleans, numbers or strings, or options of them";
+    throw type_error(ss.str());
+  }
+  vector<intptr_t> columns;
+  if (dialect.header) {
+    columns = match_columns(fields, names);
+  }
+  else {
+    for (size_t j = 0; j < fields.size(); ++j) {
+      columns.push_back(j);
+    }
+  }
+
+  intptr_t stride = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta)->stride;
+  char *data = result.data();
+  intptr_t nblocks = nthreads > 1 ? min<intptr_t>(nrows, 4 * nthreads) : 1;
+  parallel_for(nblocks, nthreads, [&](intptr_t block) {
+    vector<char> seen(fields.size());
+    std::string scratch;
+    for (intptr_t i = nrows * block / nblocks; i < nrows * (block + 1) / nblocks; ++i) {
+      char *dst = data + i * stride;
+      field_reader reader(rows[first_row + i], dialect, i);
+      text_range field;
+      bool quoted;
+      fill(seen.begin(), seen.end(), 0);
+      for (size_t j = 0; reader.next(field, quoted); ++j) {
+        if (j >= columns.size()) {
+          raise_columns_error(i, columns.size(), dialect.header ? "header" : "type");
+        }
+        if (columns[j] >= 0) {
+          const field_plan &f = fields[columns[j]];
+          if (!store_field(f, field, quoted, dialect.quote, dst + f.offset, scratch)) {
+            raise_value_error(i, j, f, field);
+          }
+          seen[columns[j]] = 1;
+        }
+      }
+
+      for (size_t j = 0; j < fields.size(); ++j) {
+        if (!seen[j] && !(fields[j].option && store_na(fields[j], dst + fields[j].offset))) {
+          raise_row_error(i, "found no value for the field '" + fields[j].name + "'");
+        }
+      }
+    }
+  });
+
+  return result;
+}
@@ -5,6 +5,7 @@
 
 #include "functional.hpp"
 #include "callables/apply_pyobject_callable.hpp"
+#include "kernel_cache.hpp"
 #include "callable_api.h"
 
 using namespace std;
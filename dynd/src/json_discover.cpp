@@ -0,0 +1,480 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "json_discover.hpp"
+#include "json_string.hpp"
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// Values nested deeper than this are rejected instead of overflowing the
+// stack of the recursive scanner
+const int max_depth = 1024;
+
+enum shape_kind { null_kind, bool_kind, int_kind, float_kind, string_kind, list_kind, object_kind };
+
+const char *kind_name(shape_kind kind)
+{
+  switch (kind) {
+  case null_kind:
+    return "null";
+  case bool_kind:
+    return "boolean";
+  case int_kind:
+  case float_kind:
+    return "number";
+  case string_kind:
+    return "string";
+  case list_kind:
+    return "list";
+  default:
+    return "object";
+  }
+}
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+} // anonymous namespace
+
+/**
+ * The merged shape of the values seen at one place in the JSON values.
+ */
+struct pydynd::json_type_discoverer::shape {
+  shape_kind kind;
+  bool nullable;
+  // The elements of a list
+  unique_ptr<shape> element;
+  // The fields of an object, in the order they were first seen, the number
+  // of objects each appeared in, and the number of objects
+  vector<pair<std::string, unique_ptr<shape>>> fields;
+  vector<intptr_t> field_counts;
+  map<std::string, size_t> field_index;
+  intptr_t count;
+
+  shape() : kind(null_kind), nullable(false), count(0) {}
+
+  /**
+   * The type of the values, where `where` names them in errors. Only
+   * scalars can be options, so lists and objects which are null, or
+   * missing from some objects, raise a type_error.
+   */
+  ndt::type get_type(const std::string &where) const
+  {
+    if (nullable && (kind == list_kind || kind == object_kind)) {
+      raise_not_optional(where, "sometimes null");
+    }
+
+    ndt::type tp;
+    switch (kind) {
+    case null_kind:
+      // Only nulls were seen, which any option type holds
+      return ndt::make_type<ndt::option_type>(ndt::make_type<ndt::string_type>());
+    case bool_kind:
+      tp = ndt::make_type<bool1>();
+      break;
+    case int_kind:
+      tp = ndt::make_type<int64_t>();
+      break;
+    case float_kind:
+      tp = ndt::make_type<double>();
+      break;
+    case string_kind:
+      tp = ndt::make_type<ndt::string_type>();
+      break;
+    case list_kind:
+      return ndt::make_type<ndt::var_dim_type>(element->get_type("the elements of " + where));
+    case object_kind: {
+      vector<std::string> names;
+      vector<ndt::type> types;
+      for (size_t i = 0; i < fields.size(); ++i) {
+        const shape &field = *fields[i].second;
+        std::string field_where = "the field '" + fields[i].first + "' of " + where;
+        ndt::type field_tp = field.get_type(field_where);
+        if (field_counts[i] < count && field_tp.get_id() != option_id) {
+          if (field.kind == list_kind || field.kind == object_kind) {
+            field.raise_not_optional(field_where, "missing from some objects");
+          }
+          field_tp = ndt::make_type<ndt::option_type>(field_tp);
+        }
+        names.push_back(fields[i].first);
+        types.push_back(field_tp);
+      }
+      return ndt::make_type<ndt::struct_type>(names, types);
+    }
+    }
+
+    return nullable ? ndt::make_type<ndt::option_type>(tp) : tp;
+  }
+
+  void raise_not_optional(const std::string &where, const char *why) const
+  {
+    stringstream ss;
+    ss << "cannot discover a type for " << where << ", only scalars can be options, not " << kind_name(kind)
+       << "s which are " << why;
+    throw type_error(ss.str());
+  }
+};
+
+namespace {
+
+typedef pydynd::json_type_discoverer::shape shape;
+
+/**
+ * Scans one JSON value, merging its shape into a shape tree, without
+ * building the value.
+ */
+class scanner {
+  const char *m_begin, *m_end, *m_p;
+  std::string m_key;
+
+  void raise(const std::string &msg) const
+  {
+    stringstream ss;
+    ss << "JSON error at offset " << (m_p - m_begin) << ": " << msg;
+    throw invalid_argument(ss.str());
+  }
+
+  void raise_conflict(shape_kind kind, shape_kind earlier_kind) const
+  {
+    stringstream ss;
+    ss << "cannot discover a type for the JSON value at offset " << (m_p - m_begin) << ", found a "
+       << kind_name(kind) << " where earlier values had a " << kind_name(earlier_kind);
+    throw type_error(ss.str());
+  }
+
+  void skip_space()
+  {
+    while (m_p != m_end && is_space(*m_p)) {
+      ++m_p;
+    }
+  }
+
+  void expect(char c)
+  {
+    skip_space();
+    if (m_p == m_end || *m_p != c) {
+      raise(std::string("expected '") + c + "'");
+    }
+    ++m_p;
+  }
+
+  void expect_literal(const char *literal)
+  {
+    size_t size = strlen(literal);
+    if (static_cast<size_t>(m_end - m_p) < size || memcmp(m_p, literal, size) != 0) {
+      raise("invalid value");
+    }
+    m_p += size;
+  }
+
+  /**
+   * Skips a string, with `m_p` at its opening quote. Returns the contents
+   * between the quotes, and whether they have escapes.
+   */
+  pair<const char *, const char *> skip_string(bool &escaped)
+  {
+    const char *begin = ++m_p;
+    escaped = false;
+    for (;;) {
+      const char *quote = reinterpret_cast<const char *>(memchr(m_p, '"', m_end - m_p));
+      if (quote == NULL) {
+        raise("unterminated string");
+      }
+      // The quote is escaped if it follows an odd number of backslashes
+      const char *q = quote;
+      while (q != begin && q[-1] == '\\') {
+        --q;
+      }
+      escaped |= (q != quote) || memchr(m_p, '\\', quote - m_p) != NULL;
+      m_p = quote + 1;
+      if ((quote - q) % 2 == 0) {
+        return make_pair(begin, quote);
+      }
+    }
+  }
+
+  /**
+   * Scans a number, returning whether it is an integer that fits in an
+   * int64.
+   */
+  bool scan_number()
+  {
+    const char *begin = m_p;
+    bool negative = (*m_p == '-');
+    if (negative) {
+      ++m_p;
+    }
+    const char *digits = m_p;
+    while (m_p != m_end && is_digit(*m_p)) {
+      ++m_p;
+    }
+    if (m_p == digits || (*digits == '0' && m_p - digits > 1)) {
+      m_p = begin;
+      raise("invalid number");
+    }
+
+    // Integers of up to 18 digits always fit, longer ones are compared
+    // against the limit of their sign
+    size_t ndigits = m_p - digits;
+    const char *limit = negative ? "9223372036854775808" : "9223372036854775807";
+    bool is_int = ndigits < 19 || (ndigits == 19 && memcmp(digits, limit, 19) <= 0);
+    if (m_p != m_end && *m_p == '.') {
+      const char *fraction = ++m_p;
+      while (m_p != m_end && is_digit(*m_p)) {
+        ++m_p;
+      }
+      if (m_p == fraction) {
+        raise("invalid number");
+      }
+      is_int = false;
+    }
+    if (m_p != m_end && (*m_p == 'e' || *m_p == 'E')) {
+      ++m_p;
+      if (m_p != m_end && (*m_p == '+' || *m_p == '-')) {
+        ++m_p;
+      }
+      const char *exponent = m_p;
+      while (m_p != m_end && is_digit(*m_p)) {
+        ++m_p;
+      }
+      if (m_p == exponent) {
+        raise("invalid number");
+      }
+      is_int = false;
+    }
+
+    return is_int;
+  }
+
+  void merge_kind(shape &s, shape_kind kind, const char *value_begin)
+  {
+    if (s.kind == kind || (s.kind == float_kind && kind == int_kind)) {
+      return;
+    }
+    if (s.kind == null_kind || (s.kind == int_kind && kind == float_kind)) {
+      s.kind = kind;
+      return;
+    }
+
+    m_p = value_begin;
+    raise_conflict(kind, s.kind);
+  }
+
+public:
+  scanner(const char *begin, const char *end) : m_begin(begin), m_end(end), m_p(begin) {}
+
+  /**
+   * Scans a list, with `m_p` at its opening bracket. With `max_elements`
+   * not negative, stops after that many elements without scanning the
+   * rest of the text, and returns false.
+   */
+  bool scan_list(shape &s, int depth, intptr_t max_elements)
+  {
+    merge_kind(s, list_kind, m_p);
+    if (!s.element) {
+      s.element.reset(new shape());
+    }
+    ++m_p;
+    skip_space();
+    if (m_p != m_end && *m_p == ']') {
+      ++m_p;
+      return true;
+    }
+    for (intptr_t i = 0;; ++i) {
+      if (i == max_elements) {
+        return false;
+      }
+      scan_value(*s.element, depth + 1);
+      skip_space();
+      if (m_p != m_end && *m_p == ',') {
+        ++m_p;
+        continue;
+      }
+      expect(']');
+      return true;
+    }
+  }
+
+  void scan_value(shape &s, int depth)
+  {
+    if (depth > max_depth) {
+      raise("values are nested too deeply");
+    }
+
+    skip_space();
+    if (m_p == m_end) {
+      raise("expected a value");
+    }
+    const char *value_begin = m_p;
+    switch (*m_p) {
+    case 'n':
+      expect_literal("null");
+      s.nullable = true;
+      break;
+    case 't':
+      expect_literal("true");
+      merge_kind(s, bool_kind, value_begin);
+      break;
+    case 'f':
+      expect_literal("false");
+      merge_kind(s, bool_kind, value_begin);
+      break;
+    case '"': {
+      bool escaped;
+      skip_string(escaped);
+      merge_kind(s, string_kind, value_begin);
+      break;
+    }
+    case '[':
+      scan_list(s, depth, -1);
+      break;
+    case '{':
+      merge_kind(s, object_kind, value_begin);
+      ++s.count;
+      ++m_p;
+      skip_space();
+      if (m_p != m_end && *m_p == '}') {
+        ++m_p;
+        break;
+      }
+      for (;;) {
+        skip_space();
+        if (m_p == m_end || *m_p != '"') {
+          raise("expected a field name");
+        }
+        bool escaped;
+        pair<const char *, const char *> name = skip_string(escaped);
+        if (!escaped) {
+          m_key.assign(name.first, name.second);
+        }
+        else if (!pydynd::json_unescape(name.first, name.second, m_key)) {
+          raise("invalid escape sequence in a field name");
+        }
+        map<std::string, size_t>::iterator it = s.field_index.find(m_key);
+        if (it == s.field_index.end()) {
+          it = s.field_index.insert(make_pair(m_key, s.fields.size())).first;
+          s.fields.push_back(make_pair(m_key, unique_ptr<shape>(new shape())));
+          s.field_counts.push_back(0);
+        }
+        size_t i = it->second;
+        ++s.field_counts[i];
+        expect(':');
+        scan_value(*s.fields[i].second, depth + 1);
+        skip_space();
+        if (m_p != m_end && *m_p == ',') {
+          ++m_p;
+          continue;
+        }
+        expect('}');
+        break;
+      }
+      break;
+    default:
+      if (*m_p == '-' || is_digit(*m_p)) {
+        merge_kind(s, scan_number() ? int_kind : float_kind, value_begin);
+      }
+      else {
+        raise("invalid value");
+      }
+    }
+  }
+
+  /**
+   * Scans a whole value. With `max_elements` not negative, only that many
+   * elements of a list at the top are scanned.
+   */
+  void scan_to_end(shape &s, intptr_t max_elements)
+  {
+    skip_space();
+    if (max_elements >= 0 && m_p != m_end && *m_p == '[') {
+      if (!scan_list(s, 0, max_elements)) {
+        return;
+      }
+    }
+    else {
+      scan_value(s, 0);
+    }
+    skip_space();
+    if (m_p != m_end) {
+      raise("unexpected text after the value");
+    }
+  }
+};
+
+bool is_blank(const char *begin, const char *end)
+{
+  for (; begin != end; ++begin) {
+    if (!is_space(*begin)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // anonymous namespace
+
+pydynd::json_type_discoverer::json_type_discoverer() : m_root(new shape()), m_nrows(0) {}
+
+pydynd::json_type_discoverer::~json_type_discoverer() {}
+
+void pydynd::json_type_discoverer::add_lines(const char *begin, const char *end)
+{
+  while (begin < end) {
+    const char *line_end = reinterpret_cast<const char *>(memchr(begin, '\n', end - begin));
+    if (line_end == NULL) {
+      line_end = end;
+    }
+    if (!is_blank(begin, line_end)) {
+      try {
+        scanner(begin, line_end).scan_to_end(*m_root, -1);
+      }
+      catch (const invalid_argument &e) {
+        stringstream ss;
+        ss << "row " << m_nrows << ": " << e.what();
+        throw invalid_argument(ss.str());
+      }
+      catch (const type_error &e) {
+        stringstream ss;
+        ss << "row " << m_nrows << ": " << e.what();
+        throw type_error(ss.str());
+      }
+      ++m_nrows;
+    }
+    begin = line_end + 1;
+  }
+}
+
+void pydynd::json_type_discoverer::add_value(const char *begin, const char *end, intptr_t max_elements)
+{
+  scanner(begin, end).scan_to_end(*m_root, max_elements);
+  ++m_nrows;
+}
+
+dynd::ndt::type pydynd::json_type_discoverer::get() const
+{
+  if (m_nrows == 0) {
+    throw invalid_argument("cannot discover the type of JSON without any values");
+  }
+
+  return m_root->get_type("the values");
+}
@@ -0,0 +1,659 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "array_dims.hpp"
+#include "json_formatter.hpp"
+#include "record_fields.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+template <typename T>
+void append_unsigned(T value, std::string &out)
+{
+  char buf[24];
+  char *p = buf + sizeof(buf);
+  do {
+    *--p = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  out.append(p, buf + sizeof(buf));
+}
+
+template <typename T>
+void append_signed(T value, std::string &out)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  if (value < 0) {
+    out += '-';
+    // Negate in the unsigned type, which is defined for the minimum
+    append_unsigned(static_cast<U>(U(0) - static_cast<U>(value)), out);
+  }
+  else {
+    append_unsigned(static_cast<U>(value), out);
+  }
+}
+
+// The shortest digits of floats and doubles are found with the Grisu3
+// algorithm of Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers" (PLDI 2010), which uses integer arithmetic only
+// and so doesn't depend on the locale. It proves its result right for all
+// but about 0.5% of the values, which take a slower exact search.
+
+/**
+ * A binary floating point number f * 2^e, with a 64-bit significand.
+ */
+struct diy_fp {
+  uint64_t f;
+  int e;
+};
+
+diy_fp make_diy_fp(uint64_t f, int e)
+{
+  diy_fp x = {f, e};
+  return x;
+}
+
+diy_fp normalize(diy_fp x)
+{
+  while ((x.f & (uint64_t(1) << 63)) == 0) {
+    x.f <<= 1;
+    --x.e;
+  }
+  return x;
+}
+
+/**
+ * Returns x * y, with the upper 64 bits of the product of the significands
+ * rounded to nearest.
+ */
+diy_fp multiply(diy_fp x, diy_fp y)
+{
+  const uint64_t mask = 0xFFFFFFFFu;
+  uint64_t a = x.f >> 32, b = x.f & mask, c = y.f >> 32, d = y.f & mask;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (uint64_t(1) << 31);
+  return make_diy_fp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64);
+}
+
+/**
+ * The normalized powers of ten 10^k, for every eighth k from -348 to 340,
+ * rounded to nearest.
+ */
+struct cached_power {
+  uint64_t f;
+  int e;
+  int k;
+};
+
+const cached_power cached_powers[] = {
+    {0xfa8fd5a0081c0288ull, -1220, -348},
+    {0xbaaee17fa23ebf76ull, -1193, -340},
+    {0x8b16fb203055ac76ull, -1166, -332},
+    {0xcf42894a5dce35eaull, -1140, -324},
+    {0x9a6bb0aa55653b2dull, -1113, -316},
+    {0xe61acf033d1a45dfull, -1087, -308},
+    {0xab70fe17c79ac6caull, -1060, -300},
+    {0xff77b1fcbebcdc4full, -1034, -292},
+    {0xbe5691ef416bd60cull, -1007, -284},
+    {0x8dd01fad907ffc3cull, -980, -276},
+    {0xd3515c2831559a83ull, -954, -268},
+    {0x9d71ac8fada6c9b5ull, -927, -260},
+    {0xea9c227723ee8bcbull, -901, -252},
+    {0xaecc49914078536dull, -874, -244},
+    {0x823c12795db6ce57ull, -847, -236},
+    {0xc21094364dfb5637ull, -821, -228},
+    {0x9096ea6f3848984full, -794, -220},
+    {0xd77485cb25823ac7ull, -768, -212},
+    {0xa086cfcd97bf97f4ull, -741, -204},
+    {0xef340a98172aace5ull, -715, -196},
+    {0xb23867fb2a35b28eull, -688, -188},
+    {0x84c8d4dfd2c63f3bull, -661, -180},
+    {0xc5dd44271ad3cdbaull, -635, -172},
+    {0x936b9fcebb25c996ull, -608, -164},
+    {0xdbac6c247d62a584ull, -582, -156},
+    {0xa3ab66580d5fdaf6ull, -555, -148},
+    {0xf3e2f893dec3f126ull, -529, -140},
+    {0xb5b5ada8aaff80b8ull, -502, -132},
+    {0x87625f056c7c4a8bull, -475, -124},
+    {0xc9bcff6034c13053ull, -449, -116},
+    {0x964e858c91ba2655ull, -422, -108},
+    {0xdff9772470297ebdull, -396, -100},
+    {0xa6dfbd9fb8e5b88full, -369, -92},
+    {0xf8a95fcf88747d94ull, -343, -84},
+    {0xb94470938fa89bcfull, -316, -76},
+    {0x8a08f0f8bf0f156bull, -289, -68},
+    {0xcdb02555653131b6ull, -263, -60},
+    {0x993fe2c6d07b7facull, -236, -52},
+    {0xe45c10c42a2b3b06ull, -210, -44},
+    {0xaa242499697392d3ull, -183, -36},
+    {0xfd87b5f28300ca0eull, -157, -28},
+    {0xbce5086492111aebull, -130, -20},
+    {0x8cbccc096f5088ccull, -103, -12},
+    {0xd1b71758e219652cull, -77, -4},
+    {0x9c40000000000000ull, -50, 4},
+    {0xe8d4a51000000000ull, -24, 12},
+    {0xad78ebc5ac620000ull, 3, 20},
+    {0x813f3978f8940984ull, 30, 28},
+    {0xc097ce7bc90715b3ull, 56, 36},
+    {0x8f7e32ce7bea5c70ull, 83, 44},
+    {0xd5d238a4abe98068ull, 109, 52},
+    {0x9f4f2726179a2245ull, 136, 60},
+    {0xed63a231d4c4fb27ull, 162, 68},
+    {0xb0de65388cc8ada8ull, 189, 76},
+    {0x83c7088e1aab65dbull, 216, 84},
+    {0xc45d1df942711d9aull, 242, 92},
+    {0x924d692ca61be758ull, 269, 100},
+    {0xda01ee641a708deaull, 295, 108},
+    {0xa26da3999aef774aull, 322, 116},
+    {0xf209787bb47d6b85ull, 348, 124},
+    {0xb454e4a179dd1877ull, 375, 132},
+    {0x865b86925b9bc5c2ull, 402, 140},
+    {0xc83553c5c8965d3dull, 428, 148},
+    {0x952ab45cfa97a0b3ull, 455, 156},
+    {0xde469fbd99a05fe3ull, 481, 164},
+    {0xa59bc234db398c25ull, 508, 172},
+    {0xf6c69a72a3989f5cull, 534, 180},
+    {0xb7dcbf5354e9beceull, 561, 188},
+    {0x88fcf317f22241e2ull, 588, 196},
+    {0xcc20ce9bd35c78a5ull, 614, 204},
+    {0x98165af37b2153dfull, 641, 212},
+    {0xe2a0b5dc971f303aull, 667, 220},
+    {0xa8d9d1535ce3b396ull, 694, 228},
+    {0xfb9b7cd9a4a7443cull, 720, 236},
+    {0xbb764c4ca7a44410ull, 747, 244},
+    {0x8bab8eefb6409c1aull, 774, 252},
+    {0xd01fef10a657842cull, 800, 260},
+    {0x9b10a4e5e9913129ull, 827, 268},
+    {0xe7109bfba19c0c9dull, 853, 276},
+    {0xac2820d9623bf429ull, 880, 284},
+    {0x80444b5e7aa7cf85ull, 907, 292},
+    {0xbf21e44003acdd2dull, 933, 300},
+    {0x8e679c2f5e44ff8full, 960, 308},
+    {0xd433179d9c8cb841ull, 986, 316},
+    {0x9e19db92b4e31ba9ull, 1013, 324},
+    {0xeb96bf6ebadf77d9ull, 1039, 332},
+    {0xaf87023b9bf0ee6bull, 1066, 340},
+};
+
+/**
+ * Returns the cached power of ten which scales a normalized number with the
+ * binary exponent `e` to one with an exponent in [-60, -32].
+ */
+const cached_power &find_cached_power(int e)
+{
+  int min_exponent = -60 - (e + 64);
+  int k = static_cast<int>(std::ceil((min_exponent + 63) * 0.30102999566398114));
+  return cached_powers[(348 + k - 1) / 8 + 1];
+}
+
+/**
+ * Finds the normalized value `w` of a positive `value`, and the boundaries
+ * `minus` and `plus` halfway to its neighbours, with the same exponent.
+ */
+template <typename T>
+void boundaries(T value, diy_fp &w, diy_fp &minus, diy_fp &plus)
+{
+  const int significand_size = std::numeric_limits<T>::digits - 1;
+  const int exponent_bias = std::numeric_limits<T>::max_exponent - 1 + significand_size;
+  typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type bits_type;
+  bits_type bits;
+  memcpy(&bits, &value, sizeof(T));
+
+  const uint64_t hidden_bit = uint64_t(1) << significand_size;
+  uint64_t fraction = bits & (hidden_bit - 1);
+  int biased_exponent = static_cast<int>(bits >> significand_size);
+  diy_fp v = (biased_exponent == 0) ? make_diy_fp(fraction, 1 - exponent_bias)
+                                    : make_diy_fp(fraction + hidden_bit, biased_exponent - exponent_bias);
+
+  plus = normalize(make_diy_fp((v.f << 1) + 1, v.e - 1));
+  // The neighbour below a power of two is closer, except for the smallest
+  // normal number
+  if (fraction == 0 && biased_exponent > 1) {
+    minus = make_diy_fp((v.f << 2) - 1, v.e - 2);
+  }
+  else {
+    minus = make_diy_fp((v.f << 1) - 1, v.e - 1);
+  }
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  w = normalize(v);
+}
+
+/**
+ * Moves the last digit of `buffer` towards the scaled value, and checks
+ * that the digits are the closest ones within the safe interval.
+ */
+bool round_weed(char *buffer, int length, uint64_t distance_too_high_w, uint64_t unsafe_interval, uint64_t rest,
+                uint64_t ten_kappa, uint64_t unit)
+{
+  uint64_t small_distance = distance_too_high_w - unit;
+  uint64_t big_distance = distance_too_high_w + unit;
+  while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+         (rest + ten_kappa < small_distance || small_distance - rest >= rest + ten_kappa - small_distance)) {
+    --buffer[length - 1];
+    rest += ten_kappa;
+  }
+  if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+      (rest + ten_kappa < big_distance || big_distance - rest > rest + ten_kappa - big_distance)) {
+    return false;
+  }
+
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+/**
+ * Writes the shortest digits of the scaled value `w` within the boundaries
+ * `low` and `high` to `buffer`, and their number to `length`, as far as
+ * the errors of the scaling allow. `kappa` is set to the decimal exponent
+ * of the last digit. Returns false if the digits can't be proven right.
+ */
+bool digit_gen(diy_fp low, diy_fp w, diy_fp high, char *buffer, int &length, int &kappa)
+{
+  // The scaled boundaries are within one unit of the exact ones
+  uint64_t unit = 1;
+  uint64_t too_low = low.f - unit, too_high = high.f + unit;
+  uint64_t unsafe_interval = too_high - too_low;
+  int shift = -w.e;
+  uint64_t one = uint64_t(1) << shift;
+  uint32_t integrals = static_cast<uint32_t>(too_high >> shift);
+  uint64_t fractionals = too_high & (one - 1);
+
+  uint32_t divisor = 1;
+  kappa = 0;
+  while (kappa < 10 && divisor <= integrals / 10) {
+    divisor *= 10;
+    ++kappa;
+  }
+  ++kappa;
+
+  length = 0;
+  while (kappa > 0) {
+    buffer[length++] = static_cast<char>('0' + integrals / divisor);
+    integrals %= divisor;
+    --kappa;
+    uint64_t rest = (static_cast<uint64_t>(integrals) << shift) + fractionals;
+    if (rest < unsafe_interval) {
+      return round_weed(buffer, length, too_high - w.f, unsafe_interval, rest,
+                        static_cast<uint64_t>(divisor) << shift, unit);
+    }
+    divisor /= 10;
+  }
+
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    buffer[length++] = static_cast<char>('0' + (fractionals >> shift));
+    fractionals &= one - 1;
+    --kappa;
+    if (fractionals < unsafe_interval) {
+      return round_weed(buffer, length, (too_high - w.f) * unit, unsafe_interval, fractionals, one, unit);
+    }
+  }
+}
+
+/**
+ * Finds the shortest digits of a positive `value` which read back as it,
+ * the closest to it if there are several, like Python's repr. `buffer` gets
+ * the digits, `length` their number and `exponent` the power of ten they
+ * are multiplied by.
+ */
+template <typename T>
+void shortest_digits(T value, char *buffer, int &length, int &exponent)
+{
+  diy_fp w, minus, plus;
+  boundaries(value, w, minus, plus);
+  const cached_power &c = find_cached_power(w.e);
+  diy_fp ten_mk = make_diy_fp(c.f, c.e);
+  int kappa;
+  if (digit_gen(multiply(minus, ten_mk), multiply(w, ten_mk), multiply(plus, ten_mk), buffer, length, kappa)) {
+    exponent = kappa - c.k;
+    return;
+  }
+
+  // Search for the fewest correctly rounded digits which read back, as
+  // integer digits and an exponent, which are read the same in any locale.
+  // For normal numbers, a value that reads back from its `digits10` digits
+  // is written shortest by them, since decimals of that many digits are
+  // further apart than the values of the type.
+  int precision = std::numeric_limits<T>::digits10;
+  if (value < std::numeric_limits<T>::min()) {
+    // Subnormals have fewer digits, so search from the shortest
+    precision = 1;
+  }
+  char text[40], digits[40];
+  for (;; ++precision) {
+    snprintf(text, sizeof(text), "%.*e", precision - 1, static_cast<double>(value));
+    const char *e = strchr(text, 'e');
+    length = 0;
+    for (const char *p = text; p != e; ++p) {
+      if (*p >= '0' && *p <= '9') {
+        buffer[length++] = *p;
+      }
+    }
+    exponent = atoi(e + 1) - (length - 1);
+    snprintf(digits, sizeof(digits), "%.*se%d", length, buffer, exponent);
+    T parsed = std::is_same<T, float>::value ? strtof(digits, NULL) : strtod(digits, NULL);
+    if (parsed == value || precision >= std::numeric_limits<T>::max_digits10) {
+      break;
+    }
+  }
+  while (length > 1 && buffer[length - 1] == '0') {
+    --length;
+    ++exponent;
+  }
+}
+
+/**
+ * Appends the shortest decimal text which reads back as `value`, formatted
+ * like Python's repr, e.g. 0.1, 100.0 or 1e+16.
+ */
+template <typename T>
+void append_float(T value, std::string &out)
+{
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  if (std::signbit(value)) {
+    out += '-';
+    value = -value;
+  }
+  if (value == 0) {
+    out += "0.0";
+    return;
+  }
+
+  char buffer[24];
+  int length, exponent;
+  shortest_digits(value, buffer, length, exponent);
+
+  // The position of the decimal point relative to the first digit
+  int point = length + exponent;
+  if (point < -3 || point > 16) {
+    out += buffer[0];
+    if (length > 1) {
+      out += '.';
+      out.append(buffer + 1, length - 1);
+    }
+    out += (point > 0) ? "e+" : "e-";
+    int e = (point > 0) ? point - 1 : 1 - point;
+    if (e < 10) {
+      out += '0';
+    }
+    append_unsigned(static_cast<unsigned>(e), out);
+  }
+  else if (point <= 0) {
+    out += "0.";
+    out.append(-point, '0');
+    out.append(buffer, length);
+  }
+  else if (point >= length) {
+    out.append(buffer, length);
+    out.append(point - length, '0');
+    out += ".0";
+  }
+  else {
+    out.append(buffer, point);
+    out += '.';
+    out.append(buffer + point, length - point);
+  }
+}
+
+const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * Appends `s` as a JSON string, escaping the quotes, the backslashes and
+ * the control characters. Other characters are written as UTF-8.
+ */
+void append_string(const char *begin, const char *end, std::string &out)
+{
+  out += '"';
+  const char *run = begin;
+  for (const char *p = begin; p != end; ++p) {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out.append(run, p);
+    run = p + 1;
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    default: {
+      char escape[6] = {'\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xF]};
+      out.append(escape, sizeof(escape));
+    }
+    }
+  }
+  out.append(run, end);
+  out += '"';
+}
+
+/**
+ * Writes the JSON text of values, given their type, arrmeta and data.
+ */
+class formatter {
+  std::string &m_out;
+  // The field names of the structs, already formatted as JSON strings
+  map<const ndt::base_type *, vector<std::string>> m_field_names;
+
+  const vector<std::string> &field_names(const ndt::struct_type *st)
+  {
+    vector<std::string> &names = m_field_names[st];
+    if (names.empty()) {
+      for (intptr_t i = 0; i < st->get_field_count(); ++i) {
+        const dynd::string &name = st->get_field_name(i);
+        std::string s;
+        append_string(name.begin(), name.end(), s);
+        s += ':';
+        names.push_back(s);
+      }
+    }
+
+    return names;
+  }
+
+  bool option_is_na(const ndt::type &value_tp, const char *data)
+  {
+    field_kind kind;
+    if (!field_kind_of(value_tp.get_id(), kind)) {
+      stringstream ss;
+      ss << "cannot format an option of type " << value_tp << " as JSON";
+      throw type_error(ss.str());
+    }
+
+    return is_na(kind, data);
+  }
+
+  /**
+   * Finds the size and the elements of the outermost dimension, like
+   * dim_elements, raising an error if there is none.
+   */
+  void dim(const ndt::type &tp, const char *arrmeta, const char *&data, intptr_t &size, intptr_t &stride,
+           const char *&el_arrmeta)
+  {
+    if (!dim_elements(tp, arrmeta, data, size, stride, el_arrmeta)) {
+      stringstream ss;
+      ss << "cannot format the rows of type " << tp << " as JSON, it has no fixed or var outermost dimension";
+      throw type_error(ss.str());
+    }
+  }
+
+public:
+  formatter(std::string &out) : m_out(out) {}
+
+  /**
+   * Writes the elements [begin, end) of a dimension, each followed by
+   * `separator`.
+   */
+  void rows(const ndt::type &tp, const char *arrmeta, const char *data, intptr_t begin, intptr_t end,
+            const std::string &separator)
+  {
+    intptr_t size, stride;
+    const char *el_arrmeta;
+    dim(tp, arrmeta, data, size, stride, el_arrmeta);
+    if (begin < 0 || end > size || begin > end) {
+      stringstream ss;
+      ss << "the rows [" << begin << ", " << end << ") are out of bounds for a dimension of size " << size;
+      throw invalid_argument(ss.str());
+    }
+
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    for (intptr_t i = begin; i < end; ++i) {
+      value(el_tp, el_arrmeta, data + i * stride);
+      m_out += separator;
+    }
+  }
+
+  void value(const ndt::type &tp, const char *arrmeta, const char *data)
+  {
+    switch (tp.get_id()) {
+    case bool_id:
+      m_out += (*data != 0) ? "true" : "false";
+      break;
+    case int8_id:
+      append_signed(*reinterpret_cast<const int8_t *>(data), m_out);
+      break;
+    case int16_id:
+      append_signed(*reinterpret_cast<const int16_t *>(data), m_out);
+      break;
+    case int32_id:
+      append_signed(*reinterpret_cast<const int32_t *>(data), m_out);
+      break;
+    case int64_id:
+      append_signed(*reinterpret_cast<const int64_t *>(data), m_out);
+      break;
+    case uint8_id:
+      append_unsigned(*reinterpret_cast<const uint8_t *>(data), m_out);
+      break;
+    case uint16_id:
+      append_unsigned(*reinterpret_cast<const uint16_t *>(data), m_out);
+      break;
+    case uint32_id:
+      append_unsigned(*reinterpret_cast<const uint32_t *>(data), m_out);
+      break;
+    case uint64_id:
+      append_unsigned(*reinterpret_cast<const uint64_t *>(data), m_out);
+      break;
+    case float32_id:
+      append_float(*reinterpret_cast<const float *>(data), m_out);
+      break;
+    case float64_id:
+      append_float(*reinterpret_cast<const double *>(data), m_out);
+      break;
+    case string_id: {
+      const dynd::string *s = reinterpret_cast<const dynd::string *>(data);
+      append_string(s->begin(), s->end(), m_out);
+      break;
+    }
+    case option_id: {
+      const ndt::type &value_tp = tp.extended<ndt::option_type>()->get_value_type();
+      if (option_is_na(value_tp, data)) {
+        m_out += "null";
+      }
+      else {
+        value(value_tp, arrmeta, data);
+      }
+      break;
+    }
+    case fixed_dim_id:
+    case var_dim_id: {
+      intptr_t size, stride;
+      const char *el_arrmeta;
+      dim(tp, arrmeta, data, size, stride, el_arrmeta);
+      const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+      m_out += '[';
+      for (intptr_t i = 0; i < size; ++i) {
+        if (i != 0) {
+          m_out += ',';
+        }
+        value(el_tp, el_arrmeta, data + i * stride);
+      }
+      m_out += ']';
+      break;
+    }
+    case struct_id:
+    case tuple_id: {
+      const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+      const uintptr_t *data_offsets = tt->get_data_offsets(arrmeta);
+      const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+      bool is_struct = (tp.get_id() == struct_id);
+      const vector<std::string> *names = is_struct ? &field_names(tp.extended<ndt::struct_type>()) : NULL;
+      m_out += is_struct ? '{' : '[';
+      for (intptr_t i = 0; i < tt->get_field_count(); ++i) {
+        if (i != 0) {
+          m_out += ',';
+        }
+        if (is_struct) {
+          m_out += (*names)[i];
+        }
+        value(tt->get_field_type(i), arrmeta + arrmeta_offsets[i], data + data_offsets[i]);
+      }
+      m_out += is_struct ? '}' : ']';
+      break;
+    }
+    default: {
+      stringstream ss;
+      ss << "cannot format a value of type " << tp << " as JSON";
+      throw type_error(ss.str());
+    }
+    }
+  }
+};
+
+} // anonymous namespace
+
+void pydynd::format_json(const dynd::nd::array &a, std::string &out)
+{
+  formatter(out).value(a.get_type(), a.get()->metadata(), a.cdata());
+}
+
+void pydynd::format_json_rows(const dynd::nd::array &a, intptr_t begin, intptr_t end, const std::string &separator,
+                              std::string &out)
+{
+  formatter(out).rows(a.get_type(), a.get()->metadata(), a.cdata(), begin, end, separator);
+}
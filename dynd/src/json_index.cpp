@@ -0,0 +1,221 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cstring>
+#include <stdexcept>
+
+#include "cpu_features.hpp"
+#include "json_index.hpp"
+
+using namespace std;
+
+namespace {
+
+/**
+ * The bit masks classifying one 64 byte block, bit i for byte i.
+ */
+struct block_masks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t structural;
+};
+
+void classify_scalar(const char *block, block_masks &m)
+{
+  m.quote = m.backslash = m.structural = 0;
+  for (int i = 0; i < 64; ++i) {
+    uint64_t bit = uint64_t(1) << i;
+    switch (block[i]) {
+    case '"':
+      m.quote |= bit;
+      break;
+    case '\\':
+      m.backslash |= bit;
+      break;
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      m.structural |= bit;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+#if PYDYND_X86
+
+// '{' and '[', like '}' and ']', only differ in the 0x20 bit, so each pair
+// is matched by one comparison after setting that bit.
+
+void classify_sse2(const char *block, block_masks &m)
+{
+  const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+  const __m128i open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}');
+  const __m128i colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(',');
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+
+  m.quote = m.backslash = m.structural = 0;
+  for (int i = 0; i < 4; ++i) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+    __m128i folded = _mm_or_si128(v, case_bit);
+    __m128i s = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+    m.quote |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << (16 * i);
+    m.backslash |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << (16 * i);
+    m.structural |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(s))) << (16 * i);
+  }
+}
+
+PYDYND_TARGET_AVX2 void classify_avx2(const char *block, block_masks &m)
+{
+  const __m256i quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\');
+  const __m256i open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}');
+  const __m256i colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+
+  m.quote = m.backslash = m.structural = 0;
+  for (int i = 0; i < 2; ++i) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32 * i));
+    __m256i folded = _mm256_or_si256(v, case_bit);
+    __m256i s = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+    m.quote |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << (32 * i);
+    m.backslash |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash))))
+                   << (32 * i);
+    m.structural |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(s))) << (32 * i);
+  }
+}
+
+#endif
+
+typedef void (*classify_function)(const char *block, block_masks &m);
+
+struct backend {
+  const char *name;
+  classify_function classify;
+};
+
+backend detect_backend()
+{
+#if PYDYND_X86
+  if (pydynd::cpu_has_avx2()) {
+    return backend{"avx2", &classify_avx2};
+  }
+  // SSE2 is part of every x86-64 CPU
+  return backend{"sse2", &classify_sse2};
+#else
+  return backend{"scalar", &classify_scalar};
+#endif
+}
+
+backend &current_backend()
+{
+  static backend b = detect_backend();
+  return b;
+}
+
+/**
+ * The bits of the bytes following an odd length run of backslashes, i.e.
+ * the escaped characters. `prev_odd` carries a run ending at the last byte
+ * of the previous block.
+ */
+uint64_t escaped_bits(uint64_t backslash, uint64_t &prev_odd)
+{
+  const uint64_t even_bits = 0x5555555555555555ULL;
+  const uint64_t odd_bits = ~even_bits;
+
+  uint64_t start_edges = backslash & ~(backslash << 1);
+  // A run continuing from the previous block starts at an odd position
+  uint64_t even_start_mask = even_bits ^ prev_odd;
+  uint64_t even_starts = start_edges & even_start_mask;
+  uint64_t odd_starts = start_edges & ~even_start_mask;
+
+  uint64_t even_carries = backslash + even_starts;
+  uint64_t odd_carries = backslash + odd_starts;
+  bool ends_odd = odd_carries < backslash;
+  odd_carries |= prev_odd;
+  prev_odd = ends_odd ? 1 : 0;
+
+  uint64_t even_carry_ends = even_carries & ~backslash;
+  uint64_t odd_carry_ends = odd_carries & ~backslash;
+  return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+}
+
+/**
+ * Bit i of the result is the parity of bits 0 through i of `x`.
+ */
+uint64_t prefix_xor(uint64_t x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+} // anonymous namespace
+
+void pydynd::json_structural_index(const char *begin, const char *end, std::vector<uint32_t> &out)
+{
+  size_t size = end - begin;
+  if (size > UINT32_MAX) {
+    throw invalid_argument("cannot index more than 4 GB of JSON at once");
+  }
+
+  classify_function classify = current_backend().classify;
+  uint64_t prev_odd = 0, prev_in_string = 0;
+  char tail[64];
+  for (size_t offset = 0; offset < size; offset += 64) {
+    const char *block = begin + offset;
+    if (size - offset < 64) {
+      // Pad the last block with spaces, which are never structural
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, block, size - offset);
+      block = tail;
+    }
+
+    block_masks m;
+    classify(block, m);
+    uint64_t quote = m.quote & ~escaped_bits(m.backslash, prev_odd);
+    // Set from each opening quote up to, but excluding, its closing quote
+    uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+    prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+    uint64_t bits = (m.structural & ~in_string) | quote;
+    while (bits != 0) {
+      out.push_back(static_cast<uint32_t>(offset + pydynd::count_trailing_zeros(bits)));
+      bits &= bits - 1;
+    }
+  }
+}
+
+const char *pydynd::json_structural_index_backend() { return current_backend().name; }
+
+void pydynd::set_json_structural_index_backend(const std::string &name)
+{
+  if (name.empty()) {
+    current_backend() = detect_backend();
+  }
+  else if (name == "scalar") {
+    current_backend() = backend{"scalar", &classify_scalar};
+  }
+#if PYDYND_X86
+  else if (name == "sse2") {
+    current_backend() = backend{"sse2", &classify_sse2};
+  }
+  else if (name == "avx2" && pydynd::cpu_has_avx2()) {
+    current_backend() = backend{"avx2", &classify_avx2};
+  }
+#endif
+  else {
+    throw invalid_argument("the JSON structural index backend '" + name + "' is not available");
+  }
+}
@@ -0,0 +1,624 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dynd/irange.hpp>
+#include <dynd/json_parser.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+
+#include "json_index.hpp"
+#include "json_lines.hpp"
+#include "json_string.hpp"
+#include "parallel_for.hpp"
+#include "record_fields.hpp"
+#include "utf8.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+
+bool is_blank(const char *begin, const char *end)
+{
+  for (; begin != end; ++begin) {
+    if (*begin != ' ' && *begin != '\t' && *begin != '\r') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+const char *skip_space(const char *begin, const char *end)
+{
+  while (begin != end && is_space(*begin)) {
+    ++begin;
+  }
+
+  return begin;
+}
+
+bool only_space(const char *begin, const char *end) { return skip_space(begin, end) == end; }
+
+const char *skip_digits(const char *begin, const char *end)
+{
+  while (begin != end && *begin >= '0' && *begin <= '9') {
+    ++begin;
+  }
+
+  return begin;
+}
+
+/**
+ * Whether [begin, end) is a number in the JSON grammar. strtod also
+ * accepts forms like "inf", "0x10", "+1" or "1.", which JSON doesn't.
+ */
+bool is_json_number(const char *begin, const char *end)
+{
+  if (begin != end && *begin == '-') {
+    ++begin;
+  }
+  const char *p = skip_digits(begin, end);
+  if (p == begin || (*begin == '0' && p - begin > 1)) {
+    return false;
+  }
+  if (p != end && *p == '.') {
+    const char *fraction = p + 1;
+    p = skip_digits(fraction, end);
+    if (p == fraction) {
+      return false;
+    }
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != end && (*p == '+' || *p == '-')) {
+      ++p;
+    }
+    const char *exponent = p;
+    p = skip_digits(exponent, end);
+    if (p == exponent) {
+      return false;
+    }
+  }
+
+  return p == end;
+}
+
+bool parse_double(const char *begin, const char *end, double &out)
+{
+  if (!is_json_number(begin, end)) {
+    return false;
+  }
+  char *parsed_end;
+  out = strtod(begin, &parsed_end);
+  return parsed_end == end;
+}
+
+/**
+ * Stores the scalar JSON token in [begin, end) into a field.
+ */
+bool store_scalar(const field_plan &f, const char *begin, const char *end, char *dst)
+{
+  if (end - begin == 4 && memcmp(begin, "null", 4) == 0) {
+    return f.option && store_na(f, dst);
+  }
+
+  switch (f.kind) {
+  case bool_field:
+    if (end - begin == 4 && memcmp(begin, "true", 4) == 0) {
+      *dst = 1;
+      return true;
+    }
+    if (end - begin == 5 && memcmp(begin, "false", 5) == 0) {
+      *dst = 0;
+      return true;
+    }
+    return false;
+  case int8_field:
+    return parse_signed<int8_t>(begin, end, dst);
+  case int16_field:
+    return parse_signed<int16_t>(begin, end, dst);
+  case int32_field:
+    return parse_signed<int32_t>(begin, end, dst);
+  case int64_field:
+    return parse_signed<int64_t>(begin, end, dst);
+  case uint8_field:
+    return parse_unsigned<uint8_t>(begin, end, dst);
+  case uint16_field:
+    return parse_unsigned<uint16_t>(begin, end, dst);
+  case uint32_field:
+    return parse_unsigned<uint32_t>(begin, end, dst);
+  case uint64_field:
+    return parse_unsigned<uint64_t>(begin, end, dst);
+  case float32_field: {
+    double value;
+    if (!parse_double(begin, end, value)) {
+      return false;
+    }
+    // dynd's parser raises an overflow error for values beyond float32,
+    // so they are left to it
+    if (value > numeric_limits<float>::max() || value < -numeric_limits<float>::max()) {
+      return false;
+    }
+    float result = static_cast<float>(value);
+    memcpy(dst, &result, sizeof(float));
+    return true;
+  }
+  case float64_field: {
+    double value;
+    if (!parse_double(begin, end, value)) {
+      return false;
+    }
+    memcpy(dst, &value, sizeof(double));
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+/**
+ * Checks the contents [begin, end) of a JSON string, the way dynd's parser
+ * does, and points them at their unescaped form in `scratch` if they have
+ * escapes.
+ */
+bool decode_string(const char *&begin, const char *&end, std::string &scratch)
+{
+  bool escaped = false;
+  for (const char *p = begin; p != end; ++p) {
+    if (static_cast<unsigned char>(*p) < 0x20) {
+      return false;
+    }
+    escaped |= (*p == '\\');
+  }
+
+  if (escaped) {
+    if (!json_unescape(begin, end, scratch)) {
+      return false;
+    }
+    begin = scratch.data();
+    end = begin + scratch.size();
+  }
+  // Invalid UTF-8 is left to dynd's parser, which raises the error
+  return utf8_length(begin, end) >= 0;
+}
+
+/**
+ * Stores the contents [begin, end) of a JSON string into a string field.
+ */
+bool store_string(const field_plan &f, const char *begin, const char *end, char *dst, std::string &scratch)
+{
+  if (f.kind != string_field || !decode_string(begin, end, scratch)) {
+    return false;
+  }
+  reinterpret_cast<dynd::bytes *>(dst)->assign(begin, end - begin);
+
+  return true;
+}
+
+bool is_json_scalar(const char *begin, const char *end)
+{
+  size_t size = end - begin;
+  return (size == 4 && (memcmp(begin, "null", 4) == 0 || memcmp(begin, "true", 4) == 0)) ||
+         (size == 5 && memcmp(begin, "false", 5) == 0) || is_json_number(begin, end);
+}
+
+/**
+ * Checks the JSON value starting at `value` the way dynd's parser does,
+ * through the structural index at `pos`, and skips it. `pos` is advanced
+ * past its structural characters, and `value_end` set to its end. Values
+ * nested more than `max_depth` deep aren't checked, and make it return
+ * false.
+ */
+bool skip_value(const char *text, const uint32_t *&pos, const uint32_t *pos_end, const char *value,
+                const char *row_end, const char *&value_end, std::string &scratch, int max_depth)
+{
+  if (value == row_end) {
+    return false;
+  }
+  if (*value == '"') {
+    if (pos_end - pos < 2 || text + pos[0] != value || text + pos[1] >= row_end) {
+      return false;
+    }
+    const char *begin = value + 1, *end = text + pos[1];
+    if (!decode_string(begin, end, scratch)) {
+      return false;
+    }
+    value_end = text + pos[1] + 1;
+    pos += 2;
+    return true;
+  }
+  if (*value == '{' || *value == '[') {
+    if (max_depth == 0 || pos == pos_end || text + *pos != value) {
+      return false;
+    }
+    char close = (*value == '{') ? '}' : ']';
+    const char *prev = text + *pos++;
+    if (pos != pos_end && text[*pos] == close && only_space(prev + 1, text + *pos)) {
+      value_end = text + *pos++ + 1;
+      return true;
+    }
+    for (;;) {
+      if (close == '}') {
+        // "key" :
+        if (pos_end - pos < 3 || text[pos[0]] != '"' || text[pos[1]] != '"' || text[pos[2]] != ':' ||
+            !only_space(prev + 1, text + pos[0]) || !only_space(text + pos[1] + 1, text + pos[2])) {
+          return false;
+        }
+        const char *key = text + pos[0] + 1, *key_end = text + pos[1];
+        if (!decode_string(key, key_end, scratch)) {
+          return false;
+        }
+        prev = text + pos[2];
+        pos += 3;
+      }
+      const char *element_end;
+      if (!skip_value(text, pos, pos_end, skip_space(prev + 1, row_end), row_end, element_end, scratch,
+                      max_depth - 1)) {
+        return false;
+      }
+      if (pos == pos_end || text + *pos >= row_end || !only_space(element_end, text + *pos)) {
+        return false;
+      }
+      prev = text + *pos++;
+      if (*prev == close) {
+        value_end = prev + 1;
+        return true;
+      }
+      if (*prev != ',') {
+        return false;
+      }
+    }
+  }
+
+  // A number or a literal, which ends at the next structural character
+  if (pos == pos_end || text + *pos >= row_end) {
+    return false;
+  }
+  const char *token_end = text + *pos;
+  while (token_end != value && is_space(token_end[-1])) {
+    --token_end;
+  }
+  value_end = token_end;
+  return is_json_scalar(value, token_end);
+}
+
+/**
+ * Parses rows holding one JSON object each into a struct with fields of
+ * scalar types and strings, using the structural index of the rows.
+ *
+ * Anything else, including every kind of malformed input, makes `parse`
+ * return false, and the caller then parses the rows again with dynd's
+ * parser, which decides whether they are valid and reports the errors.
+ */
+class record_parser {
+  // Deeper values of fields which aren't in the struct are left to dynd's parser
+  static const int max_skip_depth = 64;
+
+  vector<field_plan> m_fields;
+
+  intptr_t find_field(const char *name, size_t size, size_t &guess) const
+  {
+    // The fields usually appear in the order of the struct
+    size_t nfields = m_fields.size();
+    for (size_t i = 0; i < nfields; ++i) {
+      size_t j = (guess + i) % nfields;
+      const std::string &field_name = m_fields[j].name;
+      if (field_name.size() == size && memcmp(field_name.data(), name, size) == 0) {
+        guess = j + 1;
+        return j;
+      }
+    }
+
+    return -1;
+  }
+
+public:
+  record_parser(const vector<field_plan> &fields) : m_fields(fields) {}
+
+  /**
+   * Parses the row [row_begin, row_end) into `dst`. `pos` points at the
+   * index entry of the first structural character of the row, offset from
+   * `text`, and is advanced past the row.
+   */
+  bool parse(const char *text, const uint32_t *&pos, const uint32_t *pos_end, const char *row_begin,
+             const char *row_end, char *dst, vector<char> &seen, std::string &scratch) const
+  {
+    const char *p = skip_space(row_begin, row_end);
+    if (p == row_end || *p != '{' || pos == pos_end || text + *pos != p) {
+      return false;
+    }
+    ++pos;
+
+    seen.assign(m_fields.size(), 0);
+    size_t guess = 0;
+    const char *prev = p;
+    if (pos != pos_end && text[*pos] == '}' && only_space(prev + 1, text + *pos)) {
+      prev = text + *pos++;
+    }
+    else {
+      for (;;) {
+        // "key" :
+        if (pos_end - pos < 3 || text[pos[0]] != '"' || text[pos[1]] != '"' || text[pos[2]] != ':' ||
+            !only_space(prev + 1, text + pos[0]) || !only_space(text + pos[1] + 1, text + pos[2])) {
+          return false;
+        }
+        const char *key = text + pos[0] + 1;
+        size_t key_size = pos[1] - pos[0] - 1;
+        if (memchr(key, '\\', key_size) != NULL) {
+          return false;
+        }
+        const char *colon = text + pos[2];
+        pos += 3;
+        intptr_t i = find_field(key, key_size, guess);
+        if (i >= 0 && seen[i]) {
+          return false;
+        }
+
+        // The value, followed by ',' or '}'
+        const char *value = skip_space(colon + 1, row_end);
+        const char *value_end;
+        if (i < 0) {
+          // Fields which aren't in the struct are checked like the others, and skipped
+          const char *key_end = key + key_size;
+          if (!decode_string(key, key_end, scratch) ||
+              !skip_value(text, pos, pos_end, value, row_end, value_end, scratch, max_skip_depth)) {
+            return false;
+          }
+        }
+        else if (value == row_end || *value == '{' || *value == '[') {
+          return false;
+        }
+        else if (*value == '"') {
+          if (pos_end - pos < 2 || text + pos[0] != value) {
+            return false;
+          }
+          value_end = text + pos[1] + 1;
+          if (!store_string(m_fields[i], value + 1, value_end - 1, dst + m_fields[i].offset, scratch)) {
+            return false;
+          }
+          pos += 2;
+        }
+        else {
+          if (pos == pos_end) {
+            return false;
+          }
+          value_end = text + *pos;
+          const char *token_end = value_end;
+          while (token_end != value && is_space(token_end[-1])) {
+            --token_end;
+          }
+          if (!store_scalar(m_fields[i], value, token_end, dst + m_fields[i].offset)) {
+            return false;
+          }
+        }
+        if (i >= 0) {
+          seen[i] = 1;
+        }
+
+        if (pos == pos_end || !only_space(value_end, text + *pos)) {
+          return false;
+        }
+        prev = text + *pos++;
+        if (*prev == '}') {
+          break;
+        }
+        if (*prev != ',') {
+          return false;
+        }
+      }
+    }
+
+    if (!only_space(prev + 1, row_end)) {
+      return false;
+    }
+    for (size_t i = 0; i < m_fields.size(); ++i) {
+      if (!seen[i] && !(m_fields[i].option && store_na(m_fields[i], dst + m_fields[i].offset))) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+/**
+ * Appends the [begin, end) ranges of the lines in [begin, end) which
+ * aren't blank to `rows`.
+ */
+void split_rows(const char *begin, const char *end, vector<pair<const char *, const char *>> &rows)
+{
+  while (begin < end) {
+    const char *line_end = reinterpret_cast<const char *>(memchr(begin, '\n', end - begin));
+    if (line_end == NULL) {
+      line_end = end;
+    }
+    if (!is_blank(begin, line_end)) {
+      rows.push_back(make_pair(begin, line_end));
+    }
+    begin = line_end + 1;
+  }
+}
+
+/**
+ * Parses the rows into `result`, an array of type "N * tp" with struct
+ * rows, through the structural index. The rows are split into blocks
+ * parsed on up to `nthreads` threads, each indexing its own span of the
+ * text. Returns false if any row isn't handled by the record parser.
+ */
+bool parse_records(const nd::array &result, const vector<pair<const char *, const char *>> &rows, intptr_t nthreads)
+{
+  const char *arrmeta = result.get()->metadata();
+  const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+  const ndt::type &el_tp = result.get_type().extended<ndt::base_dim_type>()->get_element_type();
+  vector<field_plan> fields;
+  if (!make_record_plan(el_tp, arrmeta + sizeof(fixed_dim_type_arrmeta), fields)) {
+    return false;
+  }
+  for (const field_plan &f : fields) {
+    if (f.option && f.kind == string_field) {
+      return false;
+    }
+  }
+
+  record_parser parser(fields);
+  intptr_t nrows = rows.size();
+  intptr_t nblocks = nthreads > 1 ? min(nrows, 4 * nthreads) : 1;
+  vector<char> ok(nblocks, 0);
+  char *data = result.data();
+  parallel_for(nblocks, nthreads, [&](intptr_t block) {
+    intptr_t first = nrows * block / nblocks, last = nrows * (block + 1) / nblocks;
+    if (first == last) {
+      ok[block] = 1;
+      return;
+    }
+
+    const char *text = rows[first].first;
+    vector<uint32_t> index;
+    json_structural_index(text, rows[last - 1].second, index);
+    const uint32_t *pos = index.data(), *pos_end = pos + index.size();
+    vector<char> seen;
+    std::string scratch;
+    for (intptr_t i = first; i < last; ++i) {
+      if (!parser.parse(text, pos, pos_end, rows[i].first, rows[i].second, data + i * md->stride, seen, scratch)) {
+        return;
+      }
+    }
+    ok[block] = 1;
+  });
+
+  return find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+assign_error_mode errmode_from_string(const std::string &s)
+{
+  if (s == "nocheck") {
+    return assign_error_nocheck;
+  }
+  else if (s == "overflow") {
+    return assign_error_overflow;
+  }
+  else if (s == "fractional") {
+    return assign_error_fractional;
+  }
+  else if (s == "inexact") {
+    return assign_error_inexact;
+  }
+  else if (s == "default") {
+    return assign_error_default;
+  }
+
+  throw invalid_argument("invalid errmode '" + s + "', expected 'nocheck', 'overflow', 'fractional', 'inexact' or "
+                         "'default'");
+}
+
+} // anonymous namespace
+
+dynd::eval::eval_context pydynd::eval_context_from_pyobject(PyObject *ectx_obj)
+{
+  eval::eval_context ectx = eval::default_eval_context;
+  if (ectx_obj == NULL || ectx_obj == Py_None) {
+    return ectx;
+  }
+  if (!PyDict_Check(ectx_obj)) {
+    throw type_error("ectx must be None or a dict of evaluation context settings");
+  }
+
+  PyObject *key, *value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(ectx_obj, &pos, &key, &value)) {
+    std::string name = pystring_as_string(key);
+    if (name == "errmode") {
+      ectx.errmode = errmode_from_string(pystring_as_string(value));
+    }
+    else {
+      throw invalid_argument("unknown evaluation context setting '" + name + "'");
+    }
+  }
+
+  return ectx;
+}
+
+dynd::nd::array pydynd::parse_json_lines(const dynd::ndt::type &tp, const char *begin, const char *end,
+                                         const dynd::eval::eval_context *ectx, intptr_t nthreads)
+{
+  vector<pair<const char *, const char *>> rows;
+  split_rows(begin, end, rows);
+  intptr_t nrows = rows.size();
+
+  // Rows of flat records are parsed directly into the result. The checks
+  // of the inexact error mode are left to dynd's parser, and the offsets
+  // of the structural index are 32-bit.
+  if (tp.get_id() == struct_id && ectx->errmode != assign_error_inexact &&
+      static_cast<uint64_t>(end - begin) <= numeric_limits<uint32_t>::max()) {
+    nd::array result = nd::empty(ndt::make_fixed_dim(nrows, tp));
+    if (parse_records(result, rows, nthreads)) {
+      return result;
+    }
+  }
+
+  // Otherwise, or if any row isn't a flat record, join the rows into one
+  // JSON list, so the whole chunk is parsed by a single call
+  std::string json;
+  json.reserve((end - begin) + 2);
+  json += '[';
+  for (intptr_t i = 0; i < nrows; ++i) {
+    if (i != 0) {
+      json += ',';
+    }
+    json.append(rows[i].first, rows[i].second);
+  }
+  json += ']';
+
+  return parse_json(ndt::make_fixed_dim(nrows, tp), json.data(), json.data() + json.size(), ectx);
+}
+
+pydynd::json_lines_builder::json_lines_builder(const ndt::type &tp) : m_tp(tp), m_size(0) {}
+
+void pydynd::json_lines_builder::append(const nd::array &chunk)
+{
+  intptr_t n = chunk.get_dim_size();
+  if (n == 0) {
+    return;
+  }
+
+  intptr_t capacity = m_buffer.is_null() ? 0 : m_buffer.get_dim_size();
+  if (m_size + n > capacity) {
+    intptr_t new_capacity = max(2 * capacity, m_size + n);
+    nd::array buffer = nd::empty(ndt::make_fixed_dim(new_capacity, m_tp));
+    if (m_size > 0) {
+      buffer(irange(0, m_size)).assign(m_buffer(irange(0, m_size)));
+    }
+    m_buffer = buffer;
+  }
+
+  m_buffer(irange(m_size, m_size + n)).assign(chunk);
+  m_size += n;
+}
+
+dynd::nd::array pydynd::json_lines_builder::get() const
+{
+  if (m_buffer.is_null()) {
+    return nd::empty(ndt::make_fixed_dim(0, m_tp));
+  }
+
+  return m_buffer(irange(0, m_size));
+}
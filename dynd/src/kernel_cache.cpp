@@ -0,0 +1,275 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <dynd/exceptions.hpp>
+#include <dynd/kernels/kernel_builder.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "kernel_cache.hpp"
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+// Prepared kernels take at most this many arguments, which keeps their
+// data pointers on the stack.
+const size_t max_prepared_narg = 8;
+
+bool arrmeta_equal(const nd::array &a, const std::string &arrmeta)
+{
+  return arrmeta.empty() || memcmp(a.get()->metadata(), arrmeta.data(), arrmeta.size()) == 0;
+}
+
+/**
+ * Copies the arrmeta of `a` if it isn't null, or default constructs the
+ * arrmeta for `tp` otherwise.
+ */
+std::string copy_arrmeta(const ndt::type &tp, const nd::array &a)
+{
+  if (!pydynd::has_pod_arrmeta(tp)) {
+    stringstream ss;
+    ss << "cannot prepare a callable for an argument of type " << tp
+       << ", only builtin types and fixed dimensions of them are supported";
+    throw type_error(ss.str());
+  }
+
+  std::string arrmeta(tp.get_arrmeta_size(), '\0');
+  if (!a.is_null()) {
+    if (a.get_type() != tp) {
+      stringstream ss;
+      ss << "cannot prepare a callable with an array of type " << a.get_type() << " for type " << tp;
+      throw type_error(ss.str());
+    }
+    memcpy(&arrmeta[0], a.get()->metadata(), arrmeta.size());
+  }
+  else if (!arrmeta.empty()) {
+    tp.extended()->arrmeta_default_construct(&arrmeta[0], true);
+  }
+
+  return arrmeta;
+}
+
+} // anonymous namespace
+
+bool pydynd::has_pod_arrmeta(ndt::type tp)
+{
+  while (tp.get_id() == fixed_dim_id) {
+    tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+  }
+
+  return tp.is_builtin();
+}
+
+pydynd::prepared_call::prepared_call(const nd::callable &f, const vector<ndt::type> &src_tp,
+                                     const vector<nd::array> &src, const nd::array &dst)
+    : m_src_tp(src_tp)
+{
+  nd::base_callable *bc = f.get();
+  size_t narg = src_tp.size();
+  if (narg > max_prepared_narg) {
+    stringstream ss;
+    ss << "cannot prepare a callable for " << narg << " arguments, the limit is " << max_prepared_narg;
+    throw runtime_error(ss.str());
+  }
+  if (bc->get_arg_types().size() != narg) {
+    stringstream ss;
+    ss << "callable expected " << bc->get_arg_types().size() << " positional arguments, but received " << narg;
+    throw type_error(ss.str());
+  }
+
+  map<std::string, ndt::type> tp_vars;
+  const char *src_arrmeta[max_prepared_narg];
+  for (size_t i = 0; i < narg; ++i) {
+    if (!bc->get_arg_types()[i].match(src_tp[i], tp_vars)) {
+      stringstream ss;
+      ss << "parameter " << (i + 1) << " to callable does not match, expected " << bc->get_arg_types()[i]
+         << ", received " << src_tp[i];
+      throw type_error(ss.str());
+    }
+    m_src_arrmeta.push_back(copy_arrmeta(src_tp[i], i < src.size() ? src[i] : nd::array()));
+  }
+  for (size_t i = 0; i < narg; ++i) {
+    src_arrmeta[i] = m_src_arrmeta[i].data();
+  }
+
+  m_dst_tp = bc->resolve(bc, nullptr, m_cg, bc->get_ret_type(), narg, m_src_tp.data(), 0, nullptr, tp_vars);
+  if (!dst.is_null() && dst.get_type() != m_dst_tp) {
+    stringstream ss;
+    ss << "the output of the prepared callable has type " << m_dst_tp << ", but the provided output has type "
+       << dst.get_type();
+    throw type_error(ss.str());
+  }
+  m_dst_arrmeta = copy_arrmeta(m_dst_tp, dst);
+
+  m_kb.reset(new nd::kernel_builder(m_cg.get()));
+  (*m_kb)(kernel_request_single, nullptr, m_dst_arrmeta.data(), narg, src_arrmeta);
+}
+
+pydynd::prepared_call::~prepared_call() {}
+
+bool pydynd::prepared_call::matches(size_t narg, const nd::array *args) const
+{
+  if (narg != m_src_tp.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < narg; ++i) {
+    if (args[i].get_type() != m_src_tp[i] || !arrmeta_equal(args[i], m_src_arrmeta[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool pydynd::prepared_call::matches_dst(const nd::array &dst) const
+{
+  return dst.get_type() == m_dst_tp && arrmeta_equal(dst, m_dst_arrmeta);
+}
+
+void pydynd::prepared_call::single(char *dst, char *const *src) const { m_kb->get()->single(dst, src); }
+
+nd::array pydynd::prepared_call::operator()(size_t narg, const nd::array *args) const
+{
+  nd::array dst = nd::empty(m_dst_tp);
+  (*this)(dst, narg, args);
+
+  return dst;
+}
+
+void pydynd::prepared_call::operator()(const nd::array &dst, size_t narg, const nd::array *args) const
+{
+  if (!matches(narg, args)) {
+    stringstream ss;
+    ss << "the arguments don't have the types and strides the callable was prepared for, (";
+    for (size_t i = 0; i < m_src_tp.size(); ++i) {
+      ss << (i == 0 ? "" : ", ") << m_src_tp[i];
+    }
+    ss << ")";
+    throw type_error(ss.str());
+  }
+  if (!matches_dst(dst)) {
+    throw type_error("the output doesn't have the type and strides the callable was prepared for");
+  }
+
+  char *src_data[max_prepared_narg];
+  for (size_t i = 0; i < narg; ++i) {
+    src_data[i] = const_cast<char *>(args[i].cdata());
+  }
+  single(dst.data(), src_data);
+}
+
+struct pydynd::kernel_cache::entry {
+  prepared_call call;
+  // Set while the kernel runs, so a call that reenters the callable from
+  // inside it (e.g. through a Python function) doesn't share its state.
+  bool busy;
+
+  entry(const nd::callable &f, const vector<ndt::type> &src_tp, const vector<nd::array> &src)
+      : call(f, src_tp, src, nd::array()), busy(false)
+  {
+  }
+};
+
+pydynd::kernel_cache::kernel_cache() {}
+
+pydynd::kernel_cache::~kernel_cache() {}
+
+shared_ptr<pydynd::kernel_cache::entry> pydynd::kernel_cache::find(size_t narg, const nd::array *args) const
+{
+  for (const shared_ptr<entry> &e : m_entries) {
+    if (!e->busy && e->call.matches(narg, args)) {
+      return e;
+    }
+  }
+
+  return shared_ptr<entry>();
+}
+
+shared_ptr<pydynd::kernel_cache::entry> pydynd::kernel_cache::insert(const nd::callable &f, size_t narg,
+                                                                      const nd::array *args)
+{
+  if (narg > max_prepared_narg || !f.get()->get_kwd_types().empty()) {
+    return shared_ptr<entry>();
+  }
+
+  vector<ndt::type> src_tp(narg);
+  for (size_t i = 0; i < narg; ++i) {
+    src_tp[i] = args[i].get_type();
+    if (!has_pod_arrmeta(src_tp[i])) {
+      return shared_ptr<entry>();
+    }
+  }
+  if (std::find(m_uncached.begin(), m_uncached.end(), src_tp) != m_uncached.end()) {
+    return shared_ptr<entry>();
+  }
+
+  shared_ptr<entry> e;
+  try {
+    e = make_shared<entry>(f, src_tp, vector<nd::array>(args, args + narg));
+  }
+  catch (const dynd_exception &) {
+    // The types don't resolve, or resolve to a result without plain data
+    // arrmeta. The uncached call raises the error if there is one.
+    if (m_uncached.size() == max_size) {
+      m_uncached.erase(m_uncached.begin());
+    }
+    m_uncached.push_back(src_tp);
+    return shared_ptr<entry>();
+  }
+
+  if (m_entries.size() == max_size) {
+    m_entries.erase(m_entries.begin());
+  }
+  m_entries.push_back(e);
+
+  return e;
+}
+
+nd::array pydynd::kernel_cache::call(const nd::callable &f, size_t narg, const nd::array *args)
+{
+  shared_ptr<entry> e = find(narg, args);
+  if (!e) {
+    e = insert(f, narg, args);
+    if (!e) {
+      return f.call(narg, args, 0, nullptr);
+    }
+  }
+
+  // The entry is held by `e`, so it stays alive if a reentrant call
+  // evicts it from the cache.
+  e->busy = true;
+  try {
+    nd::array res = e->call(narg, args);
+    e->busy = false;
+    return res;
+  }
+  catch (...) {
+    e->busy = false;
+    throw;
+  }
+}
+
+void pydynd::enable_vectorcall(PyTypeObject *tp, Py_ssize_t offset)
+{
+#if PYDYND_HAVE_VECTORCALL
+  tp->tp_vectorcall_offset = offset;
+#if PY_VERSION_HEX >= 0x03090000
+  tp->tp_flags |= Py_TPFLAGS_HAVE_VECTORCALL;
+#else
+  tp->tp_flags |= _Py_TPFLAGS_HAVE_VECTORCALL;
+#endif
+  PyType_Modified(tp);
+#else
+  (void)tp;
+  (void)offset;
+#endif
+}
@@ -0,0 +1,845 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <dynd/memblock/external_memory_block.hpp>
+#include <dynd/shortvector.hpp>
+#include <dynd/types/base_dim_type.hpp>
+#include <dynd/types/bytes_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/struct_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+
+#include "array_functions.hpp"
+#include "memmap.hpp"
+
+using namespace std;
+using namespace dynd;
+
+namespace {
+
+/**
+ * A mapped region of a file, released by `unmap_function` when the
+ * external memory block owning it is freed.
+ */
+struct file_mapping {
+  void *addr;
+  size_t length;
+#if defined(_WIN32)
+  HANDLE mapping;
+#endif
+};
+
+void unmap_function(void *obj)
+{
+  file_mapping *fm = reinterpret_cast<file_mapping *>(obj);
+#if defined(_WIN32)
+  UnmapViewOfFile(fm->addr);
+  CloseHandle(fm->mapping);
+#else
+  munmap(fm->addr, fm->length);
+#endif
+  delete fm;
+}
+
+/**
+ * Raises an OSError for the current errno (or Windows error) and `path`.
+ */
+void raise_os_error(const std::string &path)
+{
+#if defined(_WIN32)
+  PyErr_SetExcFromWindowsErrWithFilename(PyExc_OSError, 0, path.c_str());
+#else
+  PyErr_SetFromErrnoWithFilename(PyExc_OSError, path.c_str());
+#endif
+  throw exception();
+}
+
+intptr_t page_size()
+{
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  // Mapping offsets must be aligned to the allocation granularity, not
+  // just to the page size
+  return info.dwAllocationGranularity;
+#else
+  return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/**
+ * Maps `length` bytes of the file at `path` from the page aligned
+ * `map_offset` on, as described by `mode`.
+ */
+file_mapping *map_file(const std::string &path, const std::string &mode, intptr_t map_offset, intptr_t length)
+{
+  file_mapping *fm = new file_mapping;
+  fm->length = length;
+
+#if defined(_WIN32)
+  DWORD access = (mode == "r+") ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+  HANDLE file = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    delete fm;
+    raise_os_error(path);
+  }
+  DWORD protect = (mode == "r+") ? PAGE_READWRITE : (mode == "c") ? PAGE_WRITECOPY : PAGE_READONLY;
+  fm->mapping = CreateFileMappingA(file, NULL, protect, 0, 0, NULL);
+  CloseHandle(file);
+  if (fm->mapping == NULL) {
+    delete fm;
+    raise_os_error(path);
+  }
+  DWORD view_access = (mode == "r+") ? FILE_MAP_WRITE : (mode == "c") ? FILE_MAP_COPY : FILE_MAP_READ;
+  fm->addr = MapViewOfFile(fm->mapping, view_access, static_cast<DWORD>(static_cast<uint64_t>(map_offset) >> 32),
+                           static_cast<DWORD>(map_offset), length);
+  if (fm->addr == NULL) {
+    CloseHandle(fm->mapping);
+    delete fm;
+    raise_os_error(path);
+  }
+#else
+  int fd = open(path.c_str(), (mode == "r+") ? O_RDWR : O_RDONLY);
+  if (fd < 0) {
+    delete fm;
+    raise_os_error(path);
+  }
+  int prot = (mode == "r") ? PROT_READ : (PROT_READ | PROT_WRITE);
+  int flags = (mode == "c") ? MAP_PRIVATE : MAP_SHARED;
+  fm->addr = mmap(NULL, length, prot, flags, fd, map_offset);
+  // The mapping keeps its own reference to the file
+  close(fd);
+  if (fm->addr == MAP_FAILED) {
+    delete fm;
+    raise_os_error(path);
+  }
+#endif
+
+  return fm;
+}
+
+intptr_t file_size(const std::string &path)
+{
+#if defined(_WIN32)
+  WIN32_FILE_ATTRIBUTE_DATA attrs;
+  if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attrs)) {
+    raise_os_error(path);
+  }
+  return static_cast<intptr_t>((static_cast<uint64_t>(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow);
+#else
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    raise_os_error(path);
+  }
+  return st.st_size;
+#endif
+}
+
+/**
+ * The header at the start of a file written by nd.save. All of its fields,
+ * and the offsets stored in the data, are in the byte order of the machine
+ * which wrote the file.
+ *
+ * The data section holds the data of the array in the layout of a new
+ * array of its type, followed by the variable sized parts: the elements of
+ * each var dimension, aligned to `blob_alignment`, and the bytes of each
+ * string. The data refers to them with a `blob_ref` in place of the var
+ * dimension or string, whose offset is relative to the start of the data
+ * section.
+ */
+struct file_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t datashape_offset;
+  uint64_t datashape_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t root_size;
+  uint64_t reserved;
+};
+
+struct blob_ref {
+  uint64_t offset;
+  uint64_t size;
+};
+
+const char file_magic[8] = {'D', 'Y', 'N', 'D', 'A', 'R', 'R', '\0'};
+const uint32_t file_version = 1;
+const uint32_t file_big_endian_flag = 0x1;
+// The offset of a var dimension or string that was never allocated
+const uint64_t null_blob_offset = ~uint64_t(0);
+const size_t blob_alignment = 64;
+
+uint32_t native_byte_order_flags()
+{
+  const uint32_t one = 1;
+  return *reinterpret_cast<const char *>(&one) ? 0 : file_big_endian_flag;
+}
+
+size_t align_up(size_t offset) { return (offset + blob_alignment - 1) & ~(blob_alignment - 1); }
+
+void check_blob_layout()
+{
+  // The blob references are stored in place of the pointer and size of a
+  // var dimension or string, which only fit on 64-bit platforms
+  if (sizeof(ndt::var_dim_type::data_type) != sizeof(blob_ref) || sizeof(dynd::bytes) != sizeof(blob_ref)) {
+    throw runtime_error("nd.save and nd.load require a 64-bit platform");
+  }
+}
+
+const uintptr_t *tuple_data_offsets(const ndt::type &tp, const char *arrmeta)
+{
+  return tp.extended<ndt::tuple_type>()->get_data_offsets(arrmeta);
+}
+
+/**
+ * Replaces the var dimensions and strings in the data at `pos` in `buf`,
+ * which is a copy of `data`, by references to their elements and bytes,
+ * appended to `buf`.
+ */
+void save_blobs(const ndt::type &tp, const char *arrmeta, const char *data, vector<char> &buf, size_t pos)
+{
+  if ((tp.get_flags() & (type_flag_blockref | type_flag_destructor)) == 0) {
+    return;
+  }
+
+  switch (tp.get_id()) {
+  case fixed_dim_id: {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    for (intptr_t i = 0; i < md->dim_size; ++i) {
+      save_blobs(el_tp, arrmeta + sizeof(fixed_dim_type_arrmeta), data + i * md->stride, buf, pos + i * md->stride);
+    }
+    break;
+  }
+  case var_dim_id: {
+    const ndt::var_dim_type::metadata_type *md = reinterpret_cast<const ndt::var_dim_type::metadata_type *>(arrmeta);
+    const ndt::var_dim_type::data_type *vdd = reinterpret_cast<const ndt::var_dim_type::data_type *>(data);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    blob_ref ref = {null_blob_offset, 0};
+    if (vdd->begin != NULL) {
+      size_t nbytes = vdd->size * md->stride;
+      ref.offset = align_up(buf.size());
+      ref.size = vdd->size;
+      buf.resize(ref.offset + nbytes);
+      memcpy(&buf[ref.offset], vdd->begin + md->offset, nbytes);
+      for (size_t i = 0; i < vdd->size; ++i) {
+        save_blobs(el_tp, arrmeta + sizeof(ndt::var_dim_type::metadata_type), vdd->begin + md->offset + i * md->stride,
+                   buf, ref.offset + i * md->stride);
+      }
+    }
+    memcpy(&buf[pos], &ref, sizeof(ref));
+    break;
+  }
+  case struct_id:
+  case tuple_id: {
+    const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+    const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+    const uintptr_t *data_offsets = tuple_data_offsets(tp, arrmeta);
+    for (intptr_t i = 0; i < tt->get_field_count(); ++i) {
+      save_blobs(tt->get_field_type(i), arrmeta + arrmeta_offsets[i], data + data_offsets[i], buf,
+                 pos + data_offsets[i]);
+    }
+    break;
+  }
+  case option_id:
+    save_blobs(tp.extended<ndt::option_type>()->get_value_type(), arrmeta, data, buf, pos);
+    break;
+  case string_id:
+  case bytes_id: {
+    const dynd::bytes *bd = reinterpret_cast<const dynd::bytes *>(data);
+    blob_ref ref = {null_blob_offset, 0};
+    if (bd->begin() != NULL) {
+      ref.offset = buf.size();
+      ref.size = bd->end() - bd->begin();
+      buf.insert(buf.end(), bd->begin(), bd->end());
+    }
+    memcpy(&buf[pos], &ref, sizeof(ref));
+    break;
+  }
+  default: {
+    stringstream ss;
+    ss << "nd.save does not support arrays of type " << tp;
+    throw type_error(ss.str());
+  }
+  }
+}
+
+/**
+ * Reads the blob reference at `data`, checking that its elements of
+ * `itemsize` bytes each lie within the data section.
+ */
+blob_ref load_blob_ref(const char *data, size_t itemsize, size_t section_size)
+{
+  blob_ref ref;
+  memcpy(&ref, data, sizeof(ref));
+  if (ref.offset != null_blob_offset &&
+      (ref.offset > section_size || (itemsize != 0 && ref.size > (section_size - ref.offset) / itemsize))) {
+    throw runtime_error("nd.load found an offset outside of the data, the file is corrupt");
+  }
+
+  return ref;
+}
+
+/**
+ * How `load_blobs` treats the elements of the var dimensions.
+ */
+enum load_mode {
+  // `dst` is `src`, and the var dimensions are made to point into the section
+  load_in_place,
+  // `dst` is zero initialized memory of a new array, and the elements of the
+  // var dimensions are copied into memory from their blockref
+  load_copy,
+  // Like `load_copy`, except that the var dimensions of plain data point into
+  // the section, which is left untouched
+  load_plain_views
+};
+
+/**
+ * Reads the data at `src`, in which the var dimensions and strings are blob
+ * references, into `dst`, as `mode` says. Strings and bytes are always
+ * copied.
+ */
+void load_blobs(const ndt::type &tp, const char *arrmeta, const char *src, char *dst, const char *section,
+                size_t section_size, load_mode mode)
+{
+  if ((tp.get_flags() & (type_flag_blockref | type_flag_destructor)) == 0) {
+    if (mode != load_in_place) {
+      memcpy(dst, src, tp.get_data_size());
+    }
+    return;
+  }
+
+  switch (tp.get_id()) {
+  case fixed_dim_id: {
+    const fixed_dim_type_arrmeta *md = reinterpret_cast<const fixed_dim_type_arrmeta *>(arrmeta);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    for (intptr_t i = 0; i < md->dim_size; ++i) {
+      load_blobs(el_tp, arrmeta + sizeof(fixed_dim_type_arrmeta), src + i * md->stride, dst + i * md->stride, section,
+                 section_size, mode);
+    }
+    break;
+  }
+  case var_dim_id: {
+    const ndt::var_dim_type::metadata_type *md = reinterpret_cast<const ndt::var_dim_type::metadata_type *>(arrmeta);
+    ndt::var_dim_type::data_type *vdd = reinterpret_cast<ndt::var_dim_type::data_type *>(dst);
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    blob_ref ref = load_blob_ref(src, md->stride, section_size);
+    if (ref.offset == null_blob_offset) {
+      vdd->begin = NULL;
+      vdd->size = 0;
+      break;
+    }
+    bool plain = (el_tp.get_flags() & (type_flag_blockref | type_flag_destructor)) == 0;
+    bool view = (mode == load_in_place || (mode == load_plain_views && plain));
+    vdd->begin = view ? const_cast<char *>(section) + ref.offset : md->blockref->alloc(ref.size);
+    vdd->size = ref.size;
+    if (view && plain) {
+      // The elements are already in place
+      break;
+    }
+    for (size_t i = 0; i < vdd->size; ++i) {
+      load_blobs(el_tp, arrmeta + sizeof(ndt::var_dim_type::metadata_type), section + ref.offset + i * md->stride,
+                 vdd->begin + i * md->stride, section, section_size, mode);
+    }
+    break;
+  }
+  case struct_id:
+  case tuple_id: {
+    const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+    const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+    const uintptr_t *data_offsets = tuple_data_offsets(tp, arrmeta);
+    for (intptr_t i = 0; i < tt->get_field_count(); ++i) {
+      load_blobs(tt->get_field_type(i), arrmeta + arrmeta_offsets[i], src + data_offsets[i], dst + data_offsets[i],
+                 section, section_size, mode);
+    }
+    break;
+  }
+  case option_id:
+    load_blobs(tp.extended<ndt::option_type>()->get_value_type(), arrmeta, src, dst, section, section_size, mode);
+    break;
+  case string_id:
+  case bytes_id: {
+    blob_ref ref = load_blob_ref(src, 1, section_size);
+    if (ref.offset != null_blob_offset) {
+      reinterpret_cast<dynd::bytes *>(dst)->assign(section + ref.offset, ref.size);
+    }
+    break;
+  }
+  default: {
+    stringstream ss;
+    ss << "nd.load does not support arrays of type " << tp;
+    throw type_error(ss.str());
+  }
+  }
+}
+
+/**
+ * Sets the blockref of every var dimension in the arrmeta to `memblock`,
+ * or only of those whose elements are plain data with `plain_only`, so
+ * that the elements they point to keep it alive.
+ */
+void set_blockrefs(const ndt::type &tp, char *arrmeta, const nd::memory_block &memblock, bool plain_only)
+{
+  switch (tp.get_id()) {
+  case fixed_dim_id:
+    set_blockrefs(tp.extended<ndt::base_dim_type>()->get_element_type(), arrmeta + sizeof(fixed_dim_type_arrmeta),
+                  memblock, plain_only);
+    break;
+  case var_dim_id: {
+    const ndt::type &el_tp = tp.extended<ndt::base_dim_type>()->get_element_type();
+    if (!plain_only || (el_tp.get_flags() & (type_flag_blockref | type_flag_destructor)) == 0) {
+      reinterpret_cast<ndt::var_dim_type::metadata_type *>(arrmeta)->blockref = memblock;
+    }
+    set_blockrefs(el_tp, arrmeta + sizeof(ndt::var_dim_type::metadata_type), memblock, plain_only);
+    break;
+  }
+  case struct_id:
+  case tuple_id: {
+    const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+    const uintptr_t *arrmeta_offsets = tt->get_arrmeta_offsets_raw();
+    for (intptr_t i = 0; i < tt->get_field_count(); ++i) {
+      set_blockrefs(tt->get_field_type(i), arrmeta + arrmeta_offsets[i], memblock, plain_only);
+    }
+    break;
+  }
+  case option_id:
+    set_blockrefs(tp.extended<ndt::option_type>()->get_value_type(), arrmeta, memblock, plain_only);
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * The largest alignment of the data of `tp` and of the elements of its var
+ * dimensions, which the start of a data section has to have for it to be
+ * viewed. The blobs are aligned to `blob_alignment` from there.
+ */
+size_t section_alignment(const ndt::type &tp)
+{
+  size_t alignment = tp.get_data_alignment();
+  switch (tp.get_id()) {
+  case fixed_dim_id:
+  case var_dim_id:
+    return max(alignment, section_alignment(tp.extended<ndt::base_dim_type>()->get_element_type()));
+  case struct_id:
+  case tuple_id: {
+    const ndt::tuple_type *tt = tp.extended<ndt::tuple_type>();
+    for (intptr_t i = 0; i < tt->get_field_count(); ++i) {
+      alignment = max(alignment, section_alignment(tt->get_field_type(i)));
+    }
+    return alignment;
+  }
+  case option_id:
+    return max(alignment, section_alignment(tp.extended<ndt::option_type>()->get_value_type()));
+  default:
+    return alignment;
+  }
+}
+
+/**
+ * Packs the data of `a` into `section`, in the layout of the data section
+ * of nd.save.
+ */
+void pack_section(const nd::array &a, vector<char> &section)
+{
+  check_blob_layout();
+
+  ndt::type tp = a.get_type();
+  if (tp.is_symbolic()) {
+    stringstream ss;
+    ss << "cannot serialize an array of symbolic type " << tp;
+    throw type_error(ss.str());
+  }
+
+  // Copy into a new array, so the data has the default layout that
+  // loading it reconstructs
+  nd::array c = nd::empty(tp);
+  c.assign(a);
+
+  section.assign(c.cdata(), c.cdata() + tp.get_data_size());
+  save_blobs(tp, c.get()->metadata(), c.cdata(), section, 0);
+}
+
+/**
+ * Views a packed data section of type `tp` owned by `memblock`, rewriting
+ * the references of its var dimensions into pointers in place.
+ */
+nd::array view_section(const ndt::type &tp, char *section, size_t section_size, const nd::memory_block &memblock,
+                       uint64_t access_flags)
+{
+  nd::array result = nd::make_array(tp, section, memblock, access_flags);
+  if (!tp.is_builtin()) {
+    tp.extended()->arrmeta_default_construct(result.get()->metadata(), true);
+    set_blockrefs(tp, result.get()->metadata(), memblock, false);
+  }
+  load_blobs(tp, result.get()->metadata(), section, section, section, section_size, load_in_place);
+
+  return result;
+}
+
+/**
+ * Copies a packed data section of type `tp` owned by `memblock` into a new
+ * array, except for the elements of its var dimensions of plain data, which
+ * are viewed. The section itself is left untouched.
+ */
+nd::array view_plain_section(const ndt::type &tp, const char *section, size_t section_size,
+                             const nd::memory_block &memblock)
+{
+  nd::array result = nd::empty(tp);
+  set_blockrefs(tp, result.get()->metadata(), memblock, true);
+  load_blobs(tp, result.get()->metadata(), section, result.data(), section, section_size, load_plain_views);
+
+  return result;
+}
+
+/**
+ * Copies a packed data section of type `tp` into a new array.
+ */
+nd::array copy_section(const ndt::type &tp, const char *section, size_t section_size)
+{
+  nd::array result = nd::empty(tp);
+  load_blobs(tp, result.get()->metadata(), section, result.data(), section, section_size, load_copy);
+
+  return result;
+}
+
+void delete_section(void *obj) { delete reinterpret_cast<vector<char> *>(obj); }
+
+void release_buffer(void *obj)
+{
+  Py_buffer *buffer = reinterpret_cast<Py_buffer *>(obj);
+  // The last array referencing the buffer may go away without the GIL
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  PyBuffer_Release(buffer);
+  PyGILState_Release(gstate);
+  delete buffer;
+}
+
+void write_file(const std::string &path, const char *data, size_t size)
+{
+  FILE *f = fopen(path.c_str(), "wb");
+  if (f == NULL) {
+    raise_os_error(path);
+  }
+  size_t written = fwrite(data, 1, size, f);
+  if (fclose(f) != 0 || written != size) {
+    raise_os_error(path);
+  }
+}
+
+} // anonymous namespace
+
+dynd::nd::array pydynd::array_memmap(const std::string &path, const dynd::ndt::type &tp, const std::string &mode,
+                                     intptr_t offset, const std::string &advice)
+{
+  if (mode != "r" && mode != "r+" && mode != "c") {
+    throw invalid_argument("nd.memmap mode must be 'r', 'r+' or 'c', not '" + mode + "'");
+  }
+  if (offset < 0) {
+    throw invalid_argument("nd.memmap offset must be nonnegative");
+  }
+
+  // Split the type into its dimensions and its element type
+  bool deduce_leading_dim = tp.get_ndim() > 0 && tp.get_id() != fixed_dim_id && tp.is_symbolic();
+  intptr_t ndim = tp.get_ndim();
+  dimvector shape(ndim), strides(ndim);
+  ndt::type dtp = tp;
+  for (intptr_t i = 0; i < ndim; ++i) {
+    if (dtp.get_id() == fixed_dim_id) {
+      shape[i] = dtp.extended<ndt::base_dim_type>()->get_dim_size();
+    }
+    else if (i != 0 || !deduce_leading_dim) {
+      stringstream ss;
+      ss << "nd.memmap requires fixed dimensions after the first, not " << tp;
+      throw type_error(ss.str());
+    }
+    dtp = dtp.extended<ndt::base_dim_type>()->get_element_type();
+  }
+  if (dtp.is_symbolic() || dtp.get_data_size() <= 0 ||
+      (dtp.get_flags() & (type_flag_blockref | type_flag_destructor)) != 0) {
+    stringstream ss;
+    ss << "nd.memmap requires plain data of a fixed size, not " << dtp;
+    throw type_error(ss.str());
+  }
+
+  // C order strides, and the number of bytes viewed
+  intptr_t length = dtp.get_data_size();
+  for (intptr_t i = ndim - 1; i >= 0; --i) {
+    strides[i] = length;
+    if (i != 0 || !deduce_leading_dim) {
+      length *= shape[i];
+    }
+  }
+
+  intptr_t available = file_size(path) - offset;
+  if (deduce_leading_dim) {
+    shape[0] = (available > 0 && length > 0) ? available / length : 0;
+    length *= shape[0];
+  }
+  if (length > available) {
+    stringstream ss;
+    ss << "nd.memmap of type " << tp << " needs " << length << " bytes from offset " << offset << ", but the file "
+       << path << " only has " << (available > 0 ? available : 0);
+    throw runtime_error(ss.str());
+  }
+
+  if (length == 0) {
+    // Zero bytes can't be mapped, and there is nothing to view anyway
+    return nd::dtyped_empty(ndim, shape.get(), dtp);
+  }
+
+  intptr_t map_offset = offset - offset % page_size();
+  file_mapping *fm = map_file(path, mode, map_offset, (offset - map_offset) + length);
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(fm, &unmap_function);
+
+  char *arrmeta = NULL;
+  nd::array result = nd::make_strided_array_from_data(
+      dtp, ndim, shape.get(), strides.get(), nd::read_access_flag | (mode == "r" ? 0 : nd::write_access_flag),
+      reinterpret_cast<char *>(fm->addr) + (offset - map_offset), memblock, &arrmeta);
+  if (!dtp.is_builtin() && dtp.get_arrmeta_size() > 0) {
+    // e.g. the field offsets of a struct
+    dtp.extended()->arrmeta_default_construct(arrmeta, true);
+  }
+
+  if (!advice.empty()) {
+    array_madvise(result, advice);
+  }
+
+  return result;
+}
+
+void pydynd::array_madvise(const dynd::nd::array &a, const std::string &advice)
+{
+#if defined(_WIN32)
+  if (advice != "normal" && advice != "sequential" && advice != "random" && advice != "willneed" &&
+      advice != "dontneed") {
+    throw invalid_argument("unknown madvise hint '" + advice + "'");
+  }
+#else
+  int hint;
+  if (advice == "normal") {
+    hint = POSIX_MADV_NORMAL;
+  }
+  else if (advice == "sequential") {
+    hint = POSIX_MADV_SEQUENTIAL;
+  }
+  else if (advice == "random") {
+    hint = POSIX_MADV_RANDOM;
+  }
+  else if (advice == "willneed") {
+    hint = POSIX_MADV_WILLNEED;
+  }
+  else if (advice == "dontneed") {
+    hint = POSIX_MADV_DONTNEED;
+  }
+  else {
+    throw invalid_argument("unknown madvise hint '" + advice + "'");
+  }
+
+  // The range of bytes spanned by the strided data
+  intptr_t ndim = a.get_ndim();
+  dimvector shape(ndim), strides(ndim);
+  a.get_shape(shape.get());
+  a.get_strides(strides.get());
+  intptr_t begin = 0, end = a.get_dtype().get_data_size();
+  for (intptr_t i = 0; i < ndim; ++i) {
+    if (shape[i] == 0) {
+      return;
+    }
+    if (strides[i] > 0) {
+      end += (shape[i] - 1) * strides[i];
+    }
+    else {
+      begin += (shape[i] - 1) * strides[i];
+    }
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(a.cdata()) + begin;
+  uintptr_t aligned_start = start - start % page_size();
+  int err = posix_madvise(reinterpret_cast<void *>(aligned_start), (start - aligned_start) + (end - begin), hint);
+  if (err != 0) {
+    errno = err;
+    PyErr_SetFromErrno(PyExc_OSError);
+    throw exception();
+  }
+#endif
+}
+
+void pydynd::array_save(const std::string &path, const dynd::nd::array &a)
+{
+  check_blob_layout();
+
+  stringstream datashape;
+  datashape << a.get_type();
+  std::string ds = datashape.str();
+
+  vector<char> section;
+  pack_section(a, section);
+
+  file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, file_magic, sizeof(file_magic));
+  header.version = file_version;
+  header.flags = native_byte_order_flags();
+  header.datashape_offset = sizeof(header);
+  header.datashape_size = ds.size();
+  header.data_offset = align_up(sizeof(header) + ds.size());
+  header.data_size = section.size();
+  header.root_size = a.get_type().get_data_size();
+
+  vector<char> buf(header.data_offset + section.size(), '\0');
+  memcpy(&buf[0], &header, sizeof(header));
+  memcpy(&buf[header.datashape_offset], ds.data(), ds.size());
+  if (!section.empty()) {
+    memcpy(&buf[header.data_offset], &section[0], section.size());
+  }
+  write_file(path, &buf[0], buf.size());
+}
+
+dynd::nd::array pydynd::array_load(const std::string &path, bool mmap)
+{
+  check_blob_layout();
+
+  intptr_t size = file_size(path);
+  if (size < static_cast<intptr_t>(sizeof(file_header))) {
+    throw runtime_error("nd.load requires a file written by nd.save, " + path + " is too short");
+  }
+
+  file_mapping *fm = map_file(path, "c", 0, size);
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(fm, &unmap_function);
+  char *base = reinterpret_cast<char *>(fm->addr);
+
+  file_header header;
+  memcpy(&header, base, sizeof(header));
+  if (memcmp(header.magic, file_magic, sizeof(file_magic)) != 0) {
+    throw runtime_error("nd.load requires a file written by nd.save, " + path + " is not one");
+  }
+  if (header.version != file_version) {
+    stringstream ss;
+    ss << "nd.load does not support version " << header.version << " of the file format, in " << path;
+    throw runtime_error(ss.str());
+  }
+  if (header.flags != native_byte_order_flags()) {
+    throw runtime_error("nd.load does not support files written with a different byte order, in " + path);
+  }
+  if (header.datashape_offset > static_cast<uint64_t>(size) ||
+      header.datashape_size > static_cast<uint64_t>(size) - header.datashape_offset ||
+      header.data_offset > static_cast<uint64_t>(size) ||
+      header.data_size > static_cast<uint64_t>(size) - header.data_offset || header.root_size > header.data_size) {
+    throw runtime_error("nd.load found sections outside of the file, " + path + " is corrupt");
+  }
+
+  ndt::type tp(std::string(base + header.datashape_offset, header.datashape_size));
+  if (tp.get_data_size() != header.root_size) {
+    throw runtime_error("nd.load found data of the wrong size for its type, " + path + " is corrupt");
+  }
+  char *section = base + header.data_offset;
+  size_t section_size = header.data_size;
+
+  if (mmap && (tp.get_flags() & type_flag_destructor) == 0) {
+    // View the data in the private mapping, only writing the pointers of
+    // the var dimensions into it
+    nd::array result = view_section(tp, section, section_size, memblock, nd::read_access_flag);
+#if !defined(_WIN32)
+    mprotect(fm->addr, fm->length, PROT_READ);
+#endif
+    return result;
+  }
+
+  // Copy everything, leaving the mapping to be released with `memblock`
+  nd::array result = copy_section(tp, section, section_size);
+
+  return result;
+}
+
+dynd::nd::array pydynd::array_pack(const dynd::nd::array &a)
+{
+  const ndt::type &tp = a.get_type();
+  intptr_t size = tp.get_data_size();
+  intptr_t stride = 1;
+  char *arrmeta = NULL;
+
+  if ((tp.get_flags() & (type_flag_blockref | type_flag_destructor)) == 0 && !tp.is_symbolic() &&
+      a.get_dtype().get_arrmeta_size() == 0 && array_is_c_contiguous(a)) {
+    // The data already is in the packed layout
+    return nd::make_strided_array_from_data(ndt::make_type<uint8_t>(), 1, &size, &stride, nd::read_access_flag,
+                                            const_cast<char *>(a.cdata()), a.get_data_memblock(), &arrmeta);
+  }
+
+  vector<char> *section = new vector<char>;
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(section, &delete_section);
+  pack_section(a, *section);
+  size = section->size();
+  if (section->empty()) {
+    return nd::empty(0, ndt::make_type<uint8_t>());
+  }
+
+  return nd::make_strided_array_from_data(ndt::make_type<uint8_t>(), 1, &size, &stride,
+                                          nd::read_access_flag | nd::write_access_flag, &(*section)[0], memblock,
+                                          &arrmeta);
+}
+
+dynd::nd::array pydynd::array_unpack(const dynd::ndt::type &tp, PyObject *obj)
+{
+  Py_buffer *buffer = new Py_buffer;
+  uint64_t access_flags = nd::read_access_flag | nd::write_access_flag;
+  if (PyObject_GetBuffer(obj, buffer, PyBUF_WRITABLE) < 0) {
+    PyErr_Clear();
+    access_flags = nd::read_access_flag;
+    if (PyObject_GetBuffer(obj, buffer, PyBUF_SIMPLE) < 0) {
+      delete buffer;
+      throw exception();
+    }
+  }
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(buffer, &release_buffer);
+
+  char *section = reinterpret_cast<char *>(buffer->buf);
+  size_t section_size = buffer->len;
+  if (tp.is_symbolic() || tp.get_data_size() > section_size) {
+    stringstream ss;
+    ss << "cannot unpack an array of type " << tp << " from " << section_size << " bytes";
+    throw runtime_error(ss.str());
+  }
+
+  // Strings own their memory, so types with them are always copied, and so
+  // is a read-only buffer, which the result couldn't be written through.
+  // Otherwise plain data is viewed where it is. The buffer may belong to
+  // the caller, so it is never rewritten, and the references of the var
+  // dimensions are copied into pointers to their elements in it instead.
+  if ((tp.get_flags() & type_flag_destructor) == 0 && (access_flags & nd::write_access_flag) != 0 &&
+      reinterpret_cast<uintptr_t>(section) % section_alignment(tp) == 0) {
+    if ((tp.get_flags() & type_flag_blockref) == 0) {
+      return view_section(tp, section, section_size, memblock, access_flags);
+    }
+    return view_plain_section(tp, section, section_size, memblock);
+  }
+
+  return copy_section(tp, section, section_size);
+}
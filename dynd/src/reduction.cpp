@@ -0,0 +1,374 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+
+#include <dynd/complex.hpp>
+#include <dynd/irange.hpp>
+#include <dynd/shortvector.hpp>
+#include <dynd/types/callable_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/option_type.hpp>
+
+#include "parallel_for.hpp"
+#include "reduction.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using pydynd::parallel_for;
+
+namespace {
+
+// Below this many elements, the innermost reduced dimension is summed
+// directly with eight interleaved accumulators instead of being split.
+const intptr_t pairwise_leaf_size = 128;
+
+/**
+ * Makes the `axes` keyword argument of `reduce`, with the element type its
+ * signature asks for, as the list nd.sum used to pass deduces to int32.
+ */
+nd::array make_axes_array(const nd::callable &reduce, const vector<intptr_t> &axes)
+{
+  ndt::type axis_tp = ndt::make_type<int32_t>();
+  const ndt::callable_type *ct = reduce.get()->get_type().extended<ndt::callable_type>();
+  intptr_t i = ct->get_kwd_index("axes");
+  if (i >= 0) {
+    ndt::type kwd_tp = ct->get_kwd_type(i);
+    if (kwd_tp.get_id() == option_id) {
+      kwd_tp = kwd_tp.extended<ndt::option_type>()->get_value_type();
+    }
+    if (kwd_tp.get_dtype().is_builtin()) {
+      axis_tp = kwd_tp.get_dtype();
+    }
+  }
+
+  nd::array values = nd::empty(ndt::make_fixed_dim(axes.size(), ndt::make_type<int64_t>()));
+  int64_t *data = reinterpret_cast<int64_t *>(values.data());
+  for (size_t j = 0; j < axes.size(); ++j) {
+    data[j] = axes[j];
+  }
+
+  nd::array result = nd::empty(ndt::make_fixed_dim(axes.size(), axis_tp));
+  result.assign(values);
+  return result;
+}
+
+nd::array call_reduce(const nd::callable &reduce, const nd::array &a, const nd::array &axes)
+{
+  nd::array args[1] = {a};
+  pair<const char *, nd::array> kwds[1] = {pair<const char *, nd::array>("axes", axes)};
+  return reduce.call(1, args, 1, kwds);
+}
+
+nd::array call_combine(const nd::callable &combine, const nd::array &x, const nd::array &y)
+{
+  nd::array args[2] = {x, y};
+  return combine.call(2, args, 0, NULL);
+}
+
+/**
+ * Merges the partial results level by level, pairing neighbours and
+ * carrying an odd one out to the next level unchanged.
+ */
+nd::array pairwise_combine(const nd::callable &combine, vector<nd::array> partials, intptr_t nthreads)
+{
+  while (partials.size() > 1) {
+    intptr_t half = partials.size() / 2;
+    vector<nd::array> next(half + partials.size() % 2);
+    parallel_for(half, nthreads,
+                 [&](intptr_t i) { next[i] = call_combine(combine, partials[2 * i], partials[2 * i + 1]); });
+    if (partials.size() % 2 != 0) {
+      next.back() = partials.back();
+    }
+    partials.swap(next);
+  }
+
+  return partials[0];
+}
+
+/**
+ * Sums the subspace spanned by the reduced dimensions of a strided array.
+ *
+ * The subspace is split recursively, halving the outermost reduced
+ * dimension that still has more than one index, down to runs of the
+ * innermost reduced dimension of at most `pairwise_leaf_size` elements.
+ */
+template <typename T>
+class pairwise_summer {
+  struct node {
+    const char *data;
+    size_t level;
+    intptr_t lo;
+    intptr_t hi;
+    intptr_t left;
+    intptr_t right;
+  };
+
+  vector<intptr_t> m_shape;
+  vector<intptr_t> m_strides;
+
+  static T load(const char *data) { return *reinterpret_cast<const T *>(data); }
+
+  static T leaf(const char *data, intptr_t stride, intptr_t n)
+  {
+    T res = T();
+    intptr_t i = 0;
+    if (n >= 8) {
+      T r[8];
+      for (int j = 0; j < 8; ++j) {
+        r[j] = load(data + j * stride);
+      }
+      for (i = 8; i < n - n % 8; i += 8) {
+        for (int j = 0; j < 8; ++j) {
+          r[j] += load(data + (i + j) * stride);
+        }
+      }
+      res = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+    }
+    for (; i < n; ++i) {
+      res += load(data + i * stride);
+    }
+
+    return res;
+  }
+
+  bool is_innermost(size_t level) const { return level + 1 == m_shape.size(); }
+
+  // Steps into the next reduced dimension while only one index is left
+  void descend(node &n) const
+  {
+    while (!is_innermost(n.level) && n.hi - n.lo == 1) {
+      n.data += n.lo * m_strides[n.level];
+      ++n.level;
+      n.lo = 0;
+      n.hi = m_shape[n.level];
+    }
+  }
+
+  bool is_leaf(const node &n) const
+  {
+    return n.hi == n.lo || (is_innermost(n.level) && n.hi - n.lo <= pairwise_leaf_size);
+  }
+
+  intptr_t split(const node &n) const
+  {
+    intptr_t n2 = (n.hi - n.lo) / 2;
+    if (is_innermost(n.level)) {
+      n2 -= n2 % 8;
+    }
+
+    return n.lo + n2;
+  }
+
+  T sum(node n) const
+  {
+    descend(n);
+    if (n.hi == n.lo) {
+      return T();
+    }
+    if (is_leaf(n)) {
+      return leaf(n.data + n.lo * m_strides[n.level], m_strides[n.level], n.hi - n.lo);
+    }
+
+    intptr_t mid = split(n);
+    node left = {n.data, n.level, n.lo, mid, -1, -1};
+    node right = {n.data, n.level, mid, n.hi, -1, -1};
+    return sum(left) + sum(right);
+  }
+
+public:
+  pairwise_summer(const vector<intptr_t> &shape, const vector<intptr_t> &strides) : m_shape(shape), m_strides(strides)
+  {
+  }
+
+  T operator()(const char *data) const
+  {
+    node root = {data, 0, 0, m_shape[0], -1, -1};
+    return sum(root);
+  }
+
+  /**
+   * Computes the same value as operator(), expanding the top of the tree
+   * until there is enough independent work for `nthreads` threads. The
+   * expanded nodes are then combined bottom up in the same order as the
+   * serial recursion, so the result is bitwise identical.
+   */
+  T operator()(const char *data, intptr_t nthreads) const
+  {
+    vector<node> nodes(1, node{data, 0, 0, m_shape[0], -1, -1});
+    vector<intptr_t> leaves(1, 0);
+
+    bool expanded = true;
+    while (expanded && static_cast<intptr_t>(leaves.size()) < 8 * nthreads) {
+      expanded = false;
+      vector<intptr_t> next;
+      for (intptr_t i : leaves) {
+        descend(nodes[i]);
+        if (is_leaf(nodes[i])) {
+          next.push_back(i);
+          continue;
+        }
+
+        node parent = nodes[i];
+        intptr_t mid = split(parent);
+        nodes[i].left = nodes.size();
+        nodes.push_back(node{parent.data, parent.level, parent.lo, mid, -1, -1});
+        nodes[i].right = nodes.size();
+        nodes.push_back(node{parent.data, parent.level, mid, parent.hi, -1, -1});
+        next.push_back(nodes[i].left);
+        next.push_back(nodes[i].right);
+        expanded = true;
+      }
+      leaves.swap(next);
+    }
+
+    vector<T> values(nodes.size());
+    parallel_for(leaves.size(), nthreads, [&](intptr_t i) { values[leaves[i]] = sum(nodes[leaves[i]]); });
+    // Children always come after their parent
+    for (intptr_t i = nodes.size() - 1; i >= 0; --i) {
+      if (nodes[i].left != -1) {
+        values[i] = values[nodes[i].left] + values[nodes[i].right];
+      }
+    }
+
+    return values[0];
+  }
+};
+
+template <typename T>
+nd::array strided_pairwise_sum(const nd::array &a, const vector<intptr_t> &axes, intptr_t nthreads)
+{
+  intptr_t ndim = a.get_ndim();
+  dimvector shape(ndim), strides(ndim);
+  a.get_shape(shape.get());
+  a.get_strides(strides.get());
+
+  vector<intptr_t> reduced_shape, reduced_strides, kept_shape, kept_strides;
+  for (intptr_t i = 0; i < ndim; ++i) {
+    if (binary_search(axes.begin(), axes.end(), i)) {
+      reduced_shape.push_back(shape[i]);
+      reduced_strides.push_back(strides[i]);
+    }
+    else {
+      kept_shape.push_back(shape[i]);
+      kept_strides.push_back(strides[i]);
+    }
+  }
+
+  ndt::type res_tp = ndt::make_type<T>();
+  intptr_t res_size = 1;
+  for (intptr_t i = kept_shape.size() - 1; i >= 0; --i) {
+    res_tp = ndt::make_fixed_dim(kept_shape[i], res_tp);
+    res_size *= kept_shape[i];
+  }
+  nd::array res = nd::empty(res_tp);
+  T *res_data = reinterpret_cast<T *>(res.data());
+
+  pairwise_summer<T> summer(reduced_shape, reduced_strides);
+  auto src_data = [&](intptr_t j) {
+    const char *data = a.cdata();
+    for (intptr_t i = kept_shape.size() - 1; i >= 0; --i) {
+      data += (j % kept_shape[i]) * kept_strides[i];
+      j /= kept_shape[i];
+    }
+    return data;
+  };
+
+  if (res_size >= nthreads) {
+    parallel_for(res_size, nthreads, [&](intptr_t j) { res_data[j] = summer(src_data(j)); });
+  }
+  else {
+    for (intptr_t j = 0; j < res_size; ++j) {
+      res_data[j] = summer(src_data(j), nthreads);
+    }
+  }
+
+  return res;
+}
+
+} // anonymous namespace
+
+std::vector<intptr_t> pydynd::reduction_axes_from_pyobject(PyObject *axes, intptr_t ndim)
+{
+  if (axes != NULL && PyList_Check(axes)) {
+    pyobject_ownref axes_tuple(PySequence_Tuple(axes));
+    return reduction_axes_from_pyobject(axes_tuple.get(), ndim);
+  }
+
+  vector<bool1> reduce_axes(ndim);
+  pyarg_axis_argument(axes, static_cast<int>(ndim), reduce_axes.data());
+
+  vector<intptr_t> result;
+  for (intptr_t i = 0; i < ndim; ++i) {
+    if (reduce_axes[i]) {
+      result.push_back(i);
+    }
+  }
+
+  return result;
+}
+
+nd::array pydynd::tree_reduction(const nd::callable &reduce, const nd::callable &combine, const nd::array &a,
+                                  const std::vector<intptr_t> &axes, intptr_t block_size, intptr_t nthreads)
+{
+  nd::array axes_arr = make_axes_array(reduce, axes);
+
+  // Split the largest reduced dimension which is preceded only by fixed
+  // dimensions, so every block can be taken with a plain slice
+  intptr_t ndim = a.get_ndim();
+  dimvector shape(ndim);
+  a.get_shape(shape.get());
+  intptr_t split_axis = -1, split_size = 0;
+  for (intptr_t axis : axes) {
+    if (all_of(shape.get(), shape.get() + axis + 1, [](intptr_t size) { return size >= 0; }) &&
+        shape[axis] > split_size) {
+      split_axis = axis;
+      split_size = shape[axis];
+    }
+  }
+
+  if (split_axis == -1 || block_size <= 0 || split_size <= block_size) {
+    return call_reduce(reduce, a, axes_arr);
+  }
+
+  vector<nd::array> partials((split_size + block_size - 1) / block_size);
+  parallel_for(partials.size(), nthreads, [&](intptr_t i) {
+    vector<irange> indices(split_axis + 1);
+    indices[split_axis] = irange(i * block_size, min((i + 1) * block_size, split_size));
+    partials[i] = call_reduce(reduce, a.at_array(indices.size(), indices.data()), axes_arr);
+  });
+
+  return pairwise_combine(combine, partials, nthreads);
+}
+
+nd::array pydynd::pairwise_sum(const nd::callable &reduce, const nd::callable &combine, const nd::array &a,
+                               const std::vector<intptr_t> &axes, intptr_t block_size, intptr_t nthreads)
+{
+  if (!axes.empty()) {
+    ndt::type dtp = a.get_type();
+    intptr_t fixed_ndim = 0;
+    for (; fixed_ndim < a.get_ndim() && dtp.get_id() == fixed_dim_id; ++fixed_ndim) {
+      dtp = dtp.extended<ndt::base_dim_type>()->get_element_type();
+    }
+
+    if (fixed_ndim == a.get_ndim()) {
+      switch (dtp.get_id()) {
+      case float32_id:
+        return strided_pairwise_sum<float>(a, axes, nthreads);
+      case float64_id:
+        return strided_pairwise_sum<double>(a, axes, nthreads);
+      case complex_float32_id:
+        return strided_pairwise_sum<dynd::complex<float>>(a, axes, nthreads);
+      case complex_float64_id:
+        return strided_pairwise_sum<dynd::complex<double>>(a, axes, nthreads);
+      default:
+        break;
+      }
+    }
+  }
+
+  return tree_reduction(reduce, combine, a, axes, block_size, nthreads);
+}
@@ -0,0 +1,281 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <dynd/memblock/external_memory_block.hpp>
+
+#include "shared_memory.hpp"
+
+using namespace std;
+using namespace dynd;
+
+#if !defined(_WIN32)
+
+namespace {
+
+/**
+ * The start of a shared memory segment, followed by the datashape of the
+ * array and, from the page aligned `data_offset` on, its data.
+ */
+struct segment_header {
+  char magic[8];
+  // The number of arrays attached to the segment, in all processes. Once
+  // this drops to zero, the segment is unlinked and can't be attached to.
+  atomic<int64_t> refcount;
+  uint64_t datashape_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+
+const char segment_magic[8] = {'D', 'Y', 'N', 'D', 'S', 'H', 'M', '\0'};
+
+/**
+ * A segment mapped into this process, detached by `detach_function` when
+ * the external memory block owning it is freed.
+ */
+struct shared_segment {
+  std::string name;
+  segment_header *header;
+  size_t length;
+  // The process which counted this attachment. A child forked from it
+  // inherits the mapping without having counted it, so it doesn't
+  // release it either.
+  pid_t pid;
+};
+
+// The segments mapped into this process, by which an array finds the name
+// of its segment.
+mutex segments_mutex;
+set<shared_segment *> segments;
+
+void detach_function(void *obj)
+{
+  shared_segment *seg = reinterpret_cast<shared_segment *>(obj);
+  {
+    lock_guard<mutex> lock(segments_mutex);
+    segments.erase(seg);
+  }
+  if (seg->pid == getpid() && seg->header->refcount.fetch_sub(1) == 1) {
+    shm_unlink(seg->name.c_str());
+  }
+  munmap(seg->header, seg->length);
+  delete seg;
+}
+
+void raise_os_error(const std::string &name)
+{
+  PyErr_SetFromErrnoWithFilename(PyExc_OSError, name.c_str());
+  throw exception();
+}
+
+size_t page_size() { return sysconf(_SC_PAGESIZE); }
+
+size_t align_to_page(size_t offset) { return (offset + page_size() - 1) / page_size() * page_size(); }
+
+std::string unique_segment_name()
+{
+  static atomic<unsigned> counter(0);
+  random_device rd;
+  stringstream ss;
+  ss << "/pydynd-" << getpid() << "-" << counter++ << "-" << hex << rd();
+  return ss.str();
+}
+
+/**
+ * Maps the whole segment open as `fd`, registering it in `segments`.
+ */
+shared_segment *map_segment(const std::string &name, int fd, size_t length)
+{
+  void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    raise_os_error(name);
+  }
+
+  shared_segment *seg = new shared_segment;
+  seg->name = name;
+  seg->header = reinterpret_cast<segment_header *>(addr);
+  seg->length = length;
+  seg->pid = getpid();
+
+  return seg;
+}
+
+/**
+ * Views the data of a mapped segment whose refcount already includes this
+ * attachment.
+ */
+nd::array view_segment(shared_segment *seg, const ndt::type &tp, bool readonly)
+{
+  {
+    lock_guard<mutex> lock(segments_mutex);
+    segments.insert(seg);
+  }
+  nd::memory_block memblock = nd::make_memory_block<nd::external_memory_block>(seg, &detach_function);
+
+  char *data = reinterpret_cast<char *>(seg->header) + seg->header->data_offset;
+  if (readonly && seg->header->data_size > 0) {
+    mprotect(data, seg->length - seg->header->data_offset, PROT_READ);
+  }
+  nd::array result =
+      nd::make_array(tp, data, memblock, nd::read_access_flag | (readonly ? 0 : nd::write_access_flag));
+  if (!tp.is_builtin()) {
+    // e.g. the strides of the dimensions and the field offsets of structs
+    tp.extended()->arrmeta_default_construct(result.get()->metadata(), true);
+  }
+
+  return result;
+}
+
+} // anonymous namespace
+
+dynd::nd::array pydynd::array_empty_shared(const dynd::ndt::type &tp)
+{
+  if (tp.is_symbolic() || (tp.get_flags() & (type_flag_blockref | type_flag_destructor)) != 0) {
+    stringstream ss;
+    ss << "shared memory arrays require a concrete type of plain data, not " << tp;
+    throw type_error(ss.str());
+  }
+
+  stringstream datashape;
+  datashape << tp;
+  std::string ds = datashape.str();
+  size_t data_offset = align_to_page(sizeof(segment_header) + ds.size());
+  size_t length = data_offset + tp.get_data_size();
+
+  std::string name = unique_segment_name();
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    raise_os_error(name);
+  }
+  if (ftruncate(fd, length) != 0) {
+    int err = errno;
+    close(fd);
+    shm_unlink(name.c_str());
+    errno = err;
+    raise_os_error(name);
+  }
+  shared_segment *seg;
+  try {
+    seg = map_segment(name, fd, length);
+  }
+  catch (...) {
+    shm_unlink(name.c_str());
+    throw;
+  }
+
+  segment_header *header = seg->header;
+  new (&header->refcount) atomic<int64_t>(1);
+  header->datashape_size = ds.size();
+  header->data_offset = data_offset;
+  header->data_size = tp.get_data_size();
+  memcpy(reinterpret_cast<char *>(header) + sizeof(segment_header), ds.data(), ds.size());
+  // Written last, so a process attaching early sees an incomplete segment
+  memcpy(header->magic, segment_magic, sizeof(segment_magic));
+
+  return view_segment(seg, tp, false);
+}
+
+std::string pydynd::array_shared_name(const dynd::nd::array &a)
+{
+  lock_guard<mutex> lock(segments_mutex);
+  for (shared_segment *seg : segments) {
+    const char *data = reinterpret_cast<const char *>(seg->header) + seg->header->data_offset;
+    if (a.cdata() == data) {
+      stringstream ds;
+      ds << a.get_type();
+      const char *seg_ds = reinterpret_cast<const char *>(seg->header) + sizeof(segment_header);
+      if (ds.str() == std::string(seg_ds, seg->header->datashape_size)) {
+        return seg->name;
+      }
+    }
+  }
+
+  throw invalid_argument("the array is not a whole array in shared memory");
+}
+
+dynd::nd::array pydynd::array_attach_shared(const std::string &name, bool readonly)
+{
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    raise_os_error(name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    raise_os_error(name);
+  }
+  if (static_cast<size_t>(st.st_size) < sizeof(segment_header)) {
+    close(fd);
+    throw runtime_error("the shared memory segment " + name + " is not a dynd array");
+  }
+  shared_segment *seg = map_segment(name, fd, st.st_size);
+  segment_header *header = seg->header;
+
+  if (memcmp(header->magic, segment_magic, sizeof(segment_magic)) != 0 ||
+      header->data_offset < sizeof(segment_header) + header->datashape_size ||
+      header->data_offset + header->data_size > seg->length) {
+    munmap(header, seg->length);
+    delete seg;
+    throw runtime_error("the shared memory segment " + name + " is not a dynd array");
+  }
+
+  ndt::type tp;
+  try {
+    tp = ndt::type(std::string(reinterpret_cast<char *>(header) + sizeof(segment_header), header->datashape_size));
+  }
+  catch (...) {
+    munmap(header, seg->length);
+    delete seg;
+    throw;
+  }
+
+  // Only attach while some other attachment keeps the segment alive, since
+  // it has been unlinked once the count reaches zero
+  int64_t count = header->refcount.load();
+  do {
+    if (count <= 0) {
+      munmap(header, seg->length);
+      delete seg;
+      throw runtime_error("the shared memory segment " + name + " has been released");
+    }
+  } while (!header->refcount.compare_exchange_weak(count, count + 1));
+
+  return view_segment(seg, tp, readonly);
+}
+
+#else
+
+dynd::nd::array pydynd::array_empty_shared(const dynd::ndt::type &)
+{
+  throw runtime_error("shared memory arrays are not supported on Windows");
+}
+
+std::string pydynd::array_shared_name(const dynd::nd::array &)
+{
+  throw runtime_error("shared memory arrays are not supported on Windows");
+}
+
+dynd::nd::array pydynd::array_attach_shared(const std::string &, bool)
+{
+  throw runtime_error("shared memory arrays are not supported on Windows");
+}
+
+#endif
@@ -0,0 +1,790 @@
+//
+// Copyright (C) 2011-15 DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "cpu_features.hpp"
+#include "utf8.hpp"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Decodes the code point at `p`, moving `p` past it. Returns false if the
+ * bytes aren't a valid UTF-8 sequence, i.e. if it is truncated, overlong,
+ * a surrogate or beyond U+10FFFF.
+ */
+inline bool utf8_next(const uint8_t *&p, const uint8_t *end, uint32_t &cp)
+{
+  uint8_t c = *p++;
+  if (c < 0x80) {
+    cp = c;
+    return true;
+  }
+
+  int n;
+  uint32_t min;
+  if ((c & 0xE0) == 0xC0) {
+    n = 1;
+    min = 0x80;
+    cp = c & 0x1F;
+  }
+  else if ((c & 0xF0) == 0xE0) {
+    n = 2;
+    min = 0x800;
+    cp = c & 0x0F;
+  }
+  else if ((c & 0xF8) == 0xF0) {
+    n = 3;
+    min = 0x10000;
+    cp = c & 0x07;
+  }
+  else {
+    return false;
+  }
+  if (end - p < n) {
+    return false;
+  }
+  for (int i = 0; i < n; ++i) {
+    if ((p[i] & 0xC0) != 0x80) {
+      return false;
+    }
+    cp = (cp << 6) | (p[i] & 0x3F);
+  }
+  p += n;
+
+  return cp >= min && cp <= 0x10FFFF && (cp < 0xD800 || cp >= 0xE000);
+}
+
+/**
+ * Validates the code points of [begin, end) which start before `limit`,
+ * moving `p` past them. Counts them in `length` and keeps the largest lead
+ * byte in `max_byte`.
+ */
+inline bool validate_until(const uint8_t *&p, const uint8_t *limit, const uint8_t *end, intptr_t &length,
+                           uint8_t &max_byte)
+{
+  uint32_t cp;
+  while (p < limit) {
+    max_byte = max(max_byte, *p);
+    if (!utf8_next(p, end, cp)) {
+      return false;
+    }
+    ++length;
+  }
+  return true;
+}
+
+inline void put(uint8_t *&out, uint32_t cp) { *out++ = static_cast<uint8_t>(cp); }
+
+inline void put(uint16_t *&out, uint32_t cp)
+{
+  if (cp < 0x10000) {
+    *out++ = static_cast<uint16_t>(cp);
+  }
+  else {
+    cp -= 0x10000;
+    *out++ = static_cast<uint16_t>(0xD800 | (cp >> 10));
+    *out++ = static_cast<uint16_t>(0xDC00 | (cp & 0x3FF));
+  }
+}
+
+inline void put(uint32_t *&out, uint32_t cp) { *out++ = cp; }
+
+/**
+ * Decodes the code points of valid UTF-8 text which start before `limit`,
+ * moving `p` past them. The text was validated, so only the lead bytes are
+ * checked.
+ */
+template <typename T>
+inline void decode_until(const uint8_t *&p, const uint8_t *limit, T *&out)
+{
+  while (p < limit) {
+    uint32_t c = p[0];
+    if (c < 0x80) {
+      put(out, c);
+      p += 1;
+    }
+    else if (c < 0xE0) {
+      put(out, ((c & 0x1F) << 6) | (p[1] & 0x3F));
+      p += 2;
+    }
+    else if (c < 0xF0) {
+      put(out, ((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F));
+      p += 3;
+    }
+    else {
+      put(out, ((c & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F));
+      p += 4;
+    }
+  }
+}
+
+intptr_t utf8_length_scalar(const uint8_t *p, const uint8_t *end, uint8_t &max_byte)
+{
+  intptr_t length = 0;
+  max_byte = 0;
+  return validate_until(p, end, end, length, max_byte) ? length : -1;
+}
+
+template <typename T>
+T *decode_scalar(const uint8_t *p, const uint8_t *end, T *out)
+{
+  decode_until(p, end, out);
+  return out;
+}
+
+template <typename T>
+intptr_t nul_length_scalar(const T *begin, const T *end)
+{
+  return find(begin, end, 0) - begin;
+}
+
+uint32_t utf16_bits_scalar(const uint16_t *p, const uint16_t *end, bool &surrogates)
+{
+  uint32_t bits = 0;
+  surrogates = false;
+  for (; p != end; ++p) {
+    bits |= *p;
+    surrogates |= (*p & 0xF800) == 0xD800;
+  }
+  return bits;
+}
+
+uint32_t utf32_bits_scalar(const uint32_t *p, const uint32_t *end, bool &valid)
+{
+  uint32_t bits = 0;
+  valid = true;
+  for (; p != end; ++p) {
+    bits |= *p;
+    valid &= *p <= 0x10FFFF && (*p & 0xFFFFF800) != 0xD800;
+  }
+  return bits;
+}
+
+template <typename Src, typename Dst>
+void narrow_scalar(const Src *p, const Src *end, Dst *out)
+{
+  while (p != end) {
+    *out++ = static_cast<Dst>(*p++);
+  }
+}
+
+#if PYDYND_X86
+
+// The SSE2 functions skip or widen blocks of 16 ASCII bytes at a time, and
+// handle the code points starting in the other blocks one at a time.
+
+intptr_t utf8_length_sse2(const uint8_t *p, const uint8_t *end, uint8_t &max_byte)
+{
+  intptr_t length = 0;
+  max_byte = 0;
+  while (end - p >= 16) {
+    if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) == 0) {
+      length += 16;
+      p += 16;
+    }
+    else if (!validate_until(p, p + 16, end, length, max_byte)) {
+      return -1;
+    }
+  }
+  return validate_until(p, end, end, length, max_byte) ? length : -1;
+}
+
+inline void widen_sse2(__m128i v, uint8_t *out) { _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v); }
+
+inline void widen_sse2(__m128i v, uint16_t *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi8(v, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpackhi_epi8(v, zero));
+}
+
+inline void widen_sse2(__m128i v, uint32_t *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(lo, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm_unpackhi_epi16(lo, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpacklo_epi16(hi, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(hi, zero));
+}
+
+template <typename T>
+T *decode_sse2(const uint8_t *p, const uint8_t *end, T *out)
+{
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    if (_mm_movemask_epi8(v) == 0) {
+      widen_sse2(v, out);
+      p += 16;
+      out += 16;
+    }
+    else {
+      decode_until(p, p + 16, out);
+    }
+  }
+  decode_until(p, end, out);
+  return out;
+}
+
+intptr_t utf16_nul_length_sse2(const uint16_t *begin, const uint16_t *end)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const uint16_t *p = begin;
+  for (; end - p >= 8; p += 8) {
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), zero));
+    if (mask != 0) {
+      return (p - begin) + pydynd::count_trailing_zeros(static_cast<uint32_t>(mask)) / 2;
+    }
+  }
+  return (p - begin) + nul_length_scalar(p, end);
+}
+
+intptr_t utf32_nul_length_sse2(const uint32_t *begin, const uint32_t *end)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const uint32_t *p = begin;
+  for (; end - p >= 4; p += 4) {
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), zero));
+    if (mask != 0) {
+      return (p - begin) + pydynd::count_trailing_zeros(static_cast<uint32_t>(mask)) / 4;
+    }
+  }
+  return (p - begin) + nul_length_scalar(p, end);
+}
+
+uint32_t horizontal_or_sse2(__m128i v)
+{
+  v = _mm_or_si128(v, _mm_srli_si128(v, 8));
+  v = _mm_or_si128(v, _mm_srli_si128(v, 4));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+uint32_t utf16_bits_sse2(const uint16_t *p, const uint16_t *end, bool &surrogates)
+{
+  const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+  const __m128i surrogate_range = _mm_set1_epi16(static_cast<short>(0xD800));
+  __m128i bits = _mm_setzero_si128(), found = _mm_setzero_si128();
+  for (; end - p >= 8; p += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    bits = _mm_or_si128(bits, v);
+    found = _mm_or_si128(found, _mm_cmpeq_epi16(_mm_and_si128(v, surrogate_mask), surrogate_range));
+  }
+  uint32_t tail_bits = utf16_bits_scalar(p, end, surrogates);
+  surrogates |= _mm_movemask_epi8(found) != 0;
+  return (horizontal_or_sse2(bits) & 0xFFFF) | (horizontal_or_sse2(bits) >> 16) | tail_bits;
+}
+
+uint32_t utf32_bits_sse2(const uint32_t *p, const uint32_t *end, bool &valid)
+{
+  const __m128i surrogate_mask = _mm_set1_epi32(static_cast<int>(0xFFFFF800));
+  const __m128i surrogate_range = _mm_set1_epi32(0xD800);
+  const __m128i max_plane = _mm_set1_epi32(0x10);
+  __m128i bits = _mm_setzero_si128(), invalid = _mm_setzero_si128();
+  for (; end - p >= 4; p += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    bits = _mm_or_si128(bits, v);
+    // The plane is compared instead of the code point, as SSE2 has no
+    // unsigned comparison
+    invalid = _mm_or_si128(invalid, _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(v, surrogate_mask), surrogate_range),
+                                                 _mm_cmpgt_epi32(_mm_srli_epi32(v, 16), max_plane)));
+  }
+  uint32_t tail_bits = utf32_bits_scalar(p, end, valid);
+  valid &= _mm_movemask_epi8(invalid) == 0;
+  return horizontal_or_sse2(bits) | tail_bits;
+}
+
+// The narrowing packs with signed saturation, which keeps the code points
+// below U+0100 as they are. For UCS-2 they are biased into the signed range
+// and back.
+
+void utf16_to_latin1_sse2(const uint16_t *p, const uint16_t *end, uint8_t *out)
+{
+  for (; end - p >= 16; p += 16, out += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(a, b));
+  }
+  narrow_scalar(p, end, out);
+}
+
+void utf32_to_latin1_sse2(const uint32_t *p, const uint32_t *end, uint8_t *out)
+{
+  for (; end - p >= 16; p += 16, out += 16) {
+    const __m128i *src = reinterpret_cast<const __m128i *>(p);
+    __m128i ab = _mm_packs_epi32(_mm_loadu_si128(src), _mm_loadu_si128(src + 1));
+    __m128i cd = _mm_packs_epi32(_mm_loadu_si128(src + 2), _mm_loadu_si128(src + 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(ab, cd));
+  }
+  narrow_scalar(p, end, out);
+}
+
+void utf32_to_ucs2_sse2(const uint32_t *p, const uint32_t *end, uint16_t *out)
+{
+  const __m128i bias32 = _mm_set1_epi32(0x8000), bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+  for (; end - p >= 8; p += 8, out += 8) {
+    __m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), bias32);
+    __m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 4)), bias32);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_add_epi16(_mm_packs_epi32(a, b), bias16));
+  }
+  narrow_scalar(p, end, out);
+}
+
+// The AVX2 validation checks 32 bytes at a time, with the lookup tables of
+// Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per
+// Byte". Each table maps a nibble of a byte, or of the byte before it, to
+// the errors its pair of bytes may be part of, and an error is a bit set in
+// all three.
+
+const uint8_t too_short = 1 << 0;      // a lead byte not followed by a continuation
+const uint8_t too_long = 1 << 1;       // an ASCII byte followed by a continuation
+const uint8_t overlong_3 = 1 << 2;     // 11100000 100_____
+const uint8_t too_large = 1 << 3;      // beyond U+10FFFF
+const uint8_t surrogate = 1 << 4;      // 11101101 101_____
+const uint8_t overlong_2 = 1 << 5;     // 1100000_ 10______
+const uint8_t too_large_1000 = 1 << 6; // beyond U+10FFFF, with 1000____ after the lead byte
+const uint8_t overlong_4 = 1 << 6;     // 11110000 1000____
+const uint8_t two_conts = 1 << 7;      // a continuation followed by a continuation
+const uint8_t carry = too_short | too_long | two_conts;
+
+const uint8_t byte_1_high_table[16] = {
+    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+    two_conts, two_conts, two_conts, two_conts,
+    too_short | overlong_2,
+    too_short,
+    too_short | overlong_3 | surrogate,
+    too_short | too_large | too_large_1000 | overlong_4};
+
+const uint8_t byte_1_low_table[16] = {
+    carry | overlong_3 | overlong_2 | overlong_4,
+    carry | overlong_2,
+    carry,
+    carry,
+    carry | too_large,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000};
+
+const uint8_t byte_2_high_table[16] = {
+    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_short, too_short, too_short, too_short};
+
+PYDYND_TARGET_AVX2 inline __m256i load_table_avx2(const uint8_t *table)
+{
+  return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table)));
+}
+
+/**
+ * The bytes of `v` shifted up by N, with the last N bytes of `prev` before
+ * them.
+ */
+template <int N>
+PYDYND_TARGET_AVX2 inline __m256i prev_bytes_avx2(__m256i v, __m256i prev)
+{
+  return _mm256_alignr_epi8(v, _mm256_permute2x128_si256(prev, v, 0x21), 16 - N);
+}
+
+PYDYND_TARGET_AVX2 inline __m256i high_nibbles_avx2(__m256i v)
+{
+  return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+PYDYND_TARGET_AVX2 intptr_t utf8_length_avx2(const uint8_t *p, const uint8_t *end, uint8_t &max_byte)
+{
+  const __m256i byte_1_high = load_table_avx2(byte_1_high_table);
+  const __m256i byte_1_low = load_table_avx2(byte_1_low_table);
+  const __m256i byte_2_high = load_table_avx2(byte_2_high_table);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  // Only the lead bytes of 3 and 4 byte sequences stay at or above 0x80
+  const __m256i third_byte = _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80));
+  const __m256i fourth_byte = _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80));
+  const __m256i high_bit = _mm256_set1_epi8(static_cast<char>(0x80));
+  // A lead byte at the end of a block whose sequence doesn't fit in it
+  const __m256i incomplete = _mm256_setr_epi8(
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+  // The bytes which aren't continuations compare greater as signed bytes
+  const __m256i last_continuation = _mm256_set1_epi8(static_cast<char>(0xBF));
+
+  __m256i prev = _mm256_setzero_si256(), prev_incomplete = _mm256_setzero_si256();
+  __m256i error = _mm256_setzero_si256(), max_bytes = _mm256_setzero_si256();
+  // The code points of the blocks with other than ASCII are counted per
+  // byte position, and summed before the counts can overflow
+  __m256i counts = _mm256_setzero_si256(), totals = _mm256_setzero_si256();
+  int counted_blocks = 0;
+  intptr_t length = 0;
+  uint8_t tail[32];
+  while (p != end) {
+    const uint8_t *block = p;
+    intptr_t size = end - p;
+    if (size < 32) {
+      // The zeros after the text are ASCII, which ends any sequence it
+      // truncates with an error
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, p, size);
+      block = tail;
+    }
+    else {
+      size = 32;
+    }
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+
+    if (_mm256_movemask_epi8(v) == 0) {
+      error = _mm256_or_si256(error, prev_incomplete);
+      prev_incomplete = _mm256_setzero_si256();
+      length += size;
+    }
+    else {
+      __m256i prev1 = prev_bytes_avx2<1>(v, prev);
+      __m256i special = _mm256_and_si256(
+          _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, high_nibbles_avx2(prev1)),
+                           _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, low_nibble))),
+          _mm256_shuffle_epi8(byte_2_high, high_nibbles_avx2(v)));
+      __m256i must_be_continuation =
+          _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(prev_bytes_avx2<2>(v, prev), third_byte),
+                                           _mm256_subs_epu8(prev_bytes_avx2<3>(v, prev), fourth_byte)),
+                           high_bit);
+      error = _mm256_or_si256(error, _mm256_xor_si256(must_be_continuation, special));
+      prev_incomplete = _mm256_subs_epu8(v, incomplete);
+      max_bytes = _mm256_max_epu8(max_bytes, v);
+      counts = _mm256_sub_epi8(counts, _mm256_cmpgt_epi8(v, last_continuation));
+      length -= 32 - size;
+      if (++counted_blocks == 255) {
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+        counts = _mm256_setzero_si256();
+        counted_blocks = 0;
+      }
+    }
+    prev = v;
+    p += size;
+  }
+  error = _mm256_or_si256(error, prev_incomplete);
+  if (!_mm256_testz_si256(error, error)) {
+    return -1;
+  }
+
+  totals = _mm256_add_epi64(totals, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  int64_t sums[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), totals);
+  uint8_t bytes[32];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(bytes), max_bytes);
+  max_byte = *max_element(bytes, bytes + 32);
+  return length + sums[0] + sums[1] + sums[2] + sums[3];
+}
+
+PYDYND_TARGET_AVX2 inline void widen_avx2(const uint8_t *p, uint8_t *out)
+{
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+
+PYDYND_TARGET_AVX2 inline void widen_avx2(const uint8_t *p, uint16_t *out)
+{
+  for (int i = 0; i < 2; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 16 * i),
+                        _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i))));
+  }
+}
+
+PYDYND_TARGET_AVX2 inline void widen_avx2(const uint8_t *p, uint32_t *out)
+{
+  for (int i = 0; i < 4; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8 * i),
+                        _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 8 * i))));
+  }
+}
+
+template <typename T>
+PYDYND_TARGET_AVX2 T *decode_avx2(const uint8_t *p, const uint8_t *end, T *out)
+{
+  while (end - p >= 32) {
+    if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))) == 0) {
+      widen_avx2(p, out);
+      p += 32;
+      out += 32;
+    }
+    else {
+      decode_until(p, p + 32, out);
+    }
+  }
+  decode_until(p, end, out);
+  return out;
+}
+
+#endif
+
+struct backend {
+  const char *name;
+  intptr_t (*utf8_length)(const uint8_t *p, const uint8_t *end, uint8_t &max_byte);
+  uint8_t *(*utf8_to_latin1)(const uint8_t *p, const uint8_t *end, uint8_t *out);
+  uint16_t *(*utf8_to_utf16)(const uint8_t *p, const uint8_t *end, uint16_t *out);
+  uint32_t *(*utf8_to_utf32)(const uint8_t *p, const uint8_t *end, uint32_t *out);
+  intptr_t (*utf16_nul_length)(const uint16_t *begin, const uint16_t *end);
+  intptr_t (*utf32_nul_length)(const uint32_t *begin, const uint32_t *end);
+  uint32_t (*utf16_bits)(const uint16_t *p, const uint16_t *end, bool &surrogates);
+  uint32_t (*utf32_bits)(const uint32_t *p, const uint32_t *end, bool &valid);
+  void (*utf16_to_latin1)(const uint16_t *p, const uint16_t *end, uint8_t *out);
+  void (*utf32_to_latin1)(const uint32_t *p, const uint32_t *end, uint8_t *out);
+  void (*utf32_to_ucs2)(const uint32_t *p, const uint32_t *end, uint16_t *out);
+};
+
+backend scalar_backend()
+{
+  backend b = {"scalar",
+               &utf8_length_scalar,
+               &decode_scalar<uint8_t>,
+               &decode_scalar<uint16_t>,
+               &decode_scalar<uint32_t>,
+               &nul_length_scalar<uint16_t>,
+               &nul_length_scalar<uint32_t>,
+               &utf16_bits_scalar,
+               &utf32_bits_scalar,
+               &narrow_scalar<uint16_t, uint8_t>,
+               &narrow_scalar<uint32_t, uint8_t>,
+               &narrow_scalar<uint32_t, uint16_t>};
+  return b;
+}
+
+#if PYDYND_X86
+
+backend sse2_backend()
+{
+  backend b = {"sse2",
+               &utf8_length_sse2,
+               &decode_sse2<uint8_t>,
+               &decode_sse2<uint16_t>,
+               &decode_sse2<uint32_t>,
+               &utf16_nul_length_sse2,
+               &utf32_nul_length_sse2,
+               &utf16_bits_sse2,
+               &utf32_bits_sse2,
+               &utf16_to_latin1_sse2,
+               &utf32_to_latin1_sse2,
+               &utf32_to_ucs2_sse2};
+  return b;
+}
+
+backend avx2_backend()
+{
+  // The UTF-16 and UTF-32 scans are bound by memory bandwidth already with
+  // SSE2, so only the UTF-8 functions have AVX2 versions
+  backend b = sse2_backend();
+  b.name = "avx2";
+  b.utf8_length = &utf8_length_avx2;
+  b.utf8_to_latin1 = &decode_avx2<uint8_t>;
+  b.utf8_to_utf16 = &decode_avx2<uint16_t>;
+  b.utf8_to_utf32 = &decode_avx2<uint32_t>;
+  return b;
+}
+
+#endif
+
+backend detect_backend()
+{
+#if PYDYND_X86
+  if (pydynd::cpu_has_avx2()) {
+    return avx2_backend();
+  }
+  // SSE2 is part of every x86-64 CPU
+  return sse2_backend();
+#else
+  return scalar_backend();
+#endif
+}
+
+backend &current_backend()
+{
+  static backend b = detect_backend();
+  return b;
+}
+
+#if PY_VERSION_HEX >= 0x03030000
+
+/**
+ * The largest code point of the narrowest Python string representation
+ * which holds code points whose bits are or-ed together in `bits`.
+ */
+Py_UCS4 max_char(uint32_t bits)
+{
+  return bits < 0x80 ? 0x7F : bits < 0x100 ? 0xFF : bits < 0x10000 ? 0xFFFF : 0x10FFFF;
+}
+
+#endif
+
+/**
+ * The byte order argument of Python's UTF-16 and UTF-32 codecs for the
+ * native byte order, with which a byte order mark at the start of the text
+ * is kept as a code point like any other.
+ */
+int native_byteorder()
+{
+  const uint16_t one = 1;
+  return *reinterpret_cast<const char *>(&one) == 1 ? -1 : 1;
+}
+
+} // anonymous namespace
+
+intptr_t pydynd::utf8_length(const char *begin, const char *end)
+{
+  uint8_t max_byte;
+  return current_backend().utf8_length(reinterpret_cast<const uint8_t *>(begin),
+                                       reinterpret_cast<const uint8_t *>(end), max_byte);
+}
+
+uint32_t *pydynd::utf8_to_utf32(const char *begin, const char *end, uint32_t *out)
+{
+  return current_backend().utf8_to_utf32(reinterpret_cast<const uint8_t *>(begin),
+                                         reinterpret_cast<const uint8_t *>(end), out);
+}
+
+uint16_t *pydynd::utf8_to_utf16(const char *begin, const char *end, uint16_t *out)
+{
+  return current_backend().utf8_to_utf16(reinterpret_cast<const uint8_t *>(begin),
+                                         reinterpret_cast<const uint8_t *>(end), out);
+}
+
+intptr_t pydynd::utf16_nul_length(const uint16_t *begin, const uint16_t *end)
+{
+  return current_backend().utf16_nul_length(begin, end);
+}
+
+intptr_t pydynd::utf32_nul_length(const uint32_t *begin, const uint32_t *end)
+{
+  return current_backend().utf32_nul_length(begin, end);
+}
+
+PyObject *pydynd::pyunicode_from_utf8(const char *begin, const char *end)
+{
+#if PY_VERSION_HEX >= 0x03030000
+  const backend &b = current_backend();
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(begin), *e = reinterpret_cast<const uint8_t *>(end);
+  uint8_t max_byte;
+  intptr_t length = b.utf8_length(p, e, max_byte);
+  if (length < 0) {
+    // Python's codec raises the error, with where it is
+    return PyUnicode_DecodeUTF8(begin, end - begin, NULL);
+  }
+
+  // The largest lead byte gives the range of the largest code point
+  PyObject *result =
+      PyUnicode_New(length, max_byte < 0x80 ? 0x7F : max_byte < 0xC4 ? 0xFF : max_byte < 0xF0 ? 0xFFFF : 0x10FFFF);
+  if (result == NULL) {
+    return NULL;
+  }
+  switch (PyUnicode_KIND(result)) {
+  case PyUnicode_1BYTE_KIND:
+    if (max_byte < 0x80) {
+      memcpy(PyUnicode_1BYTE_DATA(result), begin, length);
+    }
+    else {
+      b.utf8_to_latin1(p, e, PyUnicode_1BYTE_DATA(result));
+    }
+    break;
+  case PyUnicode_2BYTE_KIND:
+    // Without code points beyond U+FFFF, UTF-16 is UCS-2
+    b.utf8_to_utf16(p, e, reinterpret_cast<uint16_t *>(PyUnicode_2BYTE_DATA(result)));
+    break;
+  default:
+    b.utf8_to_utf32(p, e, reinterpret_cast<uint32_t *>(PyUnicode_4BYTE_DATA(result)));
+    break;
+  }
+  return result;
+#else
+  return PyUnicode_DecodeUTF8(begin, end - begin, NULL);
+#endif
+}
+
+PyObject *pydynd::pyunicode_from_utf16(const uint16_t *begin, const uint16_t *end)
+{
+  int byteorder = native_byteorder();
+#if PY_VERSION_HEX >= 0x03030000
+  const backend &b = current_backend();
+  bool surrogates;
+  uint32_t bits = b.utf16_bits(begin, end, surrogates);
+  if (!surrogates) {
+    PyObject *result = PyUnicode_New(end - begin, max_char(bits));
+    if (result == NULL) {
+      return NULL;
+    }
+    if (PyUnicode_KIND(result) == PyUnicode_1BYTE_KIND) {
+      b.utf16_to_latin1(begin, end, PyUnicode_1BYTE_DATA(result));
+    }
+    else {
+      memcpy(PyUnicode_2BYTE_DATA(result), begin, 2 * (end - begin));
+    }
+    return result;
+  }
+#endif
+  // Python's codec checks and combines the surrogate pairs
+  return PyUnicode_DecodeUTF16(reinterpret_cast<const char *>(begin), 2 * (end - begin), NULL, &byteorder);
+}
+
+PyObject *pydynd::pyunicode_from_utf32(const uint32_t *begin, const uint32_t *end)
+{
+  int byteorder = native_byteorder();
+#if PY_VERSION_HEX >= 0x03030000
+  const backend &b = current_backend();
+  bool valid;
+  uint32_t bits = b.utf32_bits(begin, end, valid);
+  if (valid) {
+    PyObject *result = PyUnicode_New(end - begin, max_char(bits));
+    if (result == NULL) {
+      return NULL;
+    }
+    switch (PyUnicode_KIND(result)) {
+    case PyUnicode_1BYTE_KIND:
+      b.utf32_to_latin1(begin, end, PyUnicode_1BYTE_DATA(result));
+      break;
+    case PyUnicode_2BYTE_KIND:
+      b.utf32_to_ucs2(begin, end, reinterpret_cast<uint16_t *>(PyUnicode_2BYTE_DATA(result)));
+      break;
+    default:
+      memcpy(PyUnicode_4BYTE_DATA(result), begin, 4 * (end - begin));
+      break;
+    }
+    return result;
+  }
+#endif
+  // Python's codec raises the error, with where it is
+  return PyUnicode_DecodeUTF32(reinterpret_cast<const char *>(begin), 4 * (end - begin), NULL, &byteorder);
+}
+
+const char *pydynd::utf8_backend() { return current_backend().name; }
+
+void pydynd::set_utf8_backend(const std::string &name)
+{
+  if (name.empty()) {
+    current_backend() = detect_backend();
+  }
+  else if (name == "scalar") {
+    current_backend() = scalar_backend();
+  }
+#if PYDYND_X86
+  else if (name == "sse2") {
+    current_backend() = sse2_backend();
+  }
+  else if (name == "avx2" && pydynd::cpu_has_avx2()) {
+    current_backend() = avx2_backend();
+  }
+#endif
+  else {
+    throw invalid_argument("the UTF-8 backend '" + name + "' is not available");
+  }
+}